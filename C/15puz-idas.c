@@ -8,12 +8,18 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "puzInput.h"
+#include "counters.h"
+
 #define PUZZLE_COLUMN 4
 #define PUZZLE_ROW 4
 #define PUZZLE_SIZE (PUZZLE_COLUMN * PUZZLE_ROW)
 #define PUZZLE_MIN 0
 #define PUZZLE_MAX PUZZLE_SIZE-1
 
+#define FALSE 0
+#define TRUE 1
+
 /////////////////////////////////////////////////////////////////////////////
 //
 //  Given a position, decode it into row and column.
@@ -317,16 +323,21 @@ int ExamineNode(int puzzle[PUZZLE_SIZE], int lookupTable[][PUZZLE_SIZE],
 //  Execute the IDA* algorithm on the given puzzle state with given lookup table
 //  for calculating heuristic.
 //
-int IDAStar(int puzzle[PUZZLE_SIZE], int lookupTable[][PUZZLE_SIZE])
+int IDAStar(int puzzle[PUZZLE_SIZE], int lookupTable[][PUZZLE_SIZE],
+  const PerfCounters *counters)
 {
   unsigned long long nodesTotal=0;
   unsigned long long nodesAtLimit = 0;
   int length = 0;
   int limit = CalculateValue(puzzle, lookupTable);
   int nextLimit = 999;
+  PerfSample searchStart, iterationStart, sample;
 
   int blankIndex = GetBlankPosition(puzzle);
 
+  PerfRead(counters, &searchStart);
+  iterationStart = searchStart;
+
   if (limit > 0)
   {
     while(0 == (length = ExamineNode(puzzle, lookupTable,
@@ -335,6 +346,9 @@ int IDAStar(int puzzle[PUZZLE_SIZE], int lookupTable[][PUZZLE_SIZE])
                       &nextLimit, &nodesAtLimit)))
     {
       printf("Limit: %d completed with %llu nodes\n", limit, nodesAtLimit);
+      PerfRead(counters, &sample);
+      PerfPrint(counters, "  per node", &iterationStart, &sample, nodesAtLimit);
+      iterationStart = sample;
       nodesTotal += nodesAtLimit;
       length = 0;
       nodesAtLimit = 0;
@@ -344,8 +358,11 @@ int IDAStar(int puzzle[PUZZLE_SIZE], int lookupTable[][PUZZLE_SIZE])
 
     nodesTotal += nodesAtLimit;
   }
+  PerfRead(counters, &sample);
 
   printf("\n\nSolution of length %d found after searching %llu nodes\n", length, nodesTotal);
+  PerfPrint(counters, "  last iteration per node", &iterationStart, &sample, nodesAtLimit);
+  PerfPrint(counters, "IDA* per node", &searchStart, &sample, nodesTotal);
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -460,46 +477,40 @@ int Valid(int* puzzle)
 
 /////////////////////////////////////////////////////////////////////////////
 //
-//  Read in puzzle state from user input
+//  Read in puzzle state from user input: the first puzzle on standard
+//  input, in any of the formats puzInput.h accepts, on one line or spread
+//  over several. Returns FALSE if there is no valid puzzle to solve,
+//  instead of asking again.
 //
 
-void ReadPuzzleFromInput(int* puzzle)
+int ReadPuzzleFromInput(int* puzzle)
 {
-  int i, j;
+  PuzzleInput input;
+  ParseStatus status;
 
-  // printf("15-Puzzle solver\n\n");
-  // printf("Here are the tile position indices:\n\n");
-  // printf("  0  1  2  3\n");
-  // printf("  4  5  6  7\n");
-  // printf("  8  9 10 11\n");
-  // printf(" 12 13 14 15\n\n");
-  // printf("The solution state, with the blank in the lower-right (position index 15), is represented by the sequence\n\n");
-  // printf("1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 0\n\n");
+  printf("Enter the starting configuration for the puzzle:\n");
+  fflush(stdout);
 
-  memset(puzzle, 0, sizeof(int)*PUZZLE_SIZE);
+  if (OpenPuzzleInput(&input, NULL) != 0)
+  {
+    printf("ERROR: %s\n", ParseStatusText(PARSE_READ_ERROR));
+    return FALSE;
+  }
+
+  status = NextPuzzleAcrossLines(&input, puzzle);
+  ClosePuzzleInput(&input);
 
-  do
+  if (status != PARSE_OK)
   {
-    printf("Enter the starting configuration for the puzzle:\n");
+    printf("ERROR: Line %d: %s\n", input.line, ParseStatusText(status));
+    return FALSE;
+  }
 
-    for(i = 0; i < PUZZLE_SIZE; i++)
-    {
-      j = scanf("%d", &puzzle[i]);
-      if(j==EOF)
-      {
-        break;
-      }
-      else if (j != 1)
-      {
-        printf("ERROR: Expected 1 input, got %d\n", j);
-      }
-    }
+  printf("\nThe input received were as follows:\n\n");
 
-    printf("\nThe input received were as follows:\n\n");
+  PrintPuzzle(puzzle);
 
-    PrintPuzzle(puzzle);
-  }
-  while(!Valid(puzzle));
+  return Valid(puzzle);
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -507,17 +518,40 @@ void ReadPuzzleFromInput(int* puzzle)
 //  Main
 //
 
-int main()
+int main(int argc, char *argv[])
 {
+  PerfCounters counterStore;
+  PerfCounters *counters = NULL;
   int puzzle[PUZZLE_SIZE];
   int mdLookup[PUZZLE_SIZE][PUZZLE_SIZE];
 
   GenerateManhattanDistanceLookup(mdLookup);
   // PrintLookupTable(mdLookup);
- 
-  ReadPuzzleFromInput(puzzle);
+
+  if (argc == 2 && strcmp(argv[1], "-counters") == 0)
+  {
+    if (PerfOpen(&counterStore, FALSE))
+    {
+      counters = &counterStore;
+    }
+  }
+  else if (argc > 1)
+  {
+    printf("Usage: %s [-counters]\n", argv[0]);
+    return 1;
+  }
+
+  if (!ReadPuzzleFromInput(puzzle))
+  {
+    return 1;
+  }
 
   printf("Initial Manhattan Distance value of %d\n\n", CalculateValue(puzzle, mdLookup));
 
-  IDAStar(puzzle, mdLookup);
+  IDAStar(puzzle, mdLookup, counters);
+
+  if (counters != NULL)
+  {
+    PerfClose(counters);
+  }
  }
\ No newline at end of file
@@ -0,0 +1,270 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Memory for an A* search: a node arena, a hash table of every board seen,
+//  and an open list bucketed by f.
+//
+//  IDA* keeps nothing between iterations, so it expands the upper levels of
+//  the tree again on every one. A* expands each board once, at the cost of
+//  keeping every board it has generated. For puzzles of medium length that
+//  is a few million boards, which fits easily. For the long ones it isn't,
+//  so the memory here is capped up front and the caller gives up on A*
+//  when the cap is reached.
+//
+//  * Nodes come out of an arena: fixed-size chunks allocated as needed and
+//    never freed one at a time, addressed by a 32-bit index. Nothing moves
+//    once allocated, so parent links stay valid, and the whole search is
+//    freed in one go.
+//  * The closed table maps a packed board (one tile per nibble, as in
+//    endgame.h) to the node holding its best path so far, by open
+//    addressing over node indices. It starts small and doubles whenever
+//    it gets half full. Sizing it for the cap up front would spread the
+//    first few thousand boards over a gigabyte of untouched pages.
+//  * The open list is a bucket per f value, each a stack linked through the
+//    nodes. f only ever takes small integer values, so picking the next
+//    node is a step along an array rather than a heap operation. Taking
+//    the newest node of the lowest bucket first favours the deepest nodes,
+//    which tend to reach the goal sooner among nodes of equal f.
+//
+#ifndef ASTAR_H
+#define ASTAR_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Nodes per arena chunk.
+#define ASTAR_CHUNK_BITS 16
+#define ASTAR_CHUNK_SIZE (1 << ASTAR_CHUNK_BITS)
+
+// f values run from 0 to below this. Longer than any optimal solution.
+#define ASTAR_MAX_F 128
+
+#define ASTAR_NONE UINT32_MAX
+
+// g of a node superseded by a shorter path to the same board.
+#define ASTAR_STALE UINT8_MAX
+
+typedef struct
+{
+  uint64_t board;             // Packed as it is.
+  uint64_t transposed;        // Packed across the diagonal (puzWD.c).
+  uint32_t parent;            // ASTAR_NONE for the starting board.
+  uint32_t next;              // Next node in the same open bucket.
+  int16_t idx1, idx2;         // Walking Distance table indices.
+  uint8_t inv1, inv2;         // Inversion counts.
+  uint8_t g;                  // Moves from the starting board.
+  uint8_t blank;              // Blank position.
+} AStarNode;
+
+typedef struct
+{
+  AStarNode **chunks;
+  uint32_t chunkCount;
+  uint32_t nodeCount;
+  uint32_t maxNodes;
+
+  uint32_t *closed;           // Node index + 1, 0 for an empty slot.
+  uint64_t closedMask;
+  uint64_t maxSlots;
+
+  uint32_t open[ASTAR_MAX_F]; // Stack of nodes at each f.
+  int lowestF;                // No open nodes below this f.
+} AStarMemory;
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Set up for at most memoryBytes. Each node is allowed its own size plus
+//  four closed table slots: the table is at most half full, and while it
+//  is being doubled the old and new tables are both allocated. Returns 0
+//  on success, -1 if even a small closed table can't be allocated.
+
+static int InitAStarMemory(AStarMemory *memory, size_t memoryBytes)
+{
+  uint64_t maxNodes = memoryBytes / (sizeof(AStarNode) + 4 * sizeof(uint32_t));
+  uint64_t slots = 1;
+
+  memset(memory, 0, sizeof(AStarMemory));
+
+  if (maxNodes >= ASTAR_NONE)
+  {
+    maxNodes = ASTAR_NONE - 1;
+  }
+  maxNodes &= ~(uint64_t)(ASTAR_CHUNK_SIZE - 1);
+  if (maxNodes == 0)
+  {
+    maxNodes = ASTAR_CHUNK_SIZE;
+  }
+
+  while (slots < maxNodes * 2)
+  {
+    slots <<= 1;
+  }
+  memory->maxSlots = slots;
+
+  slots = ASTAR_CHUNK_SIZE * 2;
+  memory->maxNodes = (uint32_t)maxNodes;
+  memory->chunks = calloc(maxNodes >> ASTAR_CHUNK_BITS, sizeof(AStarNode *));
+  memory->closed = calloc(slots, sizeof(uint32_t));
+  if (memory->chunks == NULL || memory->closed == NULL)
+  {
+    free(memory->chunks);
+    free(memory->closed);
+    return -1;
+  }
+  memory->closedMask = slots - 1;
+
+  for (int f = 0; f < ASTAR_MAX_F; f++)
+  {
+    memory->open[f] = ASTAR_NONE;
+  }
+
+  return 0;
+}
+
+static void FreeAStarMemory(AStarMemory *memory)
+{
+  for (uint32_t i = 0; i < memory->chunkCount; i++)
+  {
+    free(memory->chunks[i]);
+  }
+  free(memory->chunks);
+  free(memory->closed);
+  memory->chunks = NULL;
+  memory->closed = NULL;
+}
+
+static inline AStarNode *NodeAt(const AStarMemory *memory, uint32_t index)
+{
+  return &memory->chunks[index >> ASTAR_CHUNK_BITS][index & (ASTAR_CHUNK_SIZE-1)];
+}
+
+static inline uint64_t ClosedHash(const AStarMemory *memory, uint64_t board)
+{
+  return ((board * 0x9E3779B97F4A7C15ULL) >> 24) & memory->closedMask;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Double the closed table. Returns -1, leaving it as it was, if the
+//  memory isn't there.
+
+static int GrowClosedTable(AStarMemory *memory)
+{
+  uint64_t oldMask = memory->closedMask;
+  uint32_t *old = memory->closed;
+  uint64_t slot;
+
+  memory->closed = calloc((oldMask + 1) * 2, sizeof(uint32_t));
+  if (memory->closed == NULL)
+  {
+    memory->closed = old;
+    return -1;
+  }
+  memory->closedMask = oldMask * 2 + 1;
+
+  for (uint64_t i = 0; i <= oldMask; i++)
+  {
+    if (old[i] != 0)
+    {
+      slot = ClosedHash(memory, NodeAt(memory, old[i] - 1)->board);
+      while (memory->closed[slot] != 0)
+      {
+        slot = (slot + 1) & memory->closedMask;
+      }
+      memory->closed[slot] = old[i];
+    }
+  }
+
+  free(old);
+
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  A new node from the arena, or ASTAR_NONE once the cap is reached. Any
+//  closed table slot pointer held across this call is stale if it returns
+//  a node, since the table may have been doubled to make room.
+
+static uint32_t AllocateNode(AStarMemory *memory)
+{
+  if (memory->nodeCount == memory->maxNodes)
+  {
+    return ASTAR_NONE;
+  }
+
+  if ((uint64_t)memory->nodeCount * 2 >= memory->closedMask + 1 &&
+      (memory->closedMask + 1 >= memory->maxSlots || GrowClosedTable(memory) != 0))
+  {
+    return ASTAR_NONE;
+  }
+
+  if ((memory->nodeCount & (ASTAR_CHUNK_SIZE-1)) == 0)
+  {
+    memory->chunks[memory->chunkCount] = malloc(sizeof(AStarNode) * ASTAR_CHUNK_SIZE);
+    if (memory->chunks[memory->chunkCount] == NULL)
+    {
+      return ASTAR_NONE;
+    }
+    memory->chunkCount++;
+  }
+
+  return memory->nodeCount++;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  The closed table slot for a board: either the slot holding it, or the
+//  empty slot where it belongs.
+
+static inline uint32_t *ClosedSlot(const AStarMemory *memory, uint64_t board)
+{
+  uint64_t slot = ClosedHash(memory, board);
+
+  while (memory->closed[slot] != 0 &&
+         NodeAt(memory, memory->closed[slot] - 1)->board != board)
+  {
+    slot = (slot + 1) & memory->closedMask;
+  }
+
+  return &memory->closed[slot];
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Open list.
+
+static inline void PushOpen(AStarMemory *memory, uint32_t index, int f)
+{
+  NodeAt(memory, index)->next = memory->open[f];
+  memory->open[f] = index;
+
+  if (f < memory->lowestF)
+  {
+    memory->lowestF = f;
+  }
+}
+
+// The next node to expand and its f, or ASTAR_NONE if the list is empty.
+static inline uint32_t PopOpen(AStarMemory *memory, int *f)
+{
+  uint32_t index;
+
+  while (memory->lowestF < ASTAR_MAX_F && memory->open[memory->lowestF] == ASTAR_NONE)
+  {
+    memory->lowestF++;
+  }
+
+  if (memory->lowestF == ASTAR_MAX_F)
+  {
+    return ASTAR_NONE;
+  }
+
+  index = memory->open[memory->lowestF];
+  memory->open[memory->lowestF] = NodeAt(memory, index)->next;
+  *f = memory->lowestF;
+
+  return index;
+}
+
+#endif // ASTAR_H
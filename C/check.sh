@@ -0,0 +1,282 @@
+#!/bin/sh
+#############################################################################
+#
+#  Differential verification suite, run by make check.
+#
+#  Every engine is run on puzzles from puzGen, and their answers are checked
+#  against each other:
+#
+#    * Optimal lengths, for every engine and option.
+#    * Node counts of every completed IDA* iteration, between engines with
+#      the same heuristic: 15puz-idas, directionLookup, moveMask and puzPDB
+#      without tables (Manhattan Distance); puzWD, puzMT and puzDist (Walking
+#      Distance); puzPDB with the same tables as bytes and nibbles. A
+#      completed iteration visits the same tree whatever the move order, so
+#      these must match exactly. The last iteration stops at the first
+#      solution, so only the lengths are compared there.
+#    * Total node counts between puzWD's batch, -distance and -interleave
+#      runs, and puzMT's batch runs for the puzzles it doesn't split.
+#    * The moves printed, replayed from the solved state by puzCheck, and
+#      the moves in puzWD's binary results, replayed by puzDump.
+#    * puzWD's lengths for Korf's 100 instances, from puzGen -korf, against
+#      the published ones. With -quick, only the instances of 50 moves or
+#      less.
+#
+#  Then puzCheck fuzzes the input parser against a reference parser, and
+#  puzWD -selfcheck compares its incremental WDLNK and inversion updates
+#  with HeuristicLookupIndices after every move of random walks.
+#
+#  Usage: check.sh [-quick] [binDirectory [count]]
+#
+#  count is the number of puzzles for the batch engines, 2000 by default,
+#  or 200 with -quick. The engines that take one puzzle per run get a tenth
+#  of that.
+#
+#############################################################################
+
+DEFAULT_COUNT=2000
+KORF_LONGEST=80
+if [ "$1" = "-quick" ]; then
+  DEFAULT_COUNT=200
+  KORF_LONGEST=50
+  shift
+fi
+
+BIN=${1:-build/release}
+COUNT=${2:-$DEFAULT_COUNT}
+SINGLE=$((COUNT / 10))
+WORK=$(mktemp -d "${TMPDIR:-/tmp}/puzCheck.XXXXXX") || exit 1
+trap 'rm -rf "$WORK"' EXIT
+
+PASSED=0
+FAILED=0
+
+pass()
+{
+  echo "ok    $1"
+  PASSED=$((PASSED + 1))
+}
+
+fail()
+{
+  echo "FAIL  $1"
+  FAILED=$((FAILED + 1))
+}
+
+# check name expected actual: pass if the two files are the same.
+check()
+{
+  if [ -s "$2" ] && cmp -s "$2" "$3"; then
+    pass "$1"
+  else
+    fail "$1"
+    diff "$2" "$3" | head -6
+  fi
+}
+
+# run name command...: pass if the command succeeds, with its output shown.
+run()
+{
+  name=$1
+  shift
+  if "$@" > "$WORK/run.out" 2>&1; then
+    pass "$name: $(tail -1 "$WORK/run.out")"
+  else
+    fail "$name"
+    head -12 "$WORK/run.out"
+  fi
+}
+
+# The completed iterations and the length of every solve in a transcript.
+iterations()
+{
+  grep -E '^Limit: [0-9]+ completed with|^Solution of length' "$1" | sed 's/ found .*//'
+}
+
+# The length of every solve in a transcript.
+lengths()
+{
+  grep '^Solution of length' "$1" | sed 's/ found .*//'
+}
+
+# Run a program once per puzzle of a file, appending the transcripts.
+each()
+{
+  output=$1
+  shift
+  : > "$output"
+  grep -v '^#' "$PUZZLES" | while read -r line; do
+    echo "$line" | "$@" >> "$output" 2>&1
+  done
+}
+
+echo "Verification with $COUNT puzzles, binaries in $BIN"
+
+#############################################################################
+#
+#  Parser and incremental updates.
+
+run "parser fuzz" "$BIN/puzCheck" -parser $((COUNT * 50)) -seed 1
+run "incremental updates" "$BIN/puzWD" -selfcheck "$COUNT"
+
+#############################################################################
+#
+#  Manhattan Distance: one run per puzzle for the three small solvers.
+
+"$BIN/puzGen" -walk "$SINGLE" 30 -seed 2 > "$WORK/md.txt"
+PUZZLES=$WORK/md.txt
+
+each "$WORK/idas.out" "$BIN/15puz-idas"
+each "$WORK/direction.out" "$BIN/directionLookup"
+each "$WORK/mask.out" "$BIN/moveMask"
+"$BIN/puzPDB" -batch "$PUZZLES" > "$WORK/md-pdb.out"
+
+iterations "$WORK/idas.out" > "$WORK/md.ref"
+iterations "$WORK/direction.out" > "$WORK/md.direction"
+iterations "$WORK/mask.out" > "$WORK/md.mask"
+iterations "$WORK/md-pdb.out" > "$WORK/md.pdb"
+check "directionLookup iterations match 15puz-idas" "$WORK/md.ref" "$WORK/md.direction"
+check "moveMask iterations match 15puz-idas" "$WORK/md.ref" "$WORK/md.mask"
+check "puzPDB without tables matches 15puz-idas" "$WORK/md.ref" "$WORK/md.pdb"
+
+run "15puz-idas moves" "$BIN/puzCheck" -replay "$PUZZLES" "$WORK/idas.out"
+run "moveMask moves" "$BIN/puzCheck" -replay "$PUZZLES" "$WORK/mask.out"
+run "puzPDB without tables moves" "$BIN/puzCheck" -replay "$PUZZLES" "$WORK/md-pdb.out"
+
+#############################################################################
+#
+#  Walking Distance.
+
+"$BIN/puzGen" -walk "$COUNT" 40 -seed 3 > "$WORK/wd.txt"
+PUZZLES=$WORK/wd.txt
+
+"$BIN/puzWD" -batch "$PUZZLES" -binary "$WORK/wd.bin" > "$WORK/wd.out"
+lengths "$WORK/wd.out" > "$WORK/wd.lengths"
+run "puzWD moves" "$BIN/puzCheck" -replay "$PUZZLES" "$WORK/wd.out"
+
+if "$BIN/puzDump" "$WORK/wd.bin" > "$WORK/dump.out" && [ "$(grep -c . "$WORK/dump.out")" -eq "$COUNT" ] &&
+   ! grep -q 'does not solve' "$WORK/dump.out"; then
+  pass "puzWD binary results replay"
+else
+  fail "puzWD binary results replay"
+fi
+
+# Lines, lengths and node counts, as -distance prints them.
+awk '/^Puzzle on line/ { line = $4; sub(":", "", line) }
+     /^Solution of length/ { print "line", line, "distance", $4, "nodes", $8 }' "$WORK/wd.out" > "$WORK/wd.ref"
+sed 's/ nodes .*//' "$WORK/wd.ref" > "$WORK/wd.distances"
+
+distance()
+{
+  name=$1
+  shift
+  "$BIN/puzWD" -distance -batch "$PUZZLES" "$@" | grep '^line' | sed 's/ cached$//' > "$WORK/distance.out"
+  check "$name" "$WORK/wd.ref" "$WORK/distance.out"
+}
+
+distanceOnly()
+{
+  name=$1
+  shift
+  "$BIN/puzWD" -distance -batch "$PUZZLES" "$@" | grep '^line' | sed 's/ nodes .*//' > "$WORK/distance.out"
+  check "$name" "$WORK/wd.distances" "$WORK/distance.out"
+}
+
+distance "puzWD -distance matches -batch" -threads 3
+distance "puzWD -interleave matches -batch" -interleave 4
+distanceOnly "puzWD -epe lengths" -epe
+distanceOnly "puzWD -astar lengths" -astar 64
+distanceOnly "puzWD -endgame lengths" -endgame 14
+distanceOnly "puzWD -cache first run lengths" -cache "$WORK/cache"
+distanceOnly "puzWD -cache cached lengths" -cache "$WORK/cache"
+
+# puzMT's batch: lengths for all, node counts for the puzzles not split
+# across threads, whose last iteration stops wherever the first thread to
+# find a solution is.
+"$BIN/puzMT" -t 3 -batch "$PUZZLES" > "$WORK/mt.out"
+awk '/^Line/ { line = $2; sub(":", "", line); moves = $4; sub(",", "", moves)
+               print "line", line, "distance", moves, "nodes", (/split/ ? "split" : $5) }' \
+  "$WORK/mt.out" > "$WORK/mt.ref"
+awk 'NR == FNR { if ($6 == "split") splitLines[$2] = 1; next }
+     { if ($2 in splitLines) $6 = "split"; print }' "$WORK/mt.ref" "$WORK/wd.ref" > "$WORK/wd.mt"
+check "puzMT -batch matches puzWD" "$WORK/wd.mt" "$WORK/mt.ref"
+
+# One run per puzzle for the split searches.
+head -n "$SINGLE" "$WORK/wd.txt" > "$WORK/wd-single.txt"
+PUZZLES=$WORK/wd-single.txt
+each "$WORK/wd-single.out" "$BIN/puzWD"
+each "$WORK/mt-single.out" "$BIN/puzMT" -t 3 -d 4
+each "$WORK/dist-single.out" "$BIN/puzDist" -w 2
+iterations "$WORK/wd-single.out" > "$WORK/wd-single.ref"
+iterations "$WORK/mt-single.out" > "$WORK/wd-single.mt"
+iterations "$WORK/dist-single.out" > "$WORK/wd-single.dist"
+check "puzMT iterations match puzWD" "$WORK/wd-single.ref" "$WORK/wd-single.mt"
+check "puzDist iterations match puzWD" "$WORK/wd-single.ref" "$WORK/wd-single.dist"
+run "puzMT moves" "$BIN/puzCheck" -replay "$PUZZLES" "$WORK/mt-single.out"
+run "puzDist moves" "$BIN/puzCheck" -replay "$PUZZLES" "$WORK/dist-single.out"
+
+#############################################################################
+#
+#  Korf's 100 instances, solved to their published lengths.
+
+"$BIN/puzGen" -korf > "$WORK/korf.txt"
+"$BIN/puzGen" -korf -lengths | paste -d ' ' - "$WORK/korf.txt" |
+  awk -v longest="$KORF_LONGEST" '$1 <= longest' > "$WORK/korf.selected"
+cut -d ' ' -f 2- "$WORK/korf.selected" > "$WORK/korf-run.txt"
+awk '{ print "Solution of length", $1 }' "$WORK/korf.selected" > "$WORK/korf.ref"
+"$BIN/puzWD" -batch "$WORK/korf-run.txt" > "$WORK/korf.out"
+lengths "$WORK/korf.out" > "$WORK/korf.lengths"
+check "puzWD Korf instances at published lengths ($(grep -c . "$WORK/korf.ref"))" "$WORK/korf.ref" "$WORK/korf.lengths"
+
+#############################################################################
+#
+#  Pattern databases: five 3-tile tables, built in each encoding. The mod3
+#  tables know where the blank is, so they are stronger and only their
+#  lengths are compared.
+
+PUZZLES=$WORK/wd.txt
+for encoding in byte nibble mod3; do
+  for tiles in 1,2,3 4,5,6 7,8,9 10,11,12 13,14,15; do
+    "$BIN/pdbBuild" -tiles "$tiles" -encoding "$encoding" -o "$WORK/$encoding-$tiles" > /dev/null ||
+      fail "pdbBuild -tiles $tiles -encoding $encoding"
+  done
+done
+"$BIN/pdbBuild" -tiles 1,2,3 -compress 4 -o "$WORK/compressed" > /dev/null ||
+  fail "pdbBuild -compress 4"
+
+tables()
+{
+  for tiles in 1,2,3 4,5,6 7,8,9 10,11,12 13,14,15; do
+    printf ' -pdb %s' "$WORK/$1-$tiles"
+  done
+}
+
+pdb()
+{
+  name=$1
+  shift
+  "$BIN/puzPDB" -batch "$PUZZLES" "$@" > "$WORK/pdb.out"
+  lengths "$WORK/pdb.out" > "$WORK/pdb.lengths"
+  check "puzPDB $name lengths" "$WORK/wd.lengths" "$WORK/pdb.lengths"
+  if grep -q ERROR "$WORK/pdb.out"; then
+    fail "puzPDB $name: $(grep -m 1 ERROR "$WORK/pdb.out")"
+  fi
+  run "puzPDB $name moves" "$BIN/puzCheck" -replay "$PUZZLES" "$WORK/pdb.out"
+}
+
+pdb "byte" $(tables byte)
+iterations "$WORK/pdb.out" > "$WORK/pdb.ref"
+pdb "nibble" $(tables nibble)
+iterations "$WORK/pdb.out" > "$WORK/pdb.nibble"
+check "puzPDB nibble iterations match byte" "$WORK/pdb.ref" "$WORK/pdb.nibble"
+pdb "mod3" $(tables mod3)
+pdb "-compress 4" -pdb "$WORK/compressed" $(tables byte | sed 's/^ -pdb [^ ]*//')
+pdb "-epe" $(tables byte) -epe
+pdb "-reflect" $(tables byte) -reflect
+pdb "-dual" $(tables byte) -dual
+pdb "-dualsearch" $(tables byte) -dualsearch
+
+echo
+echo "$PASSED passed, $FAILED failed"
+
+[ "$FAILED" -eq 0 ]
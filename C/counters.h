@@ -0,0 +1,221 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Hardware performance counters, read through Linux perf_event_open, so a
+//  solver can print what each node costs next to its iteration counts:
+//  time, cycles, instructions, L1 data cache misses, last level cache
+//  misses, branch misses and data TLB misses.
+//
+//  Only user space is counted, for the calling thread. With inherit set,
+//  threads it starts later are counted too. Their counts are added in when
+//  they exit, so they must be joined before a read. Each event is opened on
+//  its own, so a CPU or VM missing one still reports the rest. When there
+//  are more events than counter registers, the kernel takes turns with them,
+//  and each value is scaled up by the share of the time it ran, as perf
+//  does.
+//
+//  Containers often block perf_event_open, and VMs often don't pass the
+//  hardware events through. PerfOpen says which events it couldn't open and
+//  why, and carries on with the rest. If it opens none, it returns FALSE
+//  and the search runs without counters. PerfRead and PerfPrint do nothing
+//  when given NULL, so the calls can stay in the code.
+//
+//  Usage:
+//    PerfSample begin, end;
+//    PerfRead(counters, &begin);
+//    ...
+//    PerfRead(counters, &end);
+//    PerfPrint(counters, "  per node", &begin, &end, nodes);
+//
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+#define PERF_EVENTS 7
+
+typedef struct
+{
+  int fd[PERF_EVENTS];          // -1 for an event that isn't open.
+  int opened;
+} PerfCounters;
+
+typedef struct
+{
+  double value[PERF_EVENTS];
+} PerfSample;
+
+// As printed. The task clock comes first, in nanoseconds.
+static const char *const perfEventNames[PERF_EVENTS] =
+{
+  "ns", "cycles", "instructions", "L1D misses", "LLC misses", "branch misses", "dTLB misses"
+};
+
+#define PERF_TASK_CLOCK 0
+#define PERF_CYCLES 1
+#define PERF_INSTRUCTIONS 2
+
+#ifdef __linux__
+
+#define PERF_CACHE_MISS(cache) \
+  ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+static const struct { uint32_t type; uint64_t config; } perfEvents[PERF_EVENTS] =
+{
+  { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK },
+  { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+  { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+  { PERF_TYPE_HW_CACHE, PERF_CACHE_MISS(PERF_COUNT_HW_CACHE_L1D) },
+  { PERF_TYPE_HW_CACHE, PERF_CACHE_MISS(PERF_COUNT_HW_CACHE_LL) },
+  { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+  { PERF_TYPE_HW_CACHE, PERF_CACHE_MISS(PERF_COUNT_HW_CACHE_DTLB) },
+};
+
+#endif
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Open every event that can be, counting from now, and print a line
+//  naming any that can't. Returns FALSE if none could be opened.
+
+static int PerfOpen(PerfCounters *counters, int inherit)
+{
+  int error = ENOSYS;
+  int missing = 0;
+
+  counters->opened = 0;
+
+  for (int i = 0; i < PERF_EVENTS; i++)
+  {
+    counters->fd[i] = -1;
+
+#ifdef __linux__
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = perfEvents[i].type;
+    attr.config = perfEvents[i].config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.inherit = inherit ? 1 : 0;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    counters->fd[i] = (int)syscall(SYS_perf_event_open, &attr, 0 /* this thread */,
+                        -1 /* any CPU */, -1 /* no group */, 0);
+    if (counters->fd[i] < 0)
+    {
+      error = errno;
+    }
+#endif
+
+    if (counters->fd[i] >= 0)
+    {
+      counters->opened++;
+    }
+  }
+
+  if (counters->opened == 0)
+  {
+    printf("Counters: unavailable (%s), searching without them\n", strerror(error));
+    return 0;
+  }
+
+  if (counters->opened < PERF_EVENTS)
+  {
+    printf("Counters:");
+    for (int i = 0; i < PERF_EVENTS; i++)
+    {
+      if (counters->fd[i] < 0)
+      {
+        printf("%s %s", missing++ ? "," : "", perfEventNames[i]);
+      }
+    }
+    printf(" unavailable (%s)\n", strerror(error));
+  }
+
+  return 1;
+}
+
+static void PerfClose(PerfCounters *counters)
+{
+  for (int i = 0; i < PERF_EVENTS; i++)
+  {
+    if (counters->fd[i] >= 0)
+    {
+      close(counters->fd[i]);
+      counters->fd[i] = -1;
+    }
+  }
+  counters->opened = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Current totals, scaled for the time each event was actually counted.
+//  All zero without counters.
+
+static void PerfRead(const PerfCounters *counters, PerfSample *sample)
+{
+  uint64_t data[3];             // Value, time enabled, time running.
+
+  memset(sample, 0, sizeof(*sample));
+  if (counters == NULL)
+  {
+    return;
+  }
+
+  for (int i = 0; i < PERF_EVENTS; i++)
+  {
+    if (counters->fd[i] >= 0 && read(counters->fd[i], data, sizeof(data)) == sizeof(data) &&
+        data[2] > 0)
+    {
+      sample->value[i] = (double)data[0] * ((double)data[1] / data[2]);
+    }
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Print the open events' counts between two samples, divided by the nodes
+//  searched, after the label. Prints nothing for no nodes.
+
+static void PerfPrint(const PerfCounters *counters, const char *label,
+  const PerfSample *begin, const PerfSample *end, unsigned long long nodes)
+{
+  const char *separator = " ";
+
+  if (counters == NULL || nodes == 0)
+  {
+    return;
+  }
+
+  printf("%s:", label);
+  for (int i = 0; i < PERF_EVENTS; i++)
+  {
+    if (counters->fd[i] >= 0)
+    {
+      printf("%s%.*f %s", separator, i <= PERF_INSTRUCTIONS ? 1 : 3,
+        (end->value[i] - begin->value[i]) / nodes, perfEventNames[i]);
+      separator = ", ";
+    }
+  }
+
+  if (counters->fd[PERF_CYCLES] >= 0 && counters->fd[PERF_INSTRUCTIONS] >= 0 &&
+      end->value[PERF_CYCLES] > begin->value[PERF_CYCLES])
+  {
+    printf(", %.2f IPC", (end->value[PERF_INSTRUCTIONS] - begin->value[PERF_INSTRUCTIONS]) /
+                         (end->value[PERF_CYCLES] - begin->value[PERF_CYCLES]));
+  }
+  printf("\n");
+}
+
+#endif // COUNTERS_H
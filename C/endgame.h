@@ -0,0 +1,331 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Endgame table: the exact distance to the goal of every state within a
+//  few moves of it.
+//
+//  Every IDA* iteration walks the last several moves before the goal over
+//  and over. With the states near the goal precomputed, the search can stop
+//  as soon as it reaches one of them: the stored distance is exact, so if it
+//  fits within the limit the rest of the solution is read straight out of
+//  the table, and if it doesn't the node is cut off with a sharper bound
+//  than Walking Distance gives. A state that isn't in the table is further
+//  away than the table's depth, which is a lower bound too.
+//
+//  States are boards packed one tile per nibble (position i in bits 4i to
+//  4i+3), in an open addressing hash table with a byte of distance per slot.
+//  The table is filled by a breadth-first search out from the goal, one
+//  level at a time, growing as it goes, and stops at the requested depth or
+//  when the next level won't fit in the memory allowed, whichever comes
+//  first. Levels that were
+//  only partly added still hold exact distances, but only the complete ones
+//  count toward the depth used for the lower bound.
+//
+//  Once built the table is only read, so any number of search threads can
+//  share one.
+//
+#ifndef ENDGAME_H
+#define ENDGAME_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ENDGAME_WIDTH 4
+#define ENDGAME_SIZE (ENDGAME_WIDTH * ENDGAME_WIDTH)
+
+// Fraction of slots that may be filled, in 1/256ths. Linear probing slows
+// down sharply past about three quarters full.
+#define ENDGAME_MAX_LOAD 192
+
+// Bytes per slot: the packed board and its distance.
+#define ENDGAME_SLOT_BYTES (sizeof(uint64_t) + sizeof(uint8_t))
+
+typedef struct
+{
+  uint64_t *boards;           // Packed boards, 0 for an empty slot.
+  uint8_t *distances;
+  uint64_t mask;              // Slot count - 1. Slot count is a power of 2.
+  uint64_t count;
+  int depth;                  // Every state this close to the goal is here.
+} EndgameTable;
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Board packing. A real board never packs to zero, since only one tile is
+//  a blank, so zero marks an empty slot.
+
+static inline uint64_t PackBoard(const int *puzzle)
+{
+  uint64_t packed = 0;
+
+  for (int i = ENDGAME_SIZE-1; i >= 0; i--)
+  {
+    packed = (packed << 4) | (uint64_t)puzzle[i];
+  }
+
+  return packed;
+}
+
+static inline int PackedTile(uint64_t packed, int position)
+{
+  return (int)((packed >> (position * 4)) & 0xF);
+}
+
+// The packed board after the tile at 'from' slides into the blank at 'to'.
+static inline uint64_t PackedMove(uint64_t packed, int from, int to)
+{
+  uint64_t tile = (packed >> (from * 4)) & 0xF;
+
+  return packed - (tile << (from * 4)) + (tile << (to * 4));
+}
+
+static inline uint64_t EndgameSlot(const EndgameTable *table, uint64_t packed)
+{
+  return ((packed * 0x9E3779B97F4A7C15ULL) >> 20) & table->mask;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Exact distance of a packed board to the goal, or -1 if it isn't in the
+//  table.
+
+static inline int EndgameDistance(const EndgameTable *table, uint64_t packed)
+{
+  uint64_t slot = EndgameSlot(table, packed);
+
+  while (table->boards[slot] != 0)
+  {
+    if (table->boards[slot] == packed)
+    {
+      return table->distances[slot];
+    }
+    slot = (slot + 1) & table->mask;
+  }
+
+  return -1;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Lower bound for a state known not to be in the table. It is more than
+//  depth moves away, and every move shifts the blank by one square, so the
+//  distance has the same parity as the blank's distance from its home in
+//  the bottom right corner.
+
+static inline int EndgameBound(const EndgameTable *table, int blankIndex)
+{
+  int bound = table->depth + 1;
+  int blankParity = (ENDGAME_WIDTH-1 - blankIndex % ENDGAME_WIDTH) +
+                    (ENDGAME_WIDTH-1 - blankIndex / ENDGAME_WIDTH);
+
+  return ((bound ^ blankParity) & 1) ? bound + 1 : bound;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Add a board to the table if it isn't there already. Returns 1 if added,
+//  0 if already present, -1 if the table is as full as it is allowed to be.
+
+static int EndgameInsert(EndgameTable *table, uint64_t packed, int distance)
+{
+  uint64_t slot = EndgameSlot(table, packed);
+
+  while (table->boards[slot] != 0)
+  {
+    if (table->boards[slot] == packed)
+    {
+      return 0;
+    }
+    slot = (slot + 1) & table->mask;
+  }
+
+  if (table->count >= ((table->mask + 1) / 256) * ENDGAME_MAX_LOAD)
+  {
+    return -1;
+  }
+
+  table->boards[slot] = packed;
+  table->distances[slot] = (uint8_t)distance;
+  table->count++;
+
+  return 1;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Move everything into a table of twice the size. Returns -1, leaving the
+//  table as it was, if the memory isn't there.
+
+static int GrowEndgameTable(EndgameTable *table)
+{
+  EndgameTable grown;
+  uint64_t slots = (table->mask + 1) * 2;
+
+  memset(&grown, 0, sizeof(grown));
+  grown.boards = calloc(slots, sizeof(uint64_t));
+  grown.distances = malloc(slots);
+  if (grown.boards == NULL || grown.distances == NULL)
+  {
+    free(grown.boards);
+    free(grown.distances);
+    return -1;
+  }
+  grown.mask = slots - 1;
+  grown.depth = table->depth;
+
+  for (uint64_t slot = 0; slot <= table->mask; slot++)
+  {
+    if (table->boards[slot] != 0)
+    {
+      EndgameInsert(&grown, table->boards[slot], table->distances[slot]);
+    }
+  }
+
+  free(table->boards);
+  free(table->distances);
+  *table = grown;
+
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Build the table out to maxDepth moves from the goal, in at most
+//  memoryBytes. Each level is expanded by scanning the table for the states
+//  of the level before, so no frontier lists are needed. Before each level
+//  the table is doubled until it has room for three new states per state in
+//  the level before (each state has at most three neighbours that aren't
+//  its parent), as far as memoryBytes allows. Returns 0 on success, -1 if
+//  even a minimal table can't be allocated.
+
+static int BuildEndgameTable(EndgameTable *table, int maxDepth, size_t memoryBytes)
+{
+  static const int offsets[4] = { -ENDGAME_WIDTH, ENDGAME_WIDTH, -1, 1 };
+  uint64_t slots = 1 << 16;
+  uint64_t levelCount = 1;
+  uint64_t countBefore;
+  uint64_t packed;
+  int goal[ENDGAME_SIZE];
+  int blank, child, full = 0;
+
+  memset(table, 0, sizeof(EndgameTable));
+
+  table->boards = calloc(slots, sizeof(uint64_t));
+  table->distances = malloc(slots);
+  if (table->boards == NULL || table->distances == NULL)
+  {
+    free(table->boards);
+    free(table->distances);
+    return -1;
+  }
+  table->mask = slots - 1;
+
+  for (int i = 0; i < ENDGAME_SIZE; i++)
+  {
+    goal[i] = (i+1) % ENDGAME_SIZE;
+  }
+  EndgameInsert(table, PackBoard(goal), 0);
+
+  for (int depth = 0; depth < maxDepth && !full; depth++)
+  {
+    while ((table->count + levelCount * 3) * 256 > (table->mask + 1) * ENDGAME_MAX_LOAD &&
+           (table->mask + 1) * 2 * ENDGAME_SLOT_BYTES <= memoryBytes &&
+           GrowEndgameTable(table) == 0);
+
+    countBefore = table->count;
+
+    for (uint64_t slot = 0; slot <= table->mask && !full; slot++)
+    {
+      if (table->boards[slot] == 0 || table->distances[slot] != depth)
+      {
+        continue;
+      }
+
+      packed = table->boards[slot];
+      for (blank = 0; PackedTile(packed, blank) != 0; blank++);
+
+      for (int i = 0; i < 4; i++)
+      {
+        child = blank + offsets[i];
+
+        if (child < 0 || child >= ENDGAME_SIZE ||
+            (i >= 2 && child / ENDGAME_WIDTH != blank / ENDGAME_WIDTH))
+        {
+          continue;
+        }
+
+        if (EndgameInsert(table, PackedMove(packed, child, blank), depth+1) < 0)
+        {
+          full = 1;
+        }
+      }
+    }
+
+    levelCount = table->count - countBefore;
+    if (!full)
+    {
+      table->depth = depth+1;
+    }
+  }
+
+  return 0;
+}
+
+static void FreeEndgameTable(EndgameTable *table)
+{
+  free(table->boards);
+  free(table->distances);
+  table->boards = NULL;
+  table->distances = NULL;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Read the rest of the solution out of the table for a board that is in
+//  it: at each step move to a neighbour one closer to the goal. Fills in the
+//  blank direction of each move (MOVE_UP etc. in puzResult.h order) and, if
+//  tiles isn't NULL, the tile moved. Returns the number of moves.
+
+static int EndgamePath(const EndgameTable *table, uint64_t packed,
+  char *directions, char *tiles)
+{
+  static const int offsets[4] = { -ENDGAME_WIDTH, ENDGAME_WIDTH, -1, 1 };
+  int distance = EndgameDistance(table, packed);
+  int blank, child, i;
+  uint64_t next = packed;
+
+  for (blank = 0; PackedTile(packed, blank) != 0; blank++);
+
+  for (int step = 0; step < distance; step++)
+  {
+    for (i = 0; i < 4; i++)
+    {
+      child = blank + offsets[i];
+
+      if (child < 0 || child >= ENDGAME_SIZE ||
+          (i >= 2 && child / ENDGAME_WIDTH != blank / ENDGAME_WIDTH))
+      {
+        continue;
+      }
+
+      next = PackedMove(packed, child, blank);
+      if (EndgameDistance(table, next) == distance - step - 1)
+      {
+        break;
+      }
+    }
+
+    directions[step] = (char)i;
+    if (tiles != NULL)
+    {
+      tiles[step] = (char)PackedTile(packed, child);
+    }
+
+    packed = next;
+    blank = child;
+  }
+
+  return distance;
+}
+
+#endif // ENDGAME_H
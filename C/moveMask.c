@@ -0,0 +1,448 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Sliding tile puzzle solver using IDA* search with the Manhattan Distance
+//  heuristic, generating moves from a bitmask per blank position.
+//
+//  The third take on move generation, after the if/else chain in
+//  15puz-idas.c and the table of destinations in directionLookup.c. Each
+//  blank position has a 4-bit mask of the directions it can move in. The
+//  move that would undo the parent's move is masked out before the loop
+//  starts, so the loop visits only real children: count trailing zeros for
+//  the next direction, clear that bit, repeat. Directions are visited in the
+//  same order as the other two programs, so node counts are identical.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "puzInput.h"
+#include "counters.h"
+
+#define PUZZLE_COLUMN 4
+#define PUZZLE_ROW 4
+#define PUZZLE_SIZE (PUZZLE_COLUMN * PUZZLE_ROW)
+#define PUZZLE_MIN 0
+#define PUZZLE_MAX PUZZLE_SIZE-1
+
+#define FALSE 0
+#define TRUE 1
+
+// Blank move directions, in the order they are tried, and the bit of each
+// in a move mask. Opposite directions differ only in the lowest bit.
+#define DIR_UP 0
+#define DIR_DN 1
+#define DIR_LT 2
+#define DIR_RT 3
+#define DIRECTIONS 4
+
+#define REVERSE(direction) ((direction) ^ 1)
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Given a position, decode it into row and column.
+//
+void GetColumnRow(int position, int *column, int *row)
+{
+  *column = position % PUZZLE_COLUMN;
+  *row = position / PUZZLE_COLUMN;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Simple linear search to find the location of the blank (zero) tile
+//
+int GetBlankPosition(int puzzle[PUZZLE_SIZE])
+{
+    int indexBlank = -1;
+
+    for(int i = 0; i < PUZZLE_SIZE && indexBlank == -1; i++)
+    {
+      if (puzzle[i] == 0)
+      {
+        indexBlank = i;
+      }
+    }
+
+    if (indexBlank==-1)
+    {
+      printf("ERROR: Blank tile not found\n");
+    }
+
+    return indexBlank;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Fill in the mask of legal blank moves for each position, and the change
+//  in blank position for each direction.
+
+void GenerateMoveMaskLookup(unsigned int moveMask[PUZZLE_SIZE], int moveOffset[DIRECTIONS])
+{
+  int row=0, col=0;
+
+  for (int position = 0; position < PUZZLE_SIZE; position++)
+  {
+    GetColumnRow(position, &col, &row);
+
+    moveMask[position] = 0;
+    if (row > 0)
+    {
+      moveMask[position] |= 1 << DIR_UP;
+    }
+    if (row < PUZZLE_ROW-1)
+    {
+      moveMask[position] |= 1 << DIR_DN;
+    }
+    if (col > 0)
+    {
+      moveMask[position] |= 1 << DIR_LT;
+    }
+    if (col < PUZZLE_COLUMN-1)
+    {
+      moveMask[position] |= 1 << DIR_RT;
+    }
+  }
+
+  moveOffset[DIR_UP] = -PUZZLE_COLUMN;
+  moveOffset[DIR_DN] = PUZZLE_COLUMN;
+  moveOffset[DIR_LT] = -1;
+  moveOffset[DIR_RT] = 1;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Given a lookup table of int[PUZZLE_SIZE][PUZZLE_SIZE], fill in values for
+//  Manhattan Distance lookup. The format of the lookup table is:
+//
+//  First index: The tile number. 
+//  Second index: The position of the tile.
+//  Value: Manhattan Distance for that tile.
+
+void GenerateManhattanDistanceLookup(int lookupTable[][PUZZLE_SIZE])
+{
+  int currentTile = 0;
+  int currentPosition = 0;
+  int currentColumn = 0;
+  int currentRow = 0;
+  int desiredPosition = 0;
+  int desiredColumn = 0;
+  int desiredRow = 0;
+  int distance = 0;
+
+  printf("\nGenerating Manhattan Distance lookup table\n");
+
+  for (currentTile = 0; currentTile < PUZZLE_SIZE; currentTile++)
+  {
+    if (currentTile == 0)
+    {
+      desiredPosition = PUZZLE_SIZE-1;
+    }
+    else
+    {
+      desiredPosition = currentTile-1;
+    }
+
+    GetColumnRow(desiredPosition, &desiredColumn, &desiredRow);
+
+    for (currentPosition = 0; currentPosition < PUZZLE_SIZE; currentPosition++)
+    {
+      if (currentTile == 0)
+      {
+        distance = 0;
+      }
+      else
+      {
+        GetColumnRow(currentPosition, &currentColumn, &currentRow);
+
+        distance = abs(desiredColumn - currentColumn) + abs(desiredRow - currentRow);
+      }
+
+      lookupTable[currentTile][currentPosition] = distance;
+    }
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Print the lookup table to stdout
+//
+
+void PrintLookupTable(int lookupTable[][PUZZLE_SIZE])
+{
+  int printColumn = 0,
+      printRow = 0,
+      tableColumn = 0,
+      tableRow = 0,
+      tileIndex = 0,
+      tableIndex = 0;
+
+  printf("\nThe lookup table is as follows:\n");
+
+  for (printRow = 0; printRow < PUZZLE_ROW; printRow++)
+  {
+    for (tableRow = 0; tableRow < PUZZLE_ROW; tableRow++)
+    {
+      for (printColumn = 0; printColumn < PUZZLE_COLUMN; printColumn++)
+      {
+        tileIndex = (printRow*PUZZLE_COLUMN) + printColumn;
+        for (tableColumn = 0; tableColumn < PUZZLE_COLUMN; tableColumn++)
+        {
+          tableIndex = (tableRow*PUZZLE_COLUMN) + tableColumn;
+          printf("%2d", lookupTable[tileIndex][tableIndex]);
+        }
+        printf("  ");
+      }
+      printf("\n");
+    }
+    printf("\n\n");
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Print the puzzle state to stdout
+
+void PrintPuzzle(int puzzle[PUZZLE_SIZE])
+{
+    for(int i = 0; i < PUZZLE_ROW; i++) 
+    {
+      for (int j = 0; j < PUZZLE_COLUMN; j++)
+      {
+        printf("%3d", puzzle[(i*PUZZLE_COLUMN) + j]);
+      }
+      printf("\n");
+    }
+
+    printf("\n");
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Calculate value of given puzzle, using the given lookup table
+
+int CalculateValue(int* puzzle, int lookupTable[][PUZZLE_SIZE])
+{
+  int sum = 0;
+
+  for(int i = 0; i < PUZZLE_SIZE; i++)
+  {
+    sum += lookupTable[puzzle[i]][i];
+  }
+
+  return sum;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Examine a node and recursively call self to search deeper in the tree.
+//  excludeMask holds the bit of the move that would undo the parent's move.
+
+int ExamineNode(int puzzle[PUZZLE_SIZE], int lookupTable[][PUZZLE_SIZE],
+  const unsigned int moveMask[PUZZLE_SIZE], const int moveOffset[DIRECTIONS],
+  int currentBlankIndex, unsigned int excludeMask,
+  int currentLength, int limitLength, int *nextLimit, unsigned long long *nodeCounter)
+{
+  int val = CalculateValue(puzzle, lookupTable);
+
+  (*nodeCounter)++;
+
+  if (((*nodeCounter) % 1000000000) == 0)
+  {
+    // Status update every billion nodes
+    printf("Limit: %d ongoing - with %llu nodes\n", limitLength, *nodeCounter);
+  }
+
+  if(puzzle[currentBlankIndex]!=0)
+  {
+    printf("ERROR: Blank index is not blank.\n");
+  }
+
+  if (val == 0)
+  {
+    // Problem solved!
+    printf("\nTile movements to arrive in this state:\n");
+    return currentLength;
+  }
+  else if (currentLength + val > limitLength)
+  {
+    // Exceeded limit
+    if (*nextLimit > currentLength+val)
+    {
+      // Nominate our length+heuristic value as next highest limit
+      *nextLimit = currentLength+val;
+    }
+    return 0;
+  }
+  else
+  {
+    // Not terminating, so let's dig deeper
+    unsigned int moves = moveMask[currentBlankIndex] & ~excludeMask;
+    int ret=0, childBlankIndex=0, direction;
+
+    while (moves != 0)
+    {
+      // Take the lowest remaining direction
+      direction = __builtin_ctz(moves);
+      moves &= moves - 1;
+
+      childBlankIndex = currentBlankIndex + moveOffset[direction];
+
+      // Perform the swap
+      puzzle[currentBlankIndex] = puzzle[childBlankIndex];
+      puzzle[childBlankIndex] = 0;
+
+      // Recursive call to look at the next node
+      ret = ExamineNode(puzzle, lookupTable, moveMask, moveOffset,
+        childBlankIndex, 1U << REVERSE(direction),
+        currentLength+1, limitLength, nextLimit, nodeCounter);
+
+      // Revert the swap
+      puzzle[childBlankIndex] = puzzle[currentBlankIndex];
+      puzzle[currentBlankIndex] = 0;
+
+      // Did the child find anything?
+      if (ret != 0)
+      {
+        printf(" %d", puzzle[childBlankIndex]);
+        return ret;
+      }
+    }
+
+    // None of the directions proved fruitful
+    return 0;
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Execute the IDA* algorithm on the given puzzle state with given lookup table
+//  for calculating heuristic.
+//
+void IDAStar(int puzzle[PUZZLE_SIZE], int lookupTable[][PUZZLE_SIZE],
+  const unsigned int moveMask[PUZZLE_SIZE], const int moveOffset[DIRECTIONS],
+  const PerfCounters *counters)
+{
+  unsigned long long nodesTotal=0;
+  unsigned long long nodesAtLimit = 0;
+  int length = 0;
+  int limit = CalculateValue(puzzle, lookupTable);
+  int nextLimit = 999;
+  PerfSample searchStart, iterationStart, sample;
+
+  int blankIndex = GetBlankPosition(puzzle);
+
+  PerfRead(counters, &searchStart);
+  iterationStart = searchStart;
+
+  if (limit > 0)
+  {
+    while(0 == (length = ExamineNode(puzzle, lookupTable, moveMask, moveOffset,
+                      blankIndex, 0 /* Nothing to exclude */,
+                      0 /* Starting length */, limit, 
+                      &nextLimit, &nodesAtLimit)))
+    {
+      printf("Limit: %d completed with %llu nodes\n", limit, nodesAtLimit);
+      PerfRead(counters, &sample);
+      PerfPrint(counters, "  per node", &iterationStart, &sample, nodesAtLimit);
+      iterationStart = sample;
+      nodesTotal += nodesAtLimit;
+      length = 0;
+      nodesAtLimit = 0;
+      limit = nextLimit;
+      nextLimit = 999;
+    }
+
+    nodesTotal += nodesAtLimit;
+  }
+  PerfRead(counters, &sample);
+
+  printf("\n\nSolution of length %d found after searching %llu nodes\n", length, nodesTotal);
+  PerfPrint(counters, "  last iteration per node", &iterationStart, &sample, nodesAtLimit);
+  PerfPrint(counters, "IDA* per node", &searchStart, &sample, nodesTotal);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Read in puzzle state from user input: the first puzzle on standard
+//  input, in any of the formats puzInput.h accepts, on one line or spread
+//  over several. Returns FALSE if there is no valid puzzle to solve,
+//  instead of asking again.
+//
+
+int ReadPuzzleFromInput(int* puzzle)
+{
+  PuzzleInput input;
+  ParseStatus status;
+
+  printf("Enter the starting configuration for the puzzle:\n");
+  fflush(stdout);
+
+  if (OpenPuzzleInput(&input, NULL) != 0)
+  {
+    printf("ERROR: %s\n", ParseStatusText(PARSE_READ_ERROR));
+    return FALSE;
+  }
+
+  status = NextPuzzleAcrossLines(&input, puzzle);
+  ClosePuzzleInput(&input);
+
+  if (status != PARSE_OK)
+  {
+    printf("ERROR: Line %d: %s\n", input.line, ParseStatusText(status));
+    return FALSE;
+  }
+
+  printf("\nThe input received were as follows:\n\n");
+
+  PrintPuzzle(puzzle);
+
+  return TRUE;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Main
+//
+
+int main(int argc, char *argv[])
+{
+  PerfCounters counterStore;
+  PerfCounters *counters = NULL;
+  int puzzle[PUZZLE_SIZE];
+  int mdLookup[PUZZLE_SIZE][PUZZLE_SIZE];
+  unsigned int moveMask[PUZZLE_SIZE];
+  int moveOffset[DIRECTIONS];
+
+  GenerateMoveMaskLookup(moveMask, moveOffset);
+  GenerateManhattanDistanceLookup(mdLookup);
+  // PrintLookupTable(mdLookup);
+
+  if (argc == 2 && strcmp(argv[1], "-counters") == 0)
+  {
+    if (PerfOpen(&counterStore, FALSE))
+    {
+      counters = &counterStore;
+    }
+  }
+  else if (argc > 1)
+  {
+    printf("Usage: %s [-counters]\n", argv[0]);
+    return 1;
+  }
+
+  if (!ReadPuzzleFromInput(puzzle))
+  {
+    return 1;
+  }
+
+  printf("Initial Manhattan Distance value of %d\n\n", CalculateValue(puzzle, mdLookup));
+
+  IDAStar(puzzle, mdLookup, moveMask, moveOffset, counters);
+
+  if (counters != NULL)
+  {
+    PerfClose(counters);
+  }
+ }
\ No newline at end of file
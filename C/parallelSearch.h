@@ -0,0 +1,172 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Lock-free signalling shared by the threads of a parallel IDA* search.
+//
+//  The hot loop of ExamineNode must never write to a cache line that another
+//  thread is also writing, or the line bounces between cores on every node.
+//  So:
+//  * Each thread counts nodes in its own counter, padded out to a full cache
+//    line. Only the owning thread writes it. Totals are summed on demand.
+//  * The "solution found" flag is a single atomic holding the shortest
+//    solution length found so far. It is written once per solution and only
+//    read by the search threads, every SIGNAL_POLL_MASK+1 nodes.
+//  * The next IDA* threshold is reduced with an atomic minimum, once per
+//    work unit rather than once per node.
+//
+#ifndef PARALLEL_SEARCH_H
+#define PARALLEL_SEARCH_H
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#define CACHE_LINE_SIZE 64
+
+// Search threads check the shared solution flag when the low bits of their
+// node count are all zero. 4096 nodes is a few tens of microseconds.
+#define SIGNAL_POLL_MASK 0xFFF
+
+// Value of solutionLength and nextLimit when nothing has been recorded.
+#define NOTHING_RECORDED INT_MAX
+
+// Node counter owned by a single thread, alone on its cache line.
+typedef struct
+{
+  _Alignas(CACHE_LINE_SIZE) _Atomic unsigned long long nodes;
+} ThreadCounter;
+
+// State shared by all threads searching the same IDA* iteration.
+typedef struct
+{
+  _Alignas(CACHE_LINE_SIZE) _Atomic int solutionLength;
+  _Alignas(CACHE_LINE_SIZE) _Atomic int nextLimit;
+  ThreadCounter *counters;
+  int threadCount;
+} SharedSearchState;
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Allocate shared state and one padded counter per thread.
+
+static SharedSearchState *CreateSharedSearchState(int threadCount)
+{
+  SharedSearchState *state = aligned_alloc(CACHE_LINE_SIZE, sizeof(SharedSearchState));
+
+  if (state == NULL)
+  {
+    return NULL;
+  }
+
+  state->counters = aligned_alloc(CACHE_LINE_SIZE, sizeof(ThreadCounter)*threadCount);
+  if (state->counters == NULL)
+  {
+    free(state);
+    return NULL;
+  }
+
+  state->threadCount = threadCount;
+  for (int i = 0; i < threadCount; i++)
+  {
+    atomic_init(&state->counters[i].nodes, 0);
+  }
+  atomic_init(&state->solutionLength, NOTHING_RECORDED);
+  atomic_init(&state->nextLimit, NOTHING_RECORDED);
+
+  return state;
+}
+
+static void FreeSharedSearchState(SharedSearchState *state)
+{
+  if (state != NULL)
+  {
+    free(state->counters);
+    free(state);
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Reset between iterations. Only call while no search thread is running.
+
+static void ResetSharedSearchState(SharedSearchState *state)
+{
+  for (int i = 0; i < state->threadCount; i++)
+  {
+    atomic_store_explicit(&state->counters[i].nodes, 0, memory_order_relaxed);
+  }
+  atomic_store(&state->solutionLength, NOTHING_RECORDED);
+  atomic_store(&state->nextLimit, NOTHING_RECORDED);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Count one node. There is a single writer per counter, so a relaxed load
+//  and store is enough - no locked read-modify-write in the hot loop.
+//  Returns the new count so the caller can decide when to poll.
+
+static inline unsigned long long CountNode(ThreadCounter *counter)
+{
+  unsigned long long nodes = atomic_load_explicit(&counter->nodes, memory_order_relaxed) + 1;
+
+  atomic_store_explicit(&counter->nodes, nodes, memory_order_relaxed);
+
+  return nodes;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Sum of all per-thread counters. Approximate while threads are running,
+//  exact once they have all stopped.
+
+static unsigned long long AggregateNodeCount(SharedSearchState *state)
+{
+  unsigned long long total = 0;
+
+  for (int i = 0; i < state->threadCount; i++)
+  {
+    total += atomic_load_explicit(&state->counters[i].nodes, memory_order_relaxed);
+  }
+
+  return total;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Atomic minimum of the next IDA* threshold across all threads.
+
+static void NominateNextLimit(SharedSearchState *state, int limit)
+{
+  int current = atomic_load_explicit(&state->nextLimit, memory_order_relaxed);
+
+  while (limit < current &&
+         !atomic_compare_exchange_weak(&state->nextLimit, &current, limit))
+  {
+    // current was reloaded by the failed exchange, try again.
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Record a solution. Returns TRUE for exactly one caller per iteration:
+//  the first one to get there, who then owns publishing the solution moves.
+//  (Every solution found within one IDA* limit has the same, optimal, length
+//  so it doesn't matter which thread wins.)
+
+static int RecordSolution(SharedSearchState *state, int length)
+{
+  int expected = NOTHING_RECORDED;
+
+  return atomic_compare_exchange_strong(&state->solutionLength, &expected, length);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Cheap poll: has any thread found a solution no longer than limit?
+
+static inline int SolutionFoundWithin(SharedSearchState *state, int limit)
+{
+  return atomic_load_explicit(&state->solutionLength, memory_order_relaxed) <= limit;
+}
+
+#endif // PARALLEL_SEARCH_H
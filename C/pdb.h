@@ -0,0 +1,424 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Additive pattern databases: file format, loading and lookup.
+//
+//  A pattern is a set of up to PDB_MAX_TILES tiles. Its database holds, for
+//  every placement of those tiles on the board, the fewest moves of pattern
+//  tiles needed to bring them all home, with the other tiles treated as
+//  indistinguishable and their moves not counted. Because only the
+//  pattern's own moves are counted, the values of disjoint patterns can be
+//  added and still never overestimate, which is what makes a 6-6-3 or 7-8
+//  split of the 15 tiles so much stronger than Manhattan Distance.
+//
+//  Entries are indexed by the lexicographic partial rank (permRank.h) of
+//  the pattern tiles' positions, in the order the tiles are listed. The
+//  goal is the solver's: tile t at position t-1, the blank at the end.
+//
+//  A table can be stored in one of three encodings:
+//
+//  * PDB_ENCODING_BYTE: the value, one byte per placement.
+//  * PDB_ENCODING_NIBBLE: four bits per placement, holding how far the
+//    value is above the Manhattan Distance of the pattern's tiles, in
+//    steps of two. Every pattern move changes that distance by one, so the
+//    value always has the same parity, and the step is never odd. The
+//    caller keeps the distance up to date as tiles move. Anything above 15
+//    steps is stored as 15, which can only underestimate.
+//  * PDB_ENCODING_MOD3: two bits per state, the value mod 3. Here a state
+//    is the placement plus the blank's position, with no minimum taken over
+//    the blank. That table is bigger, but a move changes its value by at
+//    most one: moving a tile outside the pattern leaves it the same, and
+//    moving a pattern tile takes it one up or one down. Knowing the parent
+//    value, the residue says which. Taking the minimum over the blank loses
+//    that, since a move that walls the blank in can jump it by 3 or more.
+//    The starting value comes from a walk down to the goal (Mod3Value).
+//
+//  The byte and nibble encodings can also be min-compressed: each entry
+//  covers 2^compressionShift consecutive ranks and holds the least of
+//  their values (or steps). That still never overestimates, and a table
+//  compressed by 2 is half the size. Consecutive ranks differ only in the
+//  position of the last tile listed.
+//
+//  A file is a PdbFileHeader followed by the packed entries. pdbBuild.c
+//  writes them, and puzPDB.c loads them.
+//
+#ifndef PDB_H
+#define PDB_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "permRank.h"
+
+#define PDB_WIDTH 4
+#define PDB_SIZE (PDB_WIDTH * PDB_WIDTH)
+
+#define PDB_MAX_TILES 8
+
+#define PDB_MAGIC "PUZPDB"
+#define PDB_VERSION 2
+
+#define PDB_ENCODING_BYTE 0
+#define PDB_ENCODING_NIBBLE 1
+#define PDB_ENCODING_MOD3 2
+
+// Largest nibble entry, and largest compression shift.
+#define PDB_NIBBLE_MAX 15
+#define PDB_MAX_COMPRESSION_SHIFT 4
+
+typedef struct
+{
+  char magic[8];              // PDB_MAGIC, NUL terminated.
+  uint32_t version;           // PDB_VERSION
+  uint32_t tileCount;
+  uint8_t tiles[PDB_MAX_TILES];
+  uint32_t encoding;          // PDB_ENCODING_*
+  uint32_t compressionShift;  // log2 of ranks per entry.
+  uint64_t entryCount;        // PdbEntryCount(...)
+  uint64_t dataBytes;         // Bytes of entries after the header.
+} PdbFileHeader;
+
+typedef struct
+{
+  int tileCount;
+  int tiles[PDB_MAX_TILES];
+  int encoding;
+  int compressionShift;
+  uint64_t entryCount;
+  uint64_t dataBytes;
+  uint8_t *entries;
+} PatternDatabase;
+
+static inline const char *PdbEncodingName(int encoding)
+{
+  switch (encoding)
+  {
+    case PDB_ENCODING_BYTE:   return "byte";
+    case PDB_ENCODING_NIBBLE: return "nibble";
+    case PDB_ENCODING_MOD3:   return "mod3";
+  }
+
+  return "unknown";
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Table sizes.
+
+static inline uint64_t PdbEntryCount(int tileCount, int encoding, int compressionShift)
+{
+  if (encoding == PDB_ENCODING_MOD3)
+  {
+    return PartialCount(PDB_SIZE, tileCount + 1);
+  }
+
+  return (PartialCount(PDB_SIZE, tileCount) + (1ULL << compressionShift) - 1) >> compressionShift;
+}
+
+static inline uint64_t PdbDataBytes(int encoding, uint64_t entryCount)
+{
+  switch (encoding)
+  {
+    case PDB_ENCODING_NIBBLE: return (entryCount + 1) / 2;
+    case PDB_ENCODING_MOD3:   return (entryCount + 3) / 4;
+  }
+
+  return entryCount;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Index of the entry for the current board, given where every tile is
+//  (position[tile], with position[0] the blank).
+
+static inline uint64_t PatternIndex(const PatternDatabase *pdb, const int *position)
+{
+  int values[PDB_MAX_TILES + 1];
+  int count = pdb->tileCount;
+
+  for (int i = 0; i < count; i++)
+  {
+    values[i] = position[pdb->tiles[i]];
+  }
+
+  if (pdb->encoding == PDB_ENCODING_MOD3)
+  {
+    values[count++] = position[0];
+  }
+
+  return PartialRank(values, PDB_SIZE, count) >> pdb->compressionShift;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Raw stored entries: the value, the step count or the residue,
+//  depending on the encoding.
+
+static inline int PatternEntry(const PatternDatabase *pdb, uint64_t index)
+{
+  switch (pdb->encoding)
+  {
+    case PDB_ENCODING_NIBBLE:
+      return (pdb->entries[index >> 1] >> ((index & 1) * 4)) & 0xF;
+
+    case PDB_ENCODING_MOD3:
+      return (pdb->entries[index >> 2] >> ((index & 3) * 2)) & 0x3;
+  }
+
+  return pdb->entries[index];
+}
+
+// entries must start out zeroed.
+static inline void SetPatternEntry(PatternDatabase *pdb, uint64_t index, int entry)
+{
+  switch (pdb->encoding)
+  {
+    case PDB_ENCODING_NIBBLE:
+      pdb->entries[index >> 1] |= (uint8_t)(entry << ((index & 1) * 4));
+      break;
+
+    case PDB_ENCODING_MOD3:
+      pdb->entries[index >> 2] |= (uint8_t)(entry << ((index & 3) * 2));
+      break;
+
+    default:
+      pdb->entries[index] = (uint8_t)entry;
+      break;
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Value of a mod 3 entry reached by moving a pattern tile, from the value
+//  before the move. The two candidates are one apart on either side, so
+//  they always have different residues.
+
+static inline int DecodeMod3(int parentValue, int residue)
+{
+  return ((parentValue + 2) % 3 == residue) ? parentValue - 1 : parentValue + 1;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Exact value of a mod 3 table for a board, found by walking down to the
+//  goal one step at a time. A state with value v above 0 can always reach
+//  one with value v-1 by moving the blank around outside the pattern, for
+//  free, then moving one pattern tile. Its residue tells it apart from any
+//  v+1 neighbour. The number of steps to the goal is the value. Returns -1
+//  if no step down turns up, which means a damaged table.
+
+static inline int Mod3Value(const PatternDatabase *pdb, const int *position)
+{
+  int values[PDB_MAX_TILES + 1];
+  int k = pdb->tileCount;
+  int value = 0;
+
+  for (int i = 0; i < k; i++)
+  {
+    values[i] = position[pdb->tiles[i]];
+  }
+  values[k] = position[0];
+
+  for (;;)
+  {
+    unsigned int occupied = 0, reached, frontier;
+    int home = 1, residue, found = 0;
+
+    for (int i = 0; i < k; i++)
+    {
+      occupied |= 1U << values[i];
+      home &= (values[i] == pdb->tiles[i] - 1);
+    }
+
+    // Every cell the blank can get to without moving a pattern tile.
+    reached = frontier = 1U << values[k];
+    while (frontier != 0)
+    {
+      unsigned int spread = ((frontier << PDB_WIDTH) | (frontier >> PDB_WIDTH) |
+                             ((frontier << 1) & 0xEEEEU) | ((frontier >> 1) & 0x7777U)) & 0xFFFFU;
+
+      frontier = spread & ~occupied & ~reached;
+      reached |= frontier;
+    }
+
+    if (home && (reached & (1U << (PDB_SIZE - 1))))
+    {
+      return value;
+    }
+
+    residue = PatternEntry(pdb, PartialRank(values, PDB_SIZE, k + 1));
+
+    for (int i = 0; i < k && !found; i++)
+    {
+      int cell = values[i];
+      int row = cell / PDB_WIDTH, col = cell % PDB_WIDTH;
+      int targets[4] = { row > 0 ? cell - PDB_WIDTH : -1,
+                         row < PDB_WIDTH-1 ? cell + PDB_WIDTH : -1,
+                         col > 0 ? cell - 1 : -1,
+                         col < PDB_WIDTH-1 ? cell + 1 : -1 };
+
+      for (int d = 0; d < 4 && !found; d++)
+      {
+        if (targets[d] < 0 || !(reached & (1U << targets[d])))
+        {
+          continue;
+        }
+
+        values[i] = targets[d];
+        values[k] = cell;
+        if (PatternEntry(pdb, PartialRank(values, PDB_SIZE, k + 1)) == (residue + 2) % 3)
+        {
+          found = 1;
+        }
+        else
+        {
+          values[i] = cell;
+        }
+      }
+    }
+
+    if (!found)
+    {
+      return -1;
+    }
+    value++;
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Write a database. The file is replaced by rename so an interrupted
+//  write leaves the old one intact. Returns 0 on success, -1 on failure.
+
+static inline int SavePatternDatabase(const char *path, const PatternDatabase *pdb)
+{
+  PdbFileHeader header;
+  char tempPath[4096];
+  FILE *file;
+  int result = 0;
+
+  memset(&header, 0, sizeof(header));
+  strcpy(header.magic, PDB_MAGIC);
+  header.version = PDB_VERSION;
+  header.tileCount = (uint32_t)pdb->tileCount;
+  for (int i = 0; i < pdb->tileCount; i++)
+  {
+    header.tiles[i] = (uint8_t)pdb->tiles[i];
+  }
+  header.encoding = (uint32_t)pdb->encoding;
+  header.compressionShift = (uint32_t)pdb->compressionShift;
+  header.entryCount = pdb->entryCount;
+  header.dataBytes = pdb->dataBytes;
+
+  snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+
+  file = fopen(tempPath, "wb");
+  if (file == NULL ||
+      fwrite(&header, sizeof(header), 1, file) != 1 ||
+      fwrite(pdb->entries, 1, header.dataBytes, file) != header.dataBytes)
+  {
+    result = -1;
+  }
+
+  if (file != NULL && fclose(file) != 0)
+  {
+    result = -1;
+  }
+
+  if (result == 0 && rename(tempPath, path) != 0)
+  {
+    result = -1;
+  }
+
+  return result;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Whether a header's tiles are 1 to 15 with none repeated, the same rule
+//  pdbBuild applies to -tiles. The tiles index board-sized arrays, so a
+//  damaged or foreign file must not get past this.
+
+static inline int PdbHeaderTilesValid(const PdbFileHeader *header)
+{
+  unsigned int used = 0;
+
+  for (uint32_t i = 0; i < header->tileCount; i++)
+  {
+    int tile = header->tiles[i];
+
+    if (tile < 1 || tile > PDB_SIZE-1 || (used & (1U << tile)))
+    {
+      return 0;
+    }
+    used |= 1U << tile;
+  }
+
+  return 1;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Read a database written by SavePatternDatabase. Returns 0 on success, -1
+//  if the file can't be read or isn't a database.
+
+static inline int LoadPatternDatabase(const char *path, PatternDatabase *pdb)
+{
+  PdbFileHeader header;
+  FILE *file = fopen(path, "rb");
+  int result = -1;
+
+  memset(pdb, 0, sizeof(PatternDatabase));
+
+  if (file == NULL)
+  {
+    return -1;
+  }
+
+  if (fread(&header, sizeof(header), 1, file) == 1 &&
+      memcmp(header.magic, PDB_MAGIC, sizeof(PDB_MAGIC)) == 0 &&
+      header.version == PDB_VERSION &&
+      header.tileCount >= 1 && header.tileCount <= PDB_MAX_TILES &&
+      PdbHeaderTilesValid(&header) &&
+      header.encoding <= PDB_ENCODING_MOD3 &&
+      header.compressionShift <= PDB_MAX_COMPRESSION_SHIFT &&
+      (header.encoding != PDB_ENCODING_MOD3 || header.compressionShift == 0) &&
+      header.entryCount == PdbEntryCount(header.tileCount, header.encoding, header.compressionShift) &&
+      header.dataBytes == PdbDataBytes(header.encoding, header.entryCount))
+  {
+    pdb->tileCount = (int)header.tileCount;
+    for (int i = 0; i < pdb->tileCount; i++)
+    {
+      pdb->tiles[i] = header.tiles[i];
+    }
+    pdb->encoding = (int)header.encoding;
+    pdb->compressionShift = (int)header.compressionShift;
+    pdb->entryCount = header.entryCount;
+    pdb->dataBytes = header.dataBytes;
+    pdb->entries = malloc(header.dataBytes);
+
+    if (pdb->entries != NULL &&
+        fread(pdb->entries, 1, header.dataBytes, file) == header.dataBytes)
+    {
+      result = 0;
+    }
+    else
+    {
+      free(pdb->entries);
+      pdb->entries = NULL;
+    }
+  }
+
+  fclose(file);
+
+  return result;
+}
+
+static void FreePatternDatabase(PatternDatabase *pdb)
+{
+  free(pdb->entries);
+  pdb->entries = NULL;
+}
+
+#endif // PDB_H
@@ -0,0 +1,739 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Builds an additive pattern database (pdb.h) with several threads.
+//
+//  The search runs outward from the goal over abstract states: where the
+//  pattern's tiles are, plus where the blank is. All the other tiles look
+//  alike. The blank moving into a cell of one of those costs nothing,
+//  since only the pattern's moves are counted, and swapping with a pattern
+//  tile costs one. So this is a 0-1 breadth-first search, done level by
+//  level: each level is repeated over the states its free moves reach
+//  until there are none left, and its costly moves make up the next level.
+//
+//  Every state has one byte in a depth array, indexed by the partial rank
+//  of the pattern tiles' positions followed by the blank's. A state's depth
+//  is only ever lowered, with a compare-and-swap, and whichever thread
+//  lowers it is the one that queues it. So no state is queued twice for the
+//  same depth, and there are no locks around the array. The frontier lists
+//  are chunks of ranks. Each thread fills its own chunks and takes the
+//  list's lock only to hand over a full one. Threads take whole chunks of
+//  the current list to work on, through an atomic index.
+//
+//  At the end, each placement of the pattern's tiles gets the least depth
+//  over all the blank positions, which is the value the solver needs. The
+//  blank comes last in the rank, so those are consecutive entries.
+//
+//  Usage: pdbBuild -tiles 1,2,5,6,9,13 -o file [-t threads]
+//                  [-encoding byte|nibble|mod3] [-compress ranks] [-trace file]
+//
+//  The encodings and compression are described in pdb.h. For mod3 the
+//  depth array is written as it is, without the minimum over the blank.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "pdb.h"
+#include "trace.h"
+
+#define FALSE 0
+#define TRUE 1
+
+#define MAX_THREADS 64
+
+// Ranks per frontier chunk.
+#define FRONTIER_CHUNK 4096
+
+// Depth of a state not reached yet.
+#define UNSEEN 0xFF
+
+typedef struct
+{
+  unsigned int count;
+  unsigned int ranks[FRONTIER_CHUNK];
+} FrontierChunk;
+
+typedef struct
+{
+  FrontierChunk **chunks;
+  size_t count;
+  size_t capacity;
+  pthread_mutex_t lock;
+} Frontier;
+
+typedef struct
+{
+  int tileCount;              // Pattern tiles, not counting the blank.
+  atomic_uchar *depth;
+  int level;
+
+  Frontier *current;
+  Frontier *sameLevel;        // Reached by free moves.
+  Frontier *nextLevel;        // Reached by moving a pattern tile.
+  atomic_size_t nextChunk;    // Next chunk of current to hand out.
+} BuildState;
+
+typedef struct
+{
+  BuildState *build;
+  int index;                  // Thread number, and its trace slot.
+  FrontierChunk *same;        // Chunks being filled by this thread.
+  FrontierChunk *next;
+  unsigned long long expanded;
+} BuildThread;
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Frontier lists.
+
+static void InitFrontier(Frontier *frontier)
+{
+  memset(frontier, 0, sizeof(Frontier));
+  pthread_mutex_init(&frontier->lock, NULL);
+}
+
+static void AddChunk(Frontier *frontier, FrontierChunk *chunk)
+{
+  pthread_mutex_lock(&frontier->lock);
+
+  if (frontier->count == frontier->capacity)
+  {
+    frontier->capacity = frontier->capacity ? frontier->capacity * 2 : 64;
+    frontier->chunks = realloc(frontier->chunks, frontier->capacity * sizeof(FrontierChunk *));
+    if (frontier->chunks == NULL)
+    {
+      printf("ERROR: Out of memory for the frontier\n");
+      exit(1);
+    }
+  }
+  frontier->chunks[frontier->count++] = chunk;
+
+  pthread_mutex_unlock(&frontier->lock);
+}
+
+// Queue a rank in a thread's own chunk, handing the chunk over when full.
+static void Enqueue(Frontier *frontier, FrontierChunk **chunk, unsigned int rank)
+{
+  if (*chunk == NULL)
+  {
+    *chunk = malloc(sizeof(FrontierChunk));
+    if (*chunk == NULL)
+    {
+      printf("ERROR: Out of memory for the frontier\n");
+      exit(1);
+    }
+    (*chunk)->count = 0;
+  }
+
+  (*chunk)->ranks[(*chunk)->count++] = rank;
+
+  if ((*chunk)->count == FRONTIER_CHUNK)
+  {
+    AddChunk(frontier, *chunk);
+    *chunk = NULL;
+  }
+}
+
+static void FlushChunk(Frontier *frontier, FrontierChunk **chunk)
+{
+  if (*chunk != NULL)
+  {
+    AddChunk(frontier, *chunk);
+    *chunk = NULL;
+  }
+}
+
+static unsigned long long FrontierSize(const Frontier *frontier)
+{
+  unsigned long long size = 0;
+
+  for (size_t i = 0; i < frontier->count; i++)
+  {
+    size += frontier->chunks[i]->count;
+  }
+
+  return size;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Lower a state's depth if it is greater. Returns TRUE if this call
+//  lowered it, in which case the caller queues the state.
+
+static inline int LowerDepth(atomic_uchar *depth, unsigned int rank, int level)
+{
+  unsigned char seen = atomic_load_explicit(&depth[rank], memory_order_relaxed);
+
+  while (seen > level)
+  {
+    if (atomic_compare_exchange_weak_explicit(&depth[rank], &seen, (unsigned char)level,
+          memory_order_relaxed, memory_order_relaxed))
+    {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Every move of the blank from one abstract state.
+
+static void ExpandState(BuildThread *thread, unsigned int rank)
+{
+  BuildState *build = thread->build;
+  int k = build->tileCount;
+  int values[PDB_MAX_TILES + 1] = { 0 };
+  int owner[PDB_SIZE];
+  int blank, target, row, col;
+
+  PartialUnrank(rank, PDB_SIZE, k + 1, values);
+  blank = values[k];
+  row = blank / PDB_WIDTH;
+  col = blank % PDB_WIDTH;
+
+  for (int i = 0; i < PDB_SIZE; i++)
+  {
+    owner[i] = -1;
+  }
+  for (int i = 0; i < k; i++)
+  {
+    owner[values[i]] = i;
+  }
+
+  for (int direction = 0; direction < 4; direction++)
+  {
+    unsigned int child;
+
+    if (direction == 0)
+    {
+      if (row == 0)
+      {
+        continue;
+      }
+      target = blank - PDB_WIDTH;
+    }
+    else if (direction == 1)
+    {
+      if (row == PDB_WIDTH-1)
+      {
+        continue;
+      }
+      target = blank + PDB_WIDTH;
+    }
+    else if (direction == 2)
+    {
+      if (col == 0)
+      {
+        continue;
+      }
+      target = blank - 1;
+    }
+    else
+    {
+      if (col == PDB_WIDTH-1)
+      {
+        continue;
+      }
+      target = blank + 1;
+    }
+
+    values[k] = target;
+    if (owner[target] >= 0)
+    {
+      values[owner[target]] = blank;
+      child = (unsigned int)PartialRank(values, PDB_SIZE, k + 1);
+      values[owner[target]] = target;
+
+      if (LowerDepth(build->depth, child, build->level + 1))
+      {
+        Enqueue(build->nextLevel, &thread->next, child);
+      }
+    }
+    else
+    {
+      child = (unsigned int)PartialRank(values, PDB_SIZE, k + 1);
+
+      if (LowerDepth(build->depth, child, build->level))
+      {
+        Enqueue(build->sameLevel, &thread->same, child);
+      }
+    }
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Thread body: take chunks of the current list until there are none left.
+//  A state whose depth has since been lowered below this level was queued
+//  again for that depth, and is expanded then instead.
+
+static void *BuildWorker(void *arg)
+{
+  BuildThread *thread = arg;
+  BuildState *build = thread->build;
+  uint64_t traceBegin;
+  size_t index;
+
+  // The main thread runs worker 0 and keeps its own name.
+  if (thread->index > 0)
+  {
+    TraceBindThread(thread->index, "build");
+  }
+  traceBegin = TraceBegin();
+
+  while ((index = atomic_fetch_add(&build->nextChunk, 1)) < build->current->count)
+  {
+    FrontierChunk *chunk = build->current->chunks[index];
+
+    for (unsigned int i = 0; i < chunk->count; i++)
+    {
+      unsigned int rank = chunk->ranks[i];
+
+      if (atomic_load_explicit(&build->depth[rank], memory_order_relaxed) == build->level)
+      {
+        ExpandState(thread, rank);
+        thread->expanded++;
+      }
+    }
+
+    free(chunk);
+  }
+
+  FlushChunk(build->sameLevel, &thread->same);
+  FlushChunk(build->nextLevel, &thread->next);
+  TraceEnd(traceBegin, "build", "round", "level", build->level);
+
+  return NULL;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Expand the current list with all the threads. Returns the number of
+//  states expanded.
+
+static unsigned long long RunRound(BuildState *build, int threadCount)
+{
+  pthread_t threads[MAX_THREADS];
+  BuildThread workers[MAX_THREADS];
+  unsigned long long expanded = 0;
+  uint64_t traceBegin;
+
+  atomic_store(&build->nextChunk, 0);
+
+  for (int i = 0; i < threadCount; i++)
+  {
+    memset(&workers[i], 0, sizeof(BuildThread));
+    workers[i].build = build;
+    workers[i].index = i;
+  }
+
+  for (int i = 1; i < threadCount; i++)
+  {
+    if (pthread_create(&threads[i], NULL, BuildWorker, &workers[i]) != 0)
+    {
+      printf("ERROR: Unable to start build thread\n");
+      exit(1);
+    }
+  }
+
+  BuildWorker(&workers[0]);
+
+  traceBegin = TraceBegin();
+  for (int i = 1; i < threadCount; i++)
+  {
+    pthread_join(threads[i], NULL);
+  }
+  TraceEnd(traceBegin, "sync", "barrier", "level", build->level);
+
+  for (int i = 0; i < threadCount; i++)
+  {
+    expanded += workers[i].expanded;
+  }
+
+  build->current->count = 0;
+
+  return expanded;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Parse a comma separated tile list. Returns the tile count, or 0 if the
+//  list is bad.
+
+static int ParseTiles(const char *text, int *tiles)
+{
+  int count = 0;
+  unsigned int used = 0;
+  char *end;
+
+  while (*text != '\0')
+  {
+    long tile = strtol(text, &end, 10);
+
+    if (end == text || tile < 1 || tile > PDB_SIZE-1 || (used & (1U << tile)) ||
+        count == PDB_MAX_TILES)
+    {
+      return 0;
+    }
+    used |= 1U << tile;
+    tiles[count++] = (int)tile;
+
+    text = end;
+    if (*text == ',')
+    {
+      text++;
+    }
+    else if (*text != '\0')
+    {
+      return 0;
+    }
+  }
+
+  return count;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Encoding named on the command line, or -1.
+
+static int ParseEncoding(const char *name)
+{
+  for (int encoding = PDB_ENCODING_BYTE; encoding <= PDB_ENCODING_MOD3; encoding++)
+  {
+    if (strcmp(name, PdbEncodingName(encoding)) == 0)
+    {
+      return encoding;
+    }
+  }
+
+  return -1;
+}
+
+// Manhattan Distance of the pattern's tiles at the given positions.
+static int PatternManhattan(const PatternDatabase *pdb, const int *values)
+{
+  int distance = 0;
+
+  for (int i = 0; i < pdb->tileCount; i++)
+  {
+    int goal = pdb->tiles[i] - 1;
+
+    distance += abs(goal % PDB_WIDTH - values[i] % PDB_WIDTH) +
+                abs(goal / PDB_WIDTH - values[i] / PDB_WIDTH);
+  }
+
+  return distance;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Fill in the table from the depth of every state. Returns FALSE if some
+//  state was never reached. histogram counts the value of each placement
+//  (each state, for mod 3) before any compression.
+
+static int EncodeTable(PatternDatabase *pdb, const atomic_uchar *depth,
+  unsigned long long *histogram, int *maxDepth)
+{
+  int k = pdb->tileCount;
+  int blankSlots = PDB_SIZE - k;
+  uint64_t placements = PartialCount(PDB_SIZE, k);
+  int values[PDB_MAX_TILES];
+
+  pdb->entryCount = PdbEntryCount(k, pdb->encoding, pdb->compressionShift);
+  pdb->dataBytes = PdbDataBytes(pdb->encoding, pdb->entryCount);
+  pdb->entries = calloc(pdb->dataBytes, 1);
+  if (pdb->entries == NULL)
+  {
+    printf("ERROR: Out of memory for %llu entries\n", (unsigned long long)pdb->entryCount);
+    return FALSE;
+  }
+
+  if (pdb->encoding == PDB_ENCODING_MOD3)
+  {
+    // Every state as it is, with the blank.
+    for (uint64_t rank = 0; rank < pdb->entryCount; rank++)
+    {
+      int d = depth[rank];
+
+      if (d == UNSEEN)
+      {
+        printf("ERROR: State %llu was never reached\n", (unsigned long long)rank);
+        return FALSE;
+      }
+
+      SetPatternEntry(pdb, rank, d % 3);
+      histogram[d]++;
+      if (d > *maxDepth)
+      {
+        *maxDepth = d;
+      }
+    }
+
+    return TRUE;
+  }
+
+  // The least depth over the blank positions of each placement, and the
+  // least of those over the placements an entry covers. The blank comes
+  // last in the rank, so a placement's states are consecutive.
+  for (uint64_t index = 0; index < pdb->entryCount; index++)
+  {
+    uint64_t first = index << pdb->compressionShift;
+    uint64_t last = first + (1ULL << pdb->compressionShift);
+    int entry = UNSEEN;
+
+    for (uint64_t rank = first; rank < last && rank < placements; rank++)
+    {
+      int least = UNSEEN;
+
+      for (int j = 0; j < blankSlots; j++)
+      {
+        if (depth[rank * blankSlots + j] < least)
+        {
+          least = depth[rank * blankSlots + j];
+        }
+      }
+
+      if (least == UNSEEN)
+      {
+        printf("ERROR: Placement %llu was never reached\n", (unsigned long long)rank);
+        return FALSE;
+      }
+
+      histogram[least]++;
+      if (least > *maxDepth)
+      {
+        *maxDepth = least;
+      }
+
+      if (pdb->encoding == PDB_ENCODING_NIBBLE)
+      {
+        PartialUnrank(rank, PDB_SIZE, k, values);
+        least = (least - PatternManhattan(pdb, values)) / 2;
+        if (least > PDB_NIBBLE_MAX)
+        {
+          least = PDB_NIBBLE_MAX;
+        }
+      }
+
+      if (least < entry)
+      {
+        entry = least;
+      }
+    }
+
+    SetPatternEntry(pdb, index, entry);
+  }
+
+  return TRUE;
+}
+
+static double Seconds(const struct timespec *start)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Main
+
+int main(int argc, char **argv)
+{
+  PatternDatabase pdb, check;
+  BuildState build;
+  Frontier lists[3];
+  Frontier *swap;
+  struct timespec start;
+  const char *outputPath = NULL;
+  const char *tracePath = NULL;
+  uint64_t traceBegin;
+  int threadCount = 1;
+  int values[PDB_MAX_TILES + 1];
+  unsigned long long stateCount, expanded, levelStates = 0, histogram[UNSEEN];
+  int k, compression = 1, maxDepth = 0;
+
+  memset(&pdb, 0, sizeof(pdb));
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-tiles") == 0 && i + 1 < argc)
+    {
+      pdb.tileCount = ParseTiles(argv[++i], pdb.tiles);
+    }
+    else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+    {
+      outputPath = argv[++i];
+    }
+    else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+    {
+      threadCount = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-encoding") == 0 && i + 1 < argc)
+    {
+      pdb.encoding = ParseEncoding(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-compress") == 0 && i + 1 < argc)
+    {
+      compression = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-trace") == 0 && i + 1 < argc)
+    {
+      tracePath = argv[++i];
+    }
+    else
+    {
+      pdb.tileCount = 0;
+      break;
+    }
+  }
+
+  while ((1 << pdb.compressionShift) < compression)
+  {
+    pdb.compressionShift++;
+  }
+
+  if (pdb.tileCount == 0 || outputPath == NULL || threadCount < 1 || threadCount > MAX_THREADS ||
+      pdb.encoding < 0 || (1 << pdb.compressionShift) != compression ||
+      pdb.compressionShift > PDB_MAX_COMPRESSION_SHIFT ||
+      (pdb.encoding == PDB_ENCODING_MOD3 && compression > 1))
+  {
+    printf("Usage: pdbBuild -tiles t1,t2,... -o file [-t threads]\n");
+    printf("                [-encoding byte|nibble|mod3] [-compress ranks] [-trace file]\n");
+    printf("       At most %d tiles, and 1 to %d threads. -compress takes 1, 2, 4, 8\n", PDB_MAX_TILES, MAX_THREADS);
+    printf("       or 16, and only for the byte and nibble encodings.\n");
+    return 1;
+  }
+
+  if (tracePath != NULL && !TraceStart(threadCount))
+  {
+    printf("ERROR: Out of memory for trace\n");
+    return 1;
+  }
+
+  k = pdb.tileCount;
+  stateCount = PartialCount(PDB_SIZE, k + 1);
+
+  printf("Pattern of %d tiles:", k);
+  for (int i = 0; i < k; i++)
+  {
+    printf(" %d", pdb.tiles[i]);
+  }
+  printf("\n%llu abstract states, %d threads\n", stateCount, threadCount);
+
+  build.tileCount = k;
+  build.depth = malloc(stateCount);
+  if (build.depth == NULL)
+  {
+    printf("ERROR: Out of memory for %llu states\n", stateCount);
+    return 1;
+  }
+  memset((void *)build.depth, UNSEEN, stateCount);
+
+  for (int i = 0; i < 3; i++)
+  {
+    InitFrontier(&lists[i]);
+  }
+  build.current = &lists[0];
+  build.sameLevel = &lists[1];
+  build.nextLevel = &lists[2];
+  build.level = 0;
+
+  // The goal: tile t at t-1 and the blank in the last cell.
+  for (int i = 0; i < k; i++)
+  {
+    values[i] = pdb.tiles[i] - 1;
+  }
+  values[k] = PDB_SIZE - 1;
+  {
+    FrontierChunk *chunk = NULL;
+    unsigned int goal = (unsigned int)PartialRank(values, PDB_SIZE, k + 1);
+
+    build.depth[goal] = 0;
+    Enqueue(build.current, &chunk, goal);
+    FlushChunk(build.current, &chunk);
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  while (build.current->count > 0)
+  {
+    expanded = RunRound(&build, threadCount);
+    levelStates += expanded;
+
+    // Repeat this level over what its free moves reached, then go on to
+    // the next.
+    swap = build.current;
+    if (build.sameLevel->count > 0)
+    {
+      build.current = build.sameLevel;
+      build.sameLevel = swap;
+      continue;
+    }
+
+    printf("Depth %2d: %12llu states, next frontier %12llu, %8.1f s\n",
+      build.level, levelStates, FrontierSize(build.nextLevel), Seconds(&start));
+    fflush(stdout);
+    levelStates = 0;
+
+    build.current = build.nextLevel;
+    build.nextLevel = swap;
+    build.level++;
+  }
+
+  memset(histogram, 0, sizeof(histogram));
+  traceBegin = TraceBegin();
+  if (!EncodeTable(&pdb, build.depth, histogram, &maxDepth))
+  {
+    return 1;
+  }
+  TraceEnd(traceBegin, "tables", "encode", NULL, 0);
+
+  free((void *)build.depth);
+
+  printf("\n%s encoding, %llu entries in %llu bytes, maximum %d\n", PdbEncodingName(pdb.encoding),
+    (unsigned long long)pdb.entryCount, (unsigned long long)pdb.dataBytes, maxDepth);
+  for (int d = 0; d <= maxDepth; d++)
+  {
+    printf("  %2d: %llu\n", d, histogram[d]);
+  }
+
+  traceBegin = TraceBegin();
+  if (SavePatternDatabase(outputPath, &pdb) != 0)
+  {
+    printf("ERROR: Unable to write %s\n", outputPath);
+    return 1;
+  }
+  TraceEnd(traceBegin, "io", "write", NULL, 0);
+
+  // Read it back, to be sure the solver will see what was built.
+  traceBegin = TraceBegin();
+  if (LoadPatternDatabase(outputPath, &check) != 0 ||
+      memcmp(check.entries, pdb.entries, pdb.dataBytes) != 0)
+  {
+    printf("ERROR: %s doesn't read back the same\n", outputPath);
+    return 1;
+  }
+
+  TraceEnd(traceBegin, "io", "read back", NULL, 0);
+
+  printf("Wrote %s in %.1f s\n", outputPath, Seconds(&start));
+
+  FreePatternDatabase(&check);
+  FreePatternDatabase(&pdb);
+
+  if (tracePath != NULL && !TraceWrite(tracePath))
+  {
+    perror(tracePath);
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,330 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Validation and microbenchmarks for the ranking functions in permRank.h.
+//
+//  First every function is checked on random permutations: each unrank must
+//  undo its rank, and the solvability that BoardIndexOf derives from the
+//  rank digits must agree with the inversion count rules the solvers use in
+//  PuzzleIsSolvable. Then each function is timed, alongside a plain O(n^2)
+//  lexicographic rank for comparison.
+//
+//  Usage: permBench [iterations]
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "permRank.h"
+
+#define PUZZLE_COLUMN 4
+#define PUZZLE_ROW 4
+#define PUZZLE_SIZE (PUZZLE_COLUMN * PUZZLE_ROW)
+
+// Pattern size used for timing the partial permutation rank.
+#define PATTERN_TILES 7
+
+#define DEFAULT_ITERATIONS (1 << 20)
+
+typedef unsigned long long u64;
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Small, fast, reproducible random number generator (xorshift64*).
+
+u64 randomState = 0x9E3779B97F4A7C15ULL;
+
+u64 NextRandom()
+{
+  randomState ^= randomState >> 12;
+  randomState ^= randomState << 25;
+  randomState ^= randomState >> 27;
+  return randomState * 0x2545F4914F6CDD1DULL;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Fill perm with a uniformly random permutation of 0..n-1.
+
+void RandomPermutation(int *perm, int n)
+{
+  int j, temp;
+
+  for (int i = 0; i < n; i++)
+  {
+    perm[i] = i;
+  }
+
+  for (int i = n-1; i > 0; i--)
+  {
+    j = (int)(NextRandom() % (i+1));
+    temp = perm[i];
+    perm[i] = perm[j];
+    perm[j] = temp;
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  The inversion count as the solvers compute it, for cross-checking.
+
+int InversionCountOf(int* puzzle)
+{
+  int inversionCount = 0;
+
+  for (int i = 0; i < PUZZLE_SIZE; i++)
+  {
+    if (puzzle[i] > 0)
+    {
+      for (int j = i; j < PUZZLE_SIZE; j++)
+      {
+        if (puzzle[j] != 0 && puzzle[j] < puzzle[i])
+        {
+          inversionCount++;
+        }
+      }
+    }
+  }
+
+  return inversionCount;
+}
+
+int SolvableByInversionCount(int* puzzle)
+{
+  int indexBlank;
+
+  for (indexBlank = 0; puzzle[indexBlank] != 0; indexBlank++);
+
+  return SolvableFromInversions(InversionCountOf(puzzle), indexBlank, PUZZLE_COLUMN, PUZZLE_ROW);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Textbook lexicographic rank with a nested loop, as a timing baseline.
+
+u64 NaiveLexRank(const int *perm, int n)
+{
+  u64 rank = 0;
+  int smaller;
+
+  for (int i = 0; i < n; i++)
+  {
+    smaller = 0;
+    for (int j = i+1; j < n; j++)
+    {
+      if (perm[j] < perm[i])
+      {
+        smaller++;
+      }
+    }
+    rank = rank * (n - i) + smaller;
+  }
+
+  return rank;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Check every function on the given number of random permutations. Returns
+//  the number of failures.
+
+int Validate(int iterations)
+{
+  int perm[PERM_MAX], check[PERM_MAX], puzzle[PUZZLE_SIZE];
+  int inversions, parity, solvable;
+  int failures = 0;
+  u64 rank;
+
+  for (int iteration = 0; iteration < iterations; iteration++)
+  {
+    RandomPermutation(perm, PERM_MAX);
+
+    rank = LexRank(perm, PERM_MAX, &inversions);
+    if (rank != NaiveLexRank(perm, PERM_MAX) ||
+        LexUnrank(rank, PERM_MAX, check) != inversions ||
+        memcmp(perm, check, sizeof(perm)) != 0)
+    {
+      printf("Lexicographic rank round trip failed at %llu\n", rank);
+      failures++;
+    }
+
+    rank = MyrvoldRuskeyRank(perm, PERM_MAX, &parity);
+    if (MyrvoldRuskeyUnrank(rank, PERM_MAX, check) != parity ||
+        parity != (inversions & 1) ||
+        memcmp(perm, check, sizeof(perm)) != 0)
+    {
+      printf("Myrvold-Ruskey rank round trip failed at %llu\n", rank);
+      failures++;
+    }
+
+    rank = PartialRank(perm, PERM_MAX, PATTERN_TILES);
+    PartialUnrank(rank, PERM_MAX, PATTERN_TILES, check);
+    if (rank >= PartialCount(PERM_MAX, PATTERN_TILES) ||
+        memcmp(perm, check, sizeof(int)*PATTERN_TILES) != 0)
+    {
+      printf("Partial rank round trip failed at %llu\n", rank);
+      failures++;
+    }
+
+    // Use the permutation as a puzzle, value 0 being the blank.
+    memcpy(puzzle, perm, sizeof(puzzle));
+    rank = BoardIndexOf(puzzle, PUZZLE_COLUMN, PUZZLE_ROW, &solvable);
+    if (solvable != SolvableByInversionCount(puzzle))
+    {
+      printf("Rank parity disagrees with inversion count solvability at %llu\n", rank);
+      failures++;
+    }
+
+    BoardFromIndex(rank, PUZZLE_COLUMN, PUZZLE_ROW, check);
+    if (rank >= FACTORIAL[PUZZLE_SIZE]/2 ||
+        !SolvableByInversionCount(check) ||
+        (solvable && memcmp(puzzle, check, sizeof(puzzle)) != 0))
+    {
+      printf("Board index round trip failed at %llu\n", rank);
+      failures++;
+    }
+  }
+
+  return failures;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Timing helpers. The checksum keeps the compiler from discarding work.
+
+double Seconds()
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+void Report(const char *name, double elapsed, int iterations, u64 checksum)
+{
+  printf("%-28s %8.1f ns/op   (checksum %016llx)\n", name,
+    elapsed * 1e9 / iterations, checksum);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Main
+//
+
+int main(int argc, char *argv[])
+{
+  int iterations = (argc > 1) ? atoi(argv[1]) : DEFAULT_ITERATIONS;
+  int *perms;
+  u64 *ranks;
+  int check[PERM_MAX];
+  int failures;
+  u64 checksum;
+  double start;
+
+  if (iterations <= 0)
+  {
+    printf("Usage: %s [iterations]\n", argv[0]);
+    return 1;
+  }
+
+  failures = Validate(iterations < 100000 ? iterations : 100000);
+  printf("Validation: %d failures\n\n", failures);
+
+  perms = malloc(sizeof(int) * PERM_MAX * iterations);
+  ranks = malloc(sizeof(u64) * iterations);
+  if (perms == NULL || ranks == NULL)
+  {
+    printf("ERROR: Out of memory for %d permutations\n", iterations);
+    return 1;
+  }
+
+  for (int i = 0; i < iterations; i++)
+  {
+    RandomPermutation(&perms[i*PERM_MAX], PERM_MAX);
+  }
+
+  checksum = 0;
+  start = Seconds();
+  for (int i = 0; i < iterations; i++)
+  {
+    checksum += NaiveLexRank(&perms[i*PERM_MAX], PERM_MAX);
+  }
+  Report("Lexicographic rank (naive)", Seconds() - start, iterations, checksum);
+
+  checksum = 0;
+  start = Seconds();
+  for (int i = 0; i < iterations; i++)
+  {
+    ranks[i] = LexRank(&perms[i*PERM_MAX], PERM_MAX, NULL);
+    checksum += ranks[i];
+  }
+  Report("Lexicographic rank", Seconds() - start, iterations, checksum);
+
+  checksum = 0;
+  start = Seconds();
+  for (int i = 0; i < iterations; i++)
+  {
+    LexUnrank(ranks[i], PERM_MAX, check);
+    checksum += check[0] ^ check[PERM_MAX-1];
+  }
+  Report("Lexicographic unrank", Seconds() - start, iterations, checksum);
+
+  checksum = 0;
+  start = Seconds();
+  for (int i = 0; i < iterations; i++)
+  {
+    ranks[i] = MyrvoldRuskeyRank(&perms[i*PERM_MAX], PERM_MAX, NULL);
+    checksum += ranks[i];
+  }
+  Report("Myrvold-Ruskey rank", Seconds() - start, iterations, checksum);
+
+  checksum = 0;
+  start = Seconds();
+  for (int i = 0; i < iterations; i++)
+  {
+    MyrvoldRuskeyUnrank(ranks[i], PERM_MAX, check);
+    checksum += check[0] ^ check[PERM_MAX-1];
+  }
+  Report("Myrvold-Ruskey unrank", Seconds() - start, iterations, checksum);
+
+  checksum = 0;
+  start = Seconds();
+  for (int i = 0; i < iterations; i++)
+  {
+    ranks[i] = PartialRank(&perms[i*PERM_MAX], PERM_MAX, PATTERN_TILES);
+    checksum += ranks[i];
+  }
+  Report("Partial rank (7 of 16)", Seconds() - start, iterations, checksum);
+
+  checksum = 0;
+  start = Seconds();
+  for (int i = 0; i < iterations; i++)
+  {
+    PartialUnrank(ranks[i], PERM_MAX, PATTERN_TILES, check);
+    checksum += check[0] ^ check[PATTERN_TILES-1];
+  }
+  Report("Partial unrank (7 of 16)", Seconds() - start, iterations, checksum);
+
+  checksum = 0;
+  start = Seconds();
+  for (int i = 0; i < iterations; i++)
+  {
+    ranks[i] = BoardIndexOf(&perms[i*PERM_MAX], PUZZLE_COLUMN, PUZZLE_ROW, NULL);
+    checksum += ranks[i];
+  }
+  Report("Board index", Seconds() - start, iterations, checksum);
+
+  checksum = 0;
+  start = Seconds();
+  for (int i = 0; i < iterations; i++)
+  {
+    BoardFromIndex(ranks[i], PUZZLE_COLUMN, PUZZLE_ROW, check);
+    checksum += check[0] ^ check[PERM_MAX-1];
+  }
+  Report("Board from index", Seconds() - start, iterations, checksum);
+
+  free(perms);
+  free(ranks);
+
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,368 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Permutation ranking and unranking: mapping puzzle states to dense integers
+//  and back, for use as table indices and for generating test instances.
+//
+//  Two orderings are provided, for different needs:
+//
+//  * Lexicographic rank. Each digit is the count of smaller values to the
+//    right, which is found with a popcount of a "values already used" bit
+//    mask instead of an inner loop. The digits add up to the inversion
+//    count, which makes solvability fall out of the rank for free. Swapping
+//    the last two elements moves between ranks 2k and 2k+1, which lets the
+//    board index below pack solvable states densely.
+//
+//  * Myrvold & Ruskey rank ("Ranking and unranking permutations in linear
+//    time", 2001). Fewer operations per element than lexicographic, and the
+//    unrank is just n swaps, but the ordering has no useful structure. The
+//    number of real swaps also gives the permutation parity.
+//
+//  Partial permutations (the positions of k chosen tiles out of n places,
+//  as used by pattern databases) get a lexicographic rank as well.
+//
+//  Values are 0 through n-1, with n at most 16. Everything here is static so
+//  the header can be included by any of the standalone programs. The
+//  popcounts need -mpopcnt (or -march=native), which the Makefile adds on
+//  x86-64. Without it they become library calls and lose most of their
+//  advantage.
+//
+#ifndef PERM_RANK_H
+#define PERM_RANK_H
+
+#include <string.h>
+
+#define PERM_MAX 16
+
+typedef unsigned long long u64rank;
+
+static const u64rank FACTORIAL[PERM_MAX+1] = {
+  1ULL, 1ULL, 2ULL, 6ULL, 24ULL, 120ULL, 720ULL, 5040ULL, 40320ULL,
+  362880ULL, 3628800ULL, 39916800ULL, 479001600ULL, 6227020800ULL,
+  87178291200ULL, 1307674368000ULL, 20922789888000ULL
+};
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Number of set bits below bit position 'value' in mask.
+
+static inline int CountBelow(unsigned int mask, int value)
+{
+  return __builtin_popcount(mask & ((1U << value) - 1));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Position of the index'th (counting from zero) clear bit of mask. BMI2's
+//  PDEP does it in one instruction, otherwise strip set bits one at a time.
+
+static inline int SelectClear(unsigned int mask, int index)
+{
+#if defined(__BMI2__)
+  return __builtin_ctz(__builtin_ia32_pdep_si(1U << index, ~mask));
+#else
+  unsigned int clear = ~mask;
+
+  for (int i = 0; i < index; i++)
+  {
+    clear &= clear - 1;
+  }
+
+  return __builtin_ctz(clear);
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Split a lexicographic rank of k values out of n back into its mixed
+//  radix digits. Returns the sum of the digits.
+
+static inline int RankDigits(u64rank rank, int n, int k, int *digits)
+{
+  int sum = 0;
+
+  for (int i = k-1; i >= 0; i--)
+  {
+    digits[i] = (int)(rank % (n - i));
+    rank /= (n - i);
+    sum += digits[i];
+  }
+
+  return sum;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Lexicographic rank of a full permutation of 0..n-1. If inversionCount is
+//  not NULL it receives the inversion count, i.e. the sum of the digits.
+
+static inline u64rank LexRank(const int *perm, int n, int *inversionCount)
+{
+  unsigned int used = 0;
+  u64rank rank = 0;
+  int inversions = 0;
+  int digit;
+
+  for (int i = 0; i < n; i++)
+  {
+    // Smaller values to the right = smaller values not used on the left.
+    digit = perm[i] - CountBelow(used, perm[i]);
+    used |= 1U << perm[i];
+
+    rank = rank * (n - i) + digit;
+    inversions += digit;
+  }
+
+  if (inversionCount != NULL)
+  {
+    *inversionCount = inversions;
+  }
+
+  return rank;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Inverse of LexRank. Returns the inversion count of the permutation.
+
+static inline int LexUnrank(u64rank rank, int n, int *perm)
+{
+  int digits[PERM_MAX];
+  unsigned int used = 0;
+  int inversions = RankDigits(rank, n, n, digits);
+
+  for (int i = 0; i < n; i++)
+  {
+    perm[i] = SelectClear(used, digits[i]);
+    used |= 1U << perm[i];
+  }
+
+  return inversions;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Myrvold & Ruskey rank of a permutation of 0..n-1. If parity is not NULL
+//  it receives the permutation parity (0 even, 1 odd).
+
+static inline u64rank MyrvoldRuskeyRank(const int *perm, int n, int *parity)
+{
+  int work[PERM_MAX];
+  int inverse[PERM_MAX];
+  int digits[PERM_MAX];
+  int swaps = 0;
+  int s, temp;
+  u64rank rank = 0;
+
+  for (int i = 0; i < n; i++)
+  {
+    work[i] = perm[i];
+    inverse[perm[i]] = i;
+  }
+
+  // Move value i into place i from the top down. The value displaced from
+  // place i at each step is a digit of the rank.
+  for (int i = n-1; i > 0; i--)
+  {
+    s = work[i];
+    digits[i] = s;
+    if (s != i)
+    {
+      swaps++;
+    }
+
+    temp = work[i];
+    work[i] = work[inverse[i]];
+    work[inverse[i]] = temp;
+
+    temp = inverse[s];
+    inverse[s] = inverse[i];
+    inverse[i] = temp;
+  }
+
+  // rank = s(n) + n * (s(n-1) + (n-1) * (...)), folded from the inside out.
+  for (int i = 1; i < n; i++)
+  {
+    rank = digits[i] + (i + 1) * rank;
+  }
+
+  if (parity != NULL)
+  {
+    *parity = swaps & 1;
+  }
+
+  return rank;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Inverse of MyrvoldRuskeyRank. Returns the permutation parity.
+
+static inline int MyrvoldRuskeyUnrank(u64rank rank, int n, int *perm)
+{
+  int swaps = 0;
+  int digit, temp;
+
+  for (int i = 0; i < n; i++)
+  {
+    perm[i] = i;
+  }
+
+  for (int i = n-1; i > 0; i--)
+  {
+    digit = (int)(rank % (i + 1));
+    rank /= (i + 1);
+
+    if (digit != i)
+    {
+      temp = perm[i];
+      perm[i] = perm[digit];
+      perm[digit] = temp;
+      swaps++;
+    }
+  }
+
+  return swaps & 1;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Number of partial permutations of k values chosen from n: n!/(n-k)!
+
+static inline u64rank PartialCount(int n, int k)
+{
+  return FACTORIAL[n] / FACTORIAL[n-k];
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Lexicographic rank of k distinct values chosen from 0..n-1, for instance
+//  the positions of the k tiles of a pattern database.
+
+static inline u64rank PartialRank(const int *values, int n, int k)
+{
+  unsigned int used = 0;
+  u64rank rank = 0;
+
+  for (int i = 0; i < k; i++)
+  {
+    rank = rank * (n - i) + (values[i] - CountBelow(used, values[i]));
+    used |= 1U << values[i];
+  }
+
+  return rank;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Inverse of PartialRank.
+
+static inline void PartialUnrank(u64rank rank, int n, int k, int *values)
+{
+  int digits[PERM_MAX];
+  unsigned int used = 0;
+
+  RankDigits(rank, n, k, digits);
+
+  for (int i = 0; i < k; i++)
+  {
+    values[i] = SelectClear(used, digits[i]);
+    used |= 1U << values[i];
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Sliding tile puzzle solvability, by the same inversion count rules as
+//  PuzzleIsSolvable, given the inversion count of the tiles (blank skipped)
+//  and the position of the blank.
+
+static inline int SolvableFromInversions(int inversionCount, int indexBlank,
+  int column, int row)
+{
+  int inversionCountIsEven = ((inversionCount % 2) == 0);
+
+  if (column % 2 == 0)
+  {
+    int blankEvenRowFromDesired = (((row - (indexBlank/column)) % 2) == 1);
+
+    return blankEvenRowFromDesired ? inversionCountIsEven : !inversionCountIsEven;
+  }
+
+  return inversionCountIsEven;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Dense index of a solvable puzzle state (tile t belongs at position t-1,
+//  blank last), from 0 to size!/2 - 1:
+//
+//    index = blank position * (tiles!/2) + (lexicographic rank of tiles)/2
+//
+//  where the tiles are read in row-major order skipping the blank. Of the
+//  two ranks 2k and 2k+1, which differ only by swapping the last two tiles,
+//  exactly one is solvable.
+//
+//  If solvable is not NULL it receives the solvability of the puzzle, taken
+//  from the parity of the rank digits. (An unsolvable puzzle gets the index
+//  of its solvable partner.)
+
+static inline u64rank BoardIndexOf(const int *puzzle, int column, int row, int *solvable)
+{
+  int size = column * row;
+  int tiles[PERM_MAX];
+  int count = 0;
+  int indexBlank = 0;
+  int inversionCount;
+  u64rank rank;
+
+  for (int i = 0; i < size; i++)
+  {
+    if (puzzle[i] == 0)
+    {
+      indexBlank = i;
+    }
+    else
+    {
+      tiles[count++] = puzzle[i] - 1;
+    }
+  }
+
+  rank = LexRank(tiles, size-1, &inversionCount);
+
+  if (solvable != NULL)
+  {
+    *solvable = SolvableFromInversions(inversionCount, indexBlank, column, row);
+  }
+
+  return (u64rank)indexBlank * (FACTORIAL[size-1]/2) + rank/2;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Inverse of BoardIndexOf: always produces the solvable member of the pair.
+
+static inline void BoardFromIndex(u64rank index, int column, int row, int *puzzle)
+{
+  int size = column * row;
+  u64rank half = FACTORIAL[size-1]/2;
+  int indexBlank = (int)(index / half);
+  int tiles[PERM_MAX];
+  int inversionCount;
+  int temp;
+
+  inversionCount = LexUnrank((index % half) * 2, size-1, tiles);
+
+  if (!SolvableFromInversions(inversionCount, indexBlank, column, row))
+  {
+    temp = tiles[size-2];
+    tiles[size-2] = tiles[size-3];
+    tiles[size-3] = temp;
+  }
+
+  for (int i = 0, j = 0; i < size; i++)
+  {
+    puzzle[i] = (i == indexBlank) ? 0 : tiles[j++] + 1;
+  }
+}
+
+#endif // PERM_RANK_H
@@ -0,0 +1,552 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Disk-backed breadth-first search of the whole sliding tile puzzle state
+//  space, starting from the solved state. Reports the number of states at
+//  each optimal solution length, along with how close the Manhattan Distance
+//  heuristic gets to the true distance at that depth.
+//
+//  Every solvable state has a slot in a file of 2 bits per state, indexed by
+//  BoardIndexOf from permRank.h. (For the 4x4 puzzle that's 16!/2 states and a 2.6 TB
+//  file, so plan the disk accordingly.) The file is mapped into memory and
+//  each BFS level takes two streaming passes over it:
+//
+//  1. Expand: every state at the current depth has its children generated.
+//     Child ranks are collected into a buffer, which is sorted before being
+//     applied to the file so writes sweep through the file in order instead
+//     of seeking at random. Unseen children are marked as the next depth.
+//  2. Retire: states at the current depth are marked OLD, and the states at
+//     the next depth are counted.
+//
+//  The current and next depths use two marks that trade places every level,
+//  so neither pass ever changes a mark in a way that a repeat of the same
+//  pass would change again. That makes it safe to redo a partly finished
+//  chunk. Progress is written to a checkpoint file after every chunk of each
+//  pass, so a killed run picks up where it left off when started again with
+//  the same state file.
+//
+//  Usage: puzBFS stateFile [-m bufferMegabytes]
+//
+//  The puzzle dimensions can be changed at compile time, for example
+//  -DPUZZLE_COLUMN=3 -DPUZZLE_ROW=3 for the 8-puzzle whose whole state space
+//  fits in 45 KB.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "permRank.h"
+
+#ifndef PUZZLE_COLUMN
+#define PUZZLE_COLUMN 4
+#endif
+#ifndef PUZZLE_ROW
+#define PUZZLE_ROW 4
+#endif
+#define PUZZLE_SIZE (PUZZLE_COLUMN * PUZZLE_ROW)
+#define PUZZLE_MIN 0
+#define PUZZLE_MAX PUZZLE_SIZE-1
+
+#define FALSE 0
+#define TRUE 1
+
+typedef unsigned long long u64;
+
+// The 2-bit marks stored for each state.
+#define STATE_UNSEEN  0 // Not reached yet. (A freshly extended file is zero.)
+#define STATE_EVEN    1 // At the current or next depth, if that depth is even.
+#define STATE_ODD     2 // At the current or next depth, if that depth is odd.
+#define STATE_OLD     3 // Already expanded.
+
+// Mark for states at the given depth while it is current or next.
+#define DEPTH_MARK(depth) (((depth) % 2 == 0) ? STATE_EVEN : STATE_ODD)
+
+#define PHASE_EXPAND  0
+#define PHASE_RETIRE  1
+
+// Far beyond the 80 moves needed for the hardest 15-puzzle state.
+#define MAX_DEPTH 128
+
+// Bytes of the state file processed between checkpoints. Each byte holds
+// four states.
+#ifndef CHUNK_BYTES
+#define CHUNK_BYTES (1ULL << 26)
+#endif
+
+#define DEFAULT_BUFFER_MEGABYTES 256
+
+#define CHECKPOINT_MAGIC 0x3153464250ULL // "PBFS1"
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Everything needed to resume the search. Written next to the state file.
+
+typedef struct
+{
+  u64 magic;
+  int column;
+  int row;
+  int level;                    // Depth currently being processed.
+  int phase;                    // PHASE_EXPAND or PHASE_RETIRE.
+  u64 chunkDone;                // Chunks of the current phase finished.
+  u64 nextCount;                // States found at the next depth so far.
+  u64 stateCount[MAX_DEPTH];    // States at each depth.
+  u64 mdSum[MAX_DEPTH];         // Sum of Manhattan Distance at each depth.
+  u64 mdExact[MAX_DEPTH];       // States where Manhattan Distance is exact.
+} Checkpoint;
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Given a position, decode it into row and column.
+//
+
+void GetColumnRow(int position, int *column, int *row)
+{
+  *column = position % PUZZLE_COLUMN;
+  *row = position / PUZZLE_COLUMN;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Manhattan Distance of the puzzle, with tile t belonging at position t-1.
+
+int ManhattanDistance(int puzzle[PUZZLE_SIZE])
+{
+  int sum = 0;
+  int column, row, desiredColumn, desiredRow;
+
+  for (int i = 0; i < PUZZLE_SIZE; i++)
+  {
+    if (puzzle[i] != 0)
+    {
+      GetColumnRow(i, &column, &row);
+      GetColumnRow(puzzle[i]-1, &desiredColumn, &desiredRow);
+      sum += abs(desiredColumn - column) + abs(desiredRow - row);
+    }
+  }
+
+  return sum;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Access to the 2-bit marks, four to a byte.
+
+static inline int GetState(unsigned char *states, u64 index)
+{
+  return (states[index >> 2] >> ((index & 3) * 2)) & 3;
+}
+
+static inline void SetState(unsigned char *states, u64 index, int value)
+{
+  int shift = (int)(index & 3) * 2;
+
+  states[index >> 2] = (unsigned char)((states[index >> 2] & ~(3 << shift)) | (value << shift));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Sorting and applying the buffered child indices.
+
+int CompareIndex(const void *a, const void *b)
+{
+  u64 left = *(const u64 *)a;
+  u64 right = *(const u64 *)b;
+
+  return (left > right) - (left < right);
+}
+
+void ApplyChildren(unsigned char *states, u64 *children, u64 *childCount, int nextMark)
+{
+  qsort(children, *childCount, sizeof(u64), CompareIndex);
+
+  for (u64 i = 0; i < *childCount; i++)
+  {
+    if ((i == 0 || children[i] != children[i-1]) &&
+        GetState(states, children[i]) == STATE_UNSEEN)
+    {
+      SetState(states, children[i], nextMark);
+    }
+  }
+
+  *childCount = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Checkpoint file handling. Written to a temporary name and renamed over
+//  the old one, so a crash mid-write leaves the previous checkpoint intact.
+
+int LoadCheckpoint(const char *path, Checkpoint *checkpoint)
+{
+  FILE *file = fopen(path, "rb");
+  int loaded;
+
+  if (file == NULL)
+  {
+    return FALSE;
+  }
+
+  loaded = (fread(checkpoint, sizeof(Checkpoint), 1, file) == 1 &&
+            checkpoint->magic == CHECKPOINT_MAGIC &&
+            checkpoint->column == PUZZLE_COLUMN &&
+            checkpoint->row == PUZZLE_ROW);
+  fclose(file);
+
+  return loaded;
+}
+
+void SaveCheckpoint(const char *path, Checkpoint *checkpoint)
+{
+  char tempPath[4096];
+  FILE *file;
+
+  snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+
+  file = fopen(tempPath, "wb");
+  if (file == NULL ||
+      fwrite(checkpoint, sizeof(Checkpoint), 1, file) != 1 ||
+      fflush(file) != 0 ||
+      fsync(fileno(file)) != 0)
+  {
+    perror(tempPath);
+    exit(1);
+  }
+  fclose(file);
+
+  if (rename(tempPath, path) != 0)
+  {
+    perror(path);
+    exit(1);
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Make sure everything written to the state file so far is on disk before
+//  a checkpoint claims it is.
+
+void SyncStates(unsigned char *states, u64 stateBytes)
+{
+  if (msync(states, stateBytes, MS_SYNC) != 0)
+  {
+    perror("msync");
+    exit(1);
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Expand pass over one chunk: generate the children of every state at the
+//  current depth and record depth statistics for it.
+
+void ExpandChunk(unsigned char *states, u64 firstByte, u64 lastByte, u64 stateTotal,
+  u64 *children, u64 *childCount, u64 childCapacity, Checkpoint *checkpoint)
+{
+  int puzzle[PUZZLE_SIZE];
+  int column, row, indexBlank, childBlank, md;
+  int level = checkpoint->level;
+  int currentMark = DEPTH_MARK(level);
+  int nextMark = DEPTH_MARK(level+1);
+
+  for (u64 byte = firstByte; byte < lastByte; byte++)
+  {
+    if (states[byte] == 0)
+    {
+      // Nothing reached in this byte yet, the common case early on.
+      continue;
+    }
+
+    for (u64 index = byte*4; index < byte*4 + 4 && index < stateTotal; index++)
+    {
+      if (GetState(states, index) != currentMark)
+      {
+        continue;
+      }
+
+      BoardFromIndex(index, PUZZLE_COLUMN, PUZZLE_ROW, puzzle);
+
+      md = ManhattanDistance(puzzle);
+      checkpoint->stateCount[level]++;
+      checkpoint->mdSum[level] += md;
+      if (md == level)
+      {
+        checkpoint->mdExact[level]++;
+      }
+
+      for (indexBlank = 0; puzzle[indexBlank] != 0; indexBlank++);
+      GetColumnRow(indexBlank, &column, &row);
+
+      for (int i = 0; i < 4; i++)
+      {
+        if (i == 0 && row > 0)
+        {
+          childBlank = indexBlank - PUZZLE_COLUMN;
+        }
+        else if (i == 1 && row < PUZZLE_ROW-1)
+        {
+          childBlank = indexBlank + PUZZLE_COLUMN;
+        }
+        else if (i == 2 && column > 0)
+        {
+          childBlank = indexBlank - 1;
+        }
+        else if (i == 3 && column < PUZZLE_COLUMN-1)
+        {
+          childBlank = indexBlank + 1;
+        }
+        else
+        {
+          continue;
+        }
+
+        puzzle[indexBlank] = puzzle[childBlank];
+        puzzle[childBlank] = 0;
+
+        if (*childCount == childCapacity)
+        {
+          ApplyChildren(states, children, childCount, nextMark);
+        }
+        children[(*childCount)++] = BoardIndexOf(puzzle, PUZZLE_COLUMN, PUZZLE_ROW, NULL);
+
+        puzzle[childBlank] = puzzle[indexBlank];
+        puzzle[indexBlank] = 0;
+      }
+    }
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Retire pass over one chunk: states at the current depth become OLD.
+//  Returns the number of states found at the next depth.
+
+u64 RetireChunk(unsigned char *states, u64 firstByte, u64 lastByte, int level)
+{
+  // The work on a whole byte of four marks is tabulated, one table for each
+  // parity of the current depth.
+  static unsigned char retireTable[2][256];
+  static unsigned char nextTable[2][256];
+  static int tableReady = FALSE;
+  int parity = level % 2;
+  u64 nextCount = 0;
+
+  if (!tableReady)
+  {
+    for (int tableParity = 0; tableParity < 2; tableParity++)
+    {
+      int currentMark = DEPTH_MARK(tableParity);
+      int nextMark = DEPTH_MARK(tableParity+1);
+
+      for (int value = 0; value < 256; value++)
+      {
+        int retired = 0;
+        int count = 0;
+
+        for (int field = 0; field < 4; field++)
+        {
+          int mark = (value >> (field*2)) & 3;
+
+          retired |= ((mark == currentMark) ? STATE_OLD : mark) << (field*2);
+          count += (mark == nextMark);
+        }
+        retireTable[tableParity][value] = (unsigned char)retired;
+        nextTable[tableParity][value] = (unsigned char)count;
+      }
+    }
+    tableReady = TRUE;
+  }
+
+  for (u64 byte = firstByte; byte < lastByte; byte++)
+  {
+    nextCount += nextTable[parity][states[byte]];
+    states[byte] = retireTable[parity][states[byte]];
+  }
+
+  return nextCount;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Print the per-depth statistics gathered so far.
+
+void PrintReport(Checkpoint *checkpoint, int depthCount)
+{
+  u64 total = 0;
+
+  printf("\n%5s %16s %10s %16s\n", "Depth", "States", "Mean MD", "MD exact");
+
+  for (int depth = 0; depth < depthCount; depth++)
+  {
+    u64 count = checkpoint->stateCount[depth];
+
+    printf("%5d %16llu %10.3f %16llu\n", depth, count,
+      count ? (double)checkpoint->mdSum[depth] / count : 0.0,
+      checkpoint->mdExact[depth]);
+    total += count;
+  }
+
+  printf("\nTotal of %llu states\n", total);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Main
+//
+
+int main(int argc, char *argv[])
+{
+  const char *statePath = NULL;
+  char checkpointPath[4096];
+  u64 bufferMegabytes = DEFAULT_BUFFER_MEGABYTES;
+  u64 stateTotal = FACTORIAL[PUZZLE_SIZE]/2;
+  u64 stateBytes = (stateTotal + 3) / 4;
+  u64 chunkCount = (stateBytes + CHUNK_BYTES - 1) / CHUNK_BYTES;
+  u64 childCapacity, childCount = 0;
+  u64 *children;
+  unsigned char *states;
+  Checkpoint checkpoint;
+  int goal[PUZZLE_SIZE];
+  int fd;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-m") == 0 && i+1 < argc)
+    {
+      bufferMegabytes = strtoull(argv[++i], NULL, 10);
+    }
+    else if (statePath == NULL && argv[i][0] != '-')
+    {
+      statePath = argv[i];
+    }
+    else
+    {
+      statePath = NULL;
+      break;
+    }
+  }
+
+  if (statePath == NULL || bufferMegabytes == 0)
+  {
+    printf("Usage: %s stateFile [-m bufferMegabytes]\n", argv[0]);
+    return 1;
+  }
+
+  snprintf(checkpointPath, sizeof(checkpointPath), "%s.checkpoint", statePath);
+
+  printf("%dx%d puzzle: %llu states in %llu bytes\n",
+    PUZZLE_COLUMN, PUZZLE_ROW, stateTotal, stateBytes);
+
+  fd = open(statePath, O_RDWR | O_CREAT, 0644);
+  if (fd < 0 || ftruncate(fd, (off_t)stateBytes) != 0)
+  {
+    perror(statePath);
+    return 1;
+  }
+
+  states = mmap(NULL, stateBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (states == MAP_FAILED)
+  {
+    perror("mmap");
+    return 1;
+  }
+  madvise(states, stateBytes, MADV_SEQUENTIAL);
+
+  childCapacity = bufferMegabytes * 1024 * 1024 / sizeof(u64);
+  children = malloc(childCapacity * sizeof(u64));
+  if (children == NULL)
+  {
+    printf("ERROR: Unable to allocate %llu MB child buffer\n", bufferMegabytes);
+    return 1;
+  }
+
+  if (LoadCheckpoint(checkpointPath, &checkpoint))
+  {
+    printf("Resuming at depth %d, %s pass, chunk %llu of %llu\n", checkpoint.level,
+      checkpoint.phase == PHASE_EXPAND ? "expand" : "retire",
+      checkpoint.chunkDone, chunkCount);
+  }
+  else
+  {
+    // Fresh start: clear the state file and seed it with the solved state.
+    memset(&checkpoint, 0, sizeof(checkpoint));
+    checkpoint.magic = CHECKPOINT_MAGIC;
+    checkpoint.column = PUZZLE_COLUMN;
+    checkpoint.row = PUZZLE_ROW;
+    checkpoint.phase = PHASE_EXPAND;
+
+    memset(states, 0, stateBytes);
+    for (int i = 0; i < PUZZLE_SIZE; i++)
+    {
+      goal[i] = (i+1) % PUZZLE_SIZE;
+    }
+    SetState(states, BoardIndexOf(goal, PUZZLE_COLUMN, PUZZLE_ROW, NULL), DEPTH_MARK(0));
+
+    SyncStates(states, stateBytes);
+    SaveCheckpoint(checkpointPath, &checkpoint);
+  }
+
+  while (checkpoint.level < MAX_DEPTH-1)
+  {
+    if (checkpoint.phase == PHASE_EXPAND)
+    {
+      while (checkpoint.chunkDone < chunkCount)
+      {
+        u64 firstByte = checkpoint.chunkDone * CHUNK_BYTES;
+        u64 lastByte = firstByte + CHUNK_BYTES < stateBytes ? firstByte + CHUNK_BYTES : stateBytes;
+
+        ExpandChunk(states, firstByte, lastByte, stateTotal,
+          children, &childCount, childCapacity, &checkpoint);
+        ApplyChildren(states, children, &childCount, DEPTH_MARK(checkpoint.level+1));
+
+        SyncStates(states, stateBytes);
+        checkpoint.chunkDone++;
+        SaveCheckpoint(checkpointPath, &checkpoint);
+      }
+
+      printf("Depth %d: %llu states\n", checkpoint.level, checkpoint.stateCount[checkpoint.level]);
+      fflush(stdout);
+
+      checkpoint.phase = PHASE_RETIRE;
+      checkpoint.chunkDone = 0;
+      checkpoint.nextCount = 0;
+      SaveCheckpoint(checkpointPath, &checkpoint);
+    }
+    else
+    {
+      while (checkpoint.chunkDone < chunkCount)
+      {
+        u64 firstByte = checkpoint.chunkDone * CHUNK_BYTES;
+        u64 lastByte = firstByte + CHUNK_BYTES < stateBytes ? firstByte + CHUNK_BYTES : stateBytes;
+
+        checkpoint.nextCount += RetireChunk(states, firstByte, lastByte, checkpoint.level);
+
+        SyncStates(states, stateBytes);
+        checkpoint.chunkDone++;
+        SaveCheckpoint(checkpointPath, &checkpoint);
+      }
+
+      if (checkpoint.nextCount == 0)
+      {
+        // Nothing left at the next depth, the search is complete.
+        break;
+      }
+
+      checkpoint.level++;
+      checkpoint.phase = PHASE_EXPAND;
+      checkpoint.chunkDone = 0;
+      SaveCheckpoint(checkpointPath, &checkpoint);
+    }
+  }
+
+  PrintReport(&checkpoint, checkpoint.level+1);
+
+  free(children);
+  munmap(states, stateBytes);
+  close(fd);
+
+  return 0;
+}
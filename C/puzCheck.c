@@ -0,0 +1,689 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Checks for the verification suite (check.sh, run by make check).
+//
+//    puzCheck -parser count [-seed n]     Fuzz puzInput.h
+//    puzCheck -replay puzzleFile transcript
+//                                         Replay the moves a solver printed
+//
+//  -parser makes random lines, some valid in each of the three formats and
+//  most of them damaged: characters inserted, dropped or changed, tiles
+//  repeated, dropped or swapped, whitespace and comment marks added. Each
+//  line goes through ParsePuzzleLine and through a reference parser written
+//  here from the format description, which splits the line into tokens
+//  first and checks solvability by counting inversions instead of ranking
+//  the board. The two must agree on the status, and on the tiles when the
+//  line is valid. Then all the lines are read back through NextPuzzle, from
+//  a file (mapped) and from a pipe on standard input (read in blocks), and
+//  must come out with the same statuses and line numbers.
+//
+//  -replay reads a solver's output. Every "Tile movements to arrive in this
+//  state:" line is followed by the tiles moved, and every solve ends with a
+//  "Solution of length" line. The solves are matched in order with the
+//  valid puzzles of the file. Moving those tiles, starting from the solved
+//  state, must be legal and must arrive at the puzzle, in as many moves as
+//  the reported length.
+//
+//  Exits with 1 if anything disagrees.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+
+#include "puzInput.h"
+
+#define PUZZLE_COLUMN 4
+#define PUZZLE_ROW 4
+#define PUZZLE_SIZE (PUZZLE_COLUMN * PUZZLE_ROW)
+
+#define FALSE 0
+#define TRUE 1
+
+#define DEFAULT_SEED 1
+
+// Longest fuzzed line, well past anything a valid line needs.
+#define MAX_FUZZ_LINE 160
+
+// Longest transcript line read by -replay.
+#define MAX_TRANSCRIPT_LINE 4096
+
+// Mismatches printed in full before the rest are only counted.
+#define MAX_REPORTS 10
+
+typedef unsigned long long u64;
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Random numbers, as in puzGen.c: splitmix64 for the seed, then xorshift64*.
+
+u64 randomState;
+
+void SeedRandom(u64 seed)
+{
+  u64 z = seed + 0x9E3779B97F4A7C15ULL;
+
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  randomState = z ^ (z >> 31);
+  if (randomState == 0)
+  {
+    randomState = 1;
+  }
+}
+
+u64 NextRandom()
+{
+  randomState ^= randomState >> 12;
+  randomState ^= randomState << 25;
+  randomState ^= randomState >> 27;
+
+  return randomState * 0x2545F4914F6CDD1DULL;
+}
+
+int RandomBelow(int n)
+{
+  return (int)(NextRandom() % (u64)n);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Reference parser. Trim spaces, tabs and CRs from the ends. Empty lines
+//  and comments are skipped. Sixteen hex digits are one tile each.
+//  Anything else is split at spaces, tabs, commas and CRs, and every piece
+//  must be a decimal number. A number of more than three digits counts as
+//  out of range, however many leading zeros it has. The first of these
+//  problems found, reading left to right, is the one reported. Then come
+//  the tile count, and the range and duplicate checks, tile by tile.
+
+int IsSeparator(char c)
+{
+  return c == ' ' || c == '\t' || c == ',' || c == '\r';
+}
+
+int HexValue(char c)
+{
+  if (c >= '0' && c <= '9')
+  {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f')
+  {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F')
+  {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+// Solvable with the blank in the bottom right corner: a vertical move
+// changes the inversion count by an odd number and the blank's row by one,
+// a horizontal move changes neither, and the goal has no inversions and
+// the blank in row 3.
+int ReferenceSolvable(const int puzzle[PUZZLE_SIZE])
+{
+  int inversions = 0, blankRow = 0;
+
+  for (int i = 0; i < PUZZLE_SIZE; i++)
+  {
+    if (puzzle[i] == 0)
+    {
+      blankRow = i / PUZZLE_COLUMN;
+      continue;
+    }
+    for (int j = i + 1; j < PUZZLE_SIZE; j++)
+    {
+      if (puzzle[j] != 0 && puzzle[j] < puzzle[i])
+      {
+        inversions++;
+      }
+    }
+  }
+
+  return (inversions + blankRow) % 2 == 1;
+}
+
+ParseStatus ReferenceParse(const char *line, int puzzle[PUZZLE_SIZE])
+{
+  int start = 0, end = (int)strlen(line);
+  int count = 0, hex = TRUE;
+  int seen[PUZZLE_SIZE];
+
+  while (start < end && (line[start] == ' ' || line[start] == '\t' || line[start] == '\r'))
+  {
+    start++;
+  }
+  while (end > start && (line[end-1] == ' ' || line[end-1] == '\t' || line[end-1] == '\r'))
+  {
+    end--;
+  }
+
+  if (start == end || line[start] == '#')
+  {
+    return PARSE_EMPTY;
+  }
+
+  for (int i = start; i < end; i++)
+  {
+    hex = hex && HexValue(line[i]) >= 0;
+  }
+
+  if (hex && end - start == PUZZLE_SIZE)
+  {
+    for (int i = 0; i < PUZZLE_SIZE; i++)
+    {
+      puzzle[i] = HexValue(line[start + i]);
+    }
+    count = PUZZLE_SIZE;
+  }
+  else
+  {
+    for (int i = start; i < end; )
+    {
+      int tokenEnd = i, digits = TRUE, value = 0;
+
+      if (IsSeparator(line[i]))
+      {
+        i++;
+        continue;
+      }
+
+      while (tokenEnd < end && !IsSeparator(line[tokenEnd]))
+      {
+        digits = digits && line[tokenEnd] >= '0' && line[tokenEnd] <= '9';
+        tokenEnd++;
+      }
+
+      if (!digits)
+      {
+        return PARSE_BAD_CHARACTER;
+      }
+      if (count == PUZZLE_SIZE)
+      {
+        return PARSE_TOO_MANY;
+      }
+
+      if (tokenEnd - i > 3)
+      {
+        value = PUZZLE_SIZE;
+      }
+      else
+      {
+        for (int j = i; j < tokenEnd; j++)
+        {
+          value = value * 10 + (line[j] - '0');
+        }
+      }
+      puzzle[count++] = value;
+      i = tokenEnd;
+    }
+  }
+
+  if (count < PUZZLE_SIZE)
+  {
+    return PARSE_TOO_FEW;
+  }
+
+  memset(seen, 0, sizeof(seen));
+  for (int i = 0; i < PUZZLE_SIZE; i++)
+  {
+    if (puzzle[i] >= PUZZLE_SIZE)
+    {
+      return PARSE_OUT_OF_RANGE;
+    }
+    if (seen[puzzle[i]]++)
+    {
+      return PARSE_DUPLICATE;
+    }
+  }
+
+  return ReferenceSolvable(puzzle) ? PARSE_OK : PARSE_UNSOLVABLE;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Fuzzed lines. A random board, solvable or not, written in one of the
+//  formats with random separators, then up to four random changes.
+
+// Characters that get inserted, or substituted for others.
+static const char fuzzCharacters[] = "0123456789abcdefABCDEFxz ,\t\r#-+.;";
+
+void AppendText(char *line, int *length, const char *text)
+{
+  for (; *text != '\0' && *length < MAX_FUZZ_LINE; text++)
+  {
+    line[(*length)++] = *text;
+  }
+  line[*length] = '\0';
+}
+
+void MakeFuzzLine(char *line)
+{
+  static const char *separators[] = { " ", "  ", "\t", ",", ", ", " ,", "\r" };
+  int puzzle[PUZZLE_SIZE];
+  int length = 0;
+  int format = RandomBelow(3);
+  char text[16];
+
+  line[0] = '\0';
+
+  for (int i = 0; i < PUZZLE_SIZE; i++)
+  {
+    int j = RandomBelow(i + 1);
+
+    puzzle[i] = puzzle[j];
+    puzzle[j] = i;
+  }
+
+  // Tile changes: a repeat, a swap (which flips solvability), one dropped
+  // or one added.
+  switch (RandomBelow(8))
+  {
+    case 0:
+      puzzle[RandomBelow(PUZZLE_SIZE)] = puzzle[RandomBelow(PUZZLE_SIZE)];
+      break;
+    case 1:
+    {
+      int a = RandomBelow(PUZZLE_SIZE), b = RandomBelow(PUZZLE_SIZE), t = puzzle[a];
+
+      puzzle[a] = puzzle[b];
+      puzzle[b] = t;
+      break;
+    }
+    case 2:
+      puzzle[RandomBelow(PUZZLE_SIZE)] = PUZZLE_SIZE + RandomBelow(1000);
+      break;
+  }
+
+  if (RandomBelow(6) == 0)
+  {
+    AppendText(line, &length, separators[RandomBelow(7)]);
+  }
+
+  for (int i = 0; i < PUZZLE_SIZE; i++)
+  {
+    if (format == 0 && puzzle[i] < PUZZLE_SIZE)
+    {
+      text[0] = "0123456789abcdefABCDEF"[puzzle[i] >= 10 && RandomBelow(2) ? puzzle[i] + 6 : puzzle[i]];
+      text[1] = '\0';
+    }
+    else
+    {
+      if (i > 0)
+      {
+        AppendText(line, &length, format == 2 ? "," : separators[RandomBelow(7)]);
+      }
+      snprintf(text, sizeof(text), RandomBelow(20) == 0 ? "%04d" : RandomBelow(10) == 0 ? "%02d" : "%d",
+        puzzle[i]);
+    }
+    AppendText(line, &length, text);
+  }
+
+  if (RandomBelow(6) == 0)
+  {
+    AppendText(line, &length, separators[RandomBelow(7)]);
+  }
+
+  for (int changes = RandomBelow(5); changes > 0; changes--)
+  {
+    int at = RandomBelow(length + 1);
+
+    switch (RandomBelow(5))
+    {
+      case 0:         // Insert a character.
+        if (length < MAX_FUZZ_LINE)
+        {
+          memmove(line + at + 1, line + at, length - at + 1);
+          line[at] = fuzzCharacters[RandomBelow(sizeof(fuzzCharacters) - 1)];
+          length++;
+        }
+        break;
+      case 1:         // Drop one.
+        if (at < length)
+        {
+          memmove(line + at, line + at + 1, length - at);
+          length--;
+        }
+        break;
+      case 2:         // Change one.
+        if (at < length)
+        {
+          line[at] = fuzzCharacters[RandomBelow(sizeof(fuzzCharacters) - 1)];
+        }
+        break;
+      case 3:         // Repeat the line's tail, adding tiles.
+        AppendText(line, &length, " ");
+        for (int i = at; i < length && length < MAX_FUZZ_LINE; i++)
+        {
+          line[length++] = line[i];
+        }
+        line[length] = '\0';
+        break;
+      default:        // Cut the line short.
+        if (RandomBelow(4) == 0)
+        {
+          line[length = at] = '\0';
+        }
+        break;
+    }
+  }
+
+  if (RandomBelow(50) == 0)
+  {
+    line[0] = '#';
+    line[1] = '\0';
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Read the lines back through NextPuzzle. Returns the number of records
+//  that don't match what the reference parser said about them.
+
+int CheckStream(PuzzleInput *input, char (*lines)[MAX_FUZZ_LINE + 1],
+  const ParseStatus *expected, int count, const char *source)
+{
+  int puzzle[PUZZLE_SIZE], reference[PUZZLE_SIZE];
+  int next = 0, errors = 0;
+  ParseStatus status;
+
+  while ((status = NextPuzzle(input, puzzle)) != PARSE_END)
+  {
+    while (next < count && expected[next] == PARSE_EMPTY)
+    {
+      next++;
+    }
+
+    if (next < count && status == PARSE_OK)
+    {
+      ReferenceParse(lines[next], reference);
+    }
+
+    if (next == count || input->line != next + 1 || status != expected[next] ||
+        (status == PARSE_OK && memcmp(puzzle, reference, sizeof(puzzle)) != 0))
+    {
+      if (errors++ < MAX_REPORTS)
+      {
+        printf("ERROR: %s: line %d read as %s, expected line %d %s\n", source, input->line,
+          ParseStatusText(status), next + 1, next < count ? ParseStatusText(expected[next]) : "(end)");
+      }
+      break;
+    }
+    next++;
+  }
+
+  while (next < count && expected[next] == PARSE_EMPTY)
+  {
+    next++;
+  }
+  if (errors == 0 && next != count)
+  {
+    printf("ERROR: %s: input ended at line %d of %d\n", source, input->line, count);
+    errors++;
+  }
+
+  return errors;
+}
+
+int FuzzParser(int count, u64 seed)
+{
+  char (*lines)[MAX_FUZZ_LINE + 1] = malloc(sizeof(*lines) * count);
+  ParseStatus *expected = malloc(sizeof(ParseStatus) * count);
+  int puzzle[PUZZLE_SIZE], reference[PUZZLE_SIZE];
+  int statusCount[PARSE_READ_ERROR + 1];
+  char path[] = "/tmp/puzCheckXXXXXX";
+  PuzzleInput input;
+  ParseStatus status;
+  FILE *file;
+  int fd, pipeFds[2], saved;
+  int errors = 0;
+  pid_t writer;
+
+  if (lines == NULL || expected == NULL)
+  {
+    printf("ERROR: Out of memory for %d lines\n", count);
+    return 1;
+  }
+
+  SeedRandom(seed);
+  memset(statusCount, 0, sizeof(statusCount));
+
+  for (int i = 0; i < count; i++)
+  {
+    MakeFuzzLine(lines[i]);
+    expected[i] = ReferenceParse(lines[i], reference);
+    status = ParsePuzzleLine(lines[i], strlen(lines[i]), puzzle);
+    statusCount[expected[i]]++;
+
+    if (status != expected[i] ||
+        (status == PARSE_OK && memcmp(puzzle, reference, sizeof(puzzle)) != 0))
+    {
+      if (errors++ < MAX_REPORTS)
+      {
+        printf("ERROR: \"%s\" parsed as %s, expected %s\n", lines[i],
+          ParseStatusText(status), ParseStatusText(expected[i]));
+      }
+    }
+  }
+
+  printf("Parser: %d lines:", count);
+  for (int s = PARSE_OK; s <= PARSE_READ_ERROR; s++)
+  {
+    if (statusCount[s] > 0)
+    {
+      printf(" %d %s%s", statusCount[s], ParseStatusText(s), s == PARSE_UNSOLVABLE ? "" : ",");
+    }
+  }
+  printf("\n");
+
+  // The same lines as a file, the last without a newline.
+  if ((fd = mkstemp(path)) < 0 || (file = fdopen(fd, "w")) == NULL)
+  {
+    perror(path);
+    return 1;
+  }
+  for (int i = 0; i < count; i++)
+  {
+    fprintf(file, "%s%s", lines[i], i < count - 1 ? "\n" : "");
+  }
+  fclose(file);
+
+  if (OpenPuzzleInput(&input, path) != 0)
+  {
+    perror(path);
+    return 1;
+  }
+  errors += CheckStream(&input, lines, expected, count, "file");
+  ClosePuzzleInput(&input);
+
+  // And through a pipe on standard input, written by a child process.
+  fflush(stdout);
+  if (pipe(pipeFds) != 0 || (writer = fork()) < 0)
+  {
+    perror("pipe");
+    return 1;
+  }
+  if (writer == 0)
+  {
+    close(pipeFds[0]);
+    file = fdopen(pipeFds[1], "w");
+    for (int i = 0; i < count; i++)
+    {
+      fprintf(file, "%s%s", lines[i], i < count - 1 ? "\n" : "");
+    }
+    fclose(file);
+    _exit(0);
+  }
+
+  close(pipeFds[1]);
+  saved = dup(0);
+  dup2(pipeFds[0], 0);
+  close(pipeFds[0]);
+  if (OpenPuzzleInput(&input, NULL) != 0)
+  {
+    perror("stdin");
+    return 1;
+  }
+  errors += CheckStream(&input, lines, expected, count, "pipe");
+  ClosePuzzleInput(&input);
+  dup2(saved, 0);
+  close(saved);
+  waitpid(writer, NULL, 0);
+
+  remove(path);
+  free(lines);
+  free(expected);
+
+  printf("Parser: %d mismatches\n", errors);
+
+  return errors > 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Replay the moves of a solver transcript against the puzzles it solved.
+
+// Move the tiles from the solved state. Returns FALSE if a move is illegal
+// or the board doesn't end up as the puzzle.
+int ReplayMoves(const int puzzle[PUZZLE_SIZE], const char *moves, int *length)
+{
+  int board[PUZZLE_SIZE];
+  int blank = PUZZLE_SIZE - 1;
+  int tile, cell, used;
+
+  for (int i = 0; i < PUZZLE_SIZE; i++)
+  {
+    board[i] = (i + 1) % PUZZLE_SIZE;
+  }
+
+  for (*length = 0; sscanf(moves, "%d%n", &tile, &used) == 1; moves += used, (*length)++)
+  {
+    for (cell = 0; cell < PUZZLE_SIZE && board[cell] != tile; cell++)
+    {
+    }
+
+    if (tile <= 0 || cell == PUZZLE_SIZE ||
+        !((cell / PUZZLE_COLUMN == blank / PUZZLE_COLUMN && abs(cell - blank) == 1) ||
+          abs(cell - blank) == PUZZLE_COLUMN))
+    {
+      return FALSE;
+    }
+
+    board[blank] = tile;
+    board[cell] = 0;
+    blank = cell;
+  }
+
+  return memcmp(board, puzzle, sizeof(board)) == 0;
+}
+
+int ReplayTranscript(const char *puzzlePath, const char *transcriptPath)
+{
+  PuzzleInput input;
+  ParseStatus status;
+  FILE *transcript;
+  char text[MAX_TRANSCRIPT_LINE];
+  char moves[MAX_TRANSCRIPT_LINE];
+  int puzzle[PUZZLE_SIZE];
+  int pending = FALSE, reported, length = 0;
+  int solves = 0, errors = 0;
+
+  if (OpenPuzzleInput(&input, puzzlePath) != 0)
+  {
+    perror(puzzlePath);
+    return 1;
+  }
+
+  if ((transcript = fopen(transcriptPath, "r")) == NULL)
+  {
+    perror(transcriptPath);
+    return 1;
+  }
+
+  while (fgets(text, sizeof(text), transcript) != NULL)
+  {
+    if (strncmp(text, "Tile movements to arrive in this state:", 39) == 0)
+    {
+      if (fgets(moves, sizeof(moves), transcript) == NULL)
+      {
+        break;
+      }
+      pending = TRUE;
+    }
+    else if (sscanf(text, "Solution of length %d", &reported) == 1)
+    {
+      while ((status = NextPuzzle(&input, puzzle)) != PARSE_OK && status != PARSE_END)
+      {
+      }
+
+      solves++;
+      if (status == PARSE_END)
+      {
+        printf("ERROR: %s has more solutions than %s has puzzles\n", transcriptPath, puzzlePath);
+        errors++;
+        break;
+      }
+
+      if (!ReplayMoves(puzzle, pending ? moves : "", &length) || length != reported)
+      {
+        if (errors++ < MAX_REPORTS)
+        {
+          printf("ERROR: %s: the moves for line %d don't solve it in %d moves\n",
+            transcriptPath, input.line, reported);
+        }
+      }
+      pending = FALSE;
+    }
+  }
+
+  fclose(transcript);
+  ClosePuzzleInput(&input);
+
+  printf("Replay: %d solutions from %s, %d wrong\n", solves, transcriptPath, errors);
+
+  return errors > 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Main
+//
+
+int main(int argc, char *argv[])
+{
+  u64 seed = DEFAULT_SEED;
+  int count = 0;
+
+  if (argc == 4 && strcmp(argv[1], "-replay") == 0)
+  {
+    return ReplayTranscript(argv[2], argv[3]);
+  }
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-parser") == 0 && i+1 < argc)
+    {
+      count = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-seed") == 0 && i+1 < argc)
+    {
+      seed = strtoull(argv[++i], NULL, 10);
+    }
+    else
+    {
+      count = 0;
+      break;
+    }
+  }
+
+  if (count <= 0)
+  {
+    printf("Usage: %s -parser count [-seed n]\n", argv[0]);
+    printf("       %s -replay puzzleFile transcript\n", argv[0]);
+    return 1;
+  }
+
+  return FuzzParser(count, seed);
+}
@@ -0,0 +1,738 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Sliding tile puzzle solver using IDA* search with the Walking Distance
+//  heuristic, with each iteration split across several worker processes.
+//
+//  The coordinator expands the root down to a split depth and serializes the
+//  frontier nodes (board, path length, heuristic indices) as work units. The
+//  workers run the puzWD.c ExamineNode core on their subtrees and report back
+//  node count, smallest exceeded f value, and any solution found.
+//
+//  Optimality is preserved by keeping the thresholds synchronized: every
+//  work unit of an iteration is searched with the same limit, and the next
+//  iteration is not started until every unit of the current one has reported
+//  back without a solution. Any solution found at a limit is therefore no
+//  longer than the limit, and no shorter solution exists.
+//
+//  Usage: puzDist [-w workers] [-d splitDepth] [-spawn command]
+//         puzDist -worker
+//
+//  By default the workers are forked locally and talk to the coordinator over
+//  a socket pair. With -spawn, each worker is started with "/bin/sh -c command"
+//  with its stdin/stdout connected to the coordinator, so a command such as
+//  "ssh host ./puzDist -worker" spreads the search across a cluster. Work
+//  units are sent as raw structs, so every worker must run the same binary
+//  build on the same architecture.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "puzInput.h"
+#include "walkDist.h"
+
+#define PUZZLE_COLUMN 4
+#define PUZZLE_ROW 4
+#define PUZZLE_SIZE (PUZZLE_COLUMN * PUZZLE_ROW)
+#define PUZZLE_MIN 0
+#define PUZZLE_MAX PUZZLE_SIZE-1
+
+#define FALSE 0
+#define TRUE 1
+
+// Longest optimal solution of any 15-puzzle configuration is 80 moves.
+#define MAX_SOLUTION_LENGTH 100
+
+#define DEFAULT_WORKERS 4
+#define DEFAULT_SPLIT_DEPTH 8
+#define MAX_WORKERS 256
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Simple linear search to find the location of the blank (zero) tile
+//
+
+int GetBlankPosition(int puzzle[PUZZLE_SIZE])
+{
+    int indexBlank = -1;
+
+    for(int i = 0; i < PUZZLE_SIZE && indexBlank == -1; i++)
+    {
+      if (puzzle[i] == 0)
+      {
+        indexBlank = i;
+      }
+    }
+
+    if (indexBlank==-1)
+    {
+      printf("ERROR: Blank tile not found\n");
+    }
+
+    return indexBlank;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Print the puzzle state to stdout
+
+void PrintPuzzle(int puzzle[PUZZLE_SIZE])
+{
+    for(int i = 0; i < PUZZLE_ROW; i++) 
+    {
+      for (int j = 0; j < PUZZLE_COLUMN; j++)
+      {
+        printf("%3d", puzzle[(i*PUZZLE_COLUMN) + j]);
+      }
+      printf("\n");
+    }
+
+    printf("\n");
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Work unit handed from the coordinator to a worker: a frontier node with
+//  everything ExamineNode needs to resume the search from there, plus the
+//  moves that led to it so the worker can report a complete solution.
+
+typedef struct
+{
+  int id;
+  int limitLength;
+  int currentLength;
+  int blankIndex;
+  int prevBlankIndex;
+  int idx1, idx2, inv1, inv2;
+  char puzzle[PUZZLE_SIZE];
+  char moves[MAX_SOLUTION_LENGTH];
+} WorkUnit;
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Result reported back by a worker for one work unit. A length of zero
+//  means no solution was found within the limit.
+
+typedef struct
+{
+  int id;
+  int length;
+  int nextLimit;
+  unsigned long long nodes;
+  char moves[MAX_SOLUTION_LENGTH];
+} WorkResult;
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Growable list of work units produced by the coordinator's expansion.
+
+typedef struct
+{
+  WorkUnit *units;
+  int count;
+  int capacity;
+} WorkQueue;
+
+void AppendWorkUnit(WorkQueue *queue, int puzzle[PUZZLE_SIZE],
+  int blankIndex, int prevBlankIndex,
+  int idx1, int idx2, int inv1, int inv2,
+  int currentLength, int limitLength, char moves[MAX_SOLUTION_LENGTH])
+{
+  WorkUnit *unit;
+
+  if (queue->count == queue->capacity)
+  {
+    queue->capacity = queue->capacity ? queue->capacity*2 : 256;
+    queue->units = realloc(queue->units, sizeof(WorkUnit)*queue->capacity);
+    if (queue->units == NULL)
+    {
+      printf("ERROR: Out of memory for work queue\n");
+      exit(1);
+    }
+  }
+
+  unit = &queue->units[queue->count];
+  memset(unit, 0, sizeof(WorkUnit));
+
+  unit->id = queue->count;
+  unit->limitLength = limitLength;
+  unit->currentLength = currentLength;
+  unit->blankIndex = blankIndex;
+  unit->prevBlankIndex = prevBlankIndex;
+  unit->idx1 = idx1;
+  unit->idx2 = idx2;
+  unit->inv1 = inv1;
+  unit->inv2 = inv2;
+
+  for (int i = 0; i < PUZZLE_SIZE; i++)
+  {
+    unit->puzzle[i] = (char)puzzle[i];
+  }
+  memcpy(unit->moves, moves, currentLength);
+
+  queue->count++;
+}
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Examine a node and recursively call self to search deeper in the tree
+//
+//  Same search core as puzWD.c, on an array board with each move stepped
+//  by WalkingDistanceMove (walkDist.h), with a few changes so it can be
+//  split across processes:
+//  * The smallest f value that exceeded the limit is nominated into nextLimit.
+//  * The tile moved at each depth is recorded into solutionMoves[] on the way
+//    down instead of being printed on the way back up. When a solution is
+//    found, the array holds the full path.
+//  * When given a work queue, nodes at splitDepth are not searched. They are
+//    appended to the queue as work units for the worker processes.
+
+int ExamineNode(int puzzle[PUZZLE_SIZE],
+  int currentBlankIndex, int prevBlankIndex,
+  int idx1o, int idx2o, int inv1o, int inv2o,
+  int currentLength, int limitLength, int *nextLimit,
+  unsigned long long *nodeCounter, char solutionMoves[MAX_SOLUTION_LENGTH],
+  WorkQueue *queue, int splitDepth)
+{
+  if (queue != NULL && currentLength == splitDepth)
+  {
+    // Frontier node: hand it off instead of searching it here. The worker
+    // counts this node, so it is not counted here.
+    AppendWorkUnit(queue, puzzle, currentBlankIndex, prevBlankIndex,
+      idx1o, idx2o, inv1o, inv2o, currentLength, limitLength, solutionMoves);
+    return 0;
+  }
+
+  int val = HeuristicValue(idx1o, idx2o, inv1o, inv2o);
+
+  (*nodeCounter)++;
+
+  if (((*nodeCounter) % 1000000000) == 0)
+  {
+    // Status update every billion nodes
+    printf("Limit: %d ongoing - with %llu nodes\n", limitLength, *nodeCounter);
+  }  
+
+  if(puzzle[currentBlankIndex]!=0)
+  {
+    printf("ERROR: Blank index is not blank.\n");
+  }
+
+  if (val == 0)
+  {
+    // Problem solved!
+    return currentLength;
+  }
+  else if (currentLength + val > limitLength)
+  {
+    // Exceeded limit
+    if (*nextLimit > currentLength+val)
+    {
+      // Nominate our length+heuristic value as next highest limit
+      *nextLimit = currentLength+val;
+    }
+    return 0;
+  }
+  else
+  {
+    // Not terminating, so let's dig deeper
+    int ret=0, childBlankIndex=0;
+    int idx1, idx2, inv1, inv2;
+
+    for (int i = 0; i < 4; i++)
+    {
+      // Reset indices between iterations
+      idx1 = idx1o;
+      idx2 = idx2o;
+      inv1 = inv1o;
+      inv2 = inv2o;
+
+      childBlankIndex = WalkingDistanceMove(puzzle, currentBlankIndex, i,
+        &idx1, &idx2, &inv1, &inv2);
+
+      if (childBlankIndex < 0)
+      {
+        // That move would leave the board.
+        continue;
+      }
+
+      if(childBlankIndex == prevBlankIndex)
+      {
+        // This retracts the move our parent just did, no point.
+        continue;
+      }
+
+      // Record the tile we're about to move
+      solutionMoves[currentLength] = (char)puzzle[childBlankIndex];
+
+      // Perform the swap
+      puzzle[currentBlankIndex] = puzzle[childBlankIndex];
+      puzzle[childBlankIndex] = 0;
+
+      // Recursive call to look at the next node
+      ret = ExamineNode(puzzle, 
+        childBlankIndex, currentBlankIndex,
+        idx1, idx2, inv1, inv2,
+        currentLength+1, limitLength, nextLimit, nodeCounter, solutionMoves,
+        queue, splitDepth);
+
+      // Revert the swap
+      puzzle[childBlankIndex] = puzzle[currentBlankIndex];
+      puzzle[currentBlankIndex] = 0;
+
+      // Did the child find anything?
+      if (ret != 0)
+      {
+        return ret;
+      }
+    }
+
+    // None of the four directions proved fruitful
+    return 0;
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Blocking read/write of a complete record over a socket or pipe. Returns
+//  TRUE on success, FALSE on end of stream or error.
+
+int ReadFully(int fd, void *buffer, size_t size)
+{
+  char *position = buffer;
+  ssize_t count;
+
+  while (size > 0)
+  {
+    count = read(fd, position, size);
+    if (count <= 0)
+    {
+      return FALSE;
+    }
+    position += count;
+    size -= count;
+  }
+
+  return TRUE;
+}
+
+int WriteFully(int fd, const void *buffer, size_t size)
+{
+  const char *position = buffer;
+  ssize_t count;
+
+  while (size > 0)
+  {
+    count = write(fd, position, size);
+    if (count <= 0)
+    {
+      return FALSE;
+    }
+    position += count;
+    size -= count;
+  }
+
+  return TRUE;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Worker loop: receive work units, search each subtree to the unit's limit
+//  and report the result. Runs until the coordinator closes the connection.
+
+void RunWorker(int inFd, int outFd)
+{
+  int puzzle[PUZZLE_SIZE];
+  WorkUnit unit;
+  WorkResult result;
+
+  while (ReadFully(inFd, &unit, sizeof(unit)))
+  {
+    for (int i = 0; i < PUZZLE_SIZE; i++)
+    {
+      puzzle[i] = unit.puzzle[i];
+    }
+
+    memset(&result, 0, sizeof(result));
+    result.id = unit.id;
+    result.nextLimit = 999;
+    memcpy(result.moves, unit.moves, unit.currentLength);
+
+    result.length = ExamineNode(puzzle,
+      unit.blankIndex, unit.prevBlankIndex,
+      unit.idx1, unit.idx2, unit.inv1, unit.inv2,
+      unit.currentLength, unit.limitLength, &result.nextLimit,
+      &result.nodes, result.moves, NULL /* queue */, 0);
+
+    if (!WriteFully(outFd, &result, sizeof(result)))
+    {
+      break;
+    }
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Coordinator side bookkeeping for one worker process.
+
+typedef struct
+{
+  pid_t pid;
+  int fd;
+  int busy;
+} Worker;
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Launch the worker processes. Each one is connected to the coordinator by
+//  its own socket pair. Without a spawn command the child simply runs the
+//  worker loop on the tables it inherited from the fork.
+
+void StartWorkers(Worker workers[], int workerCount, const char *spawnCommand)
+{
+  int sockets[2];
+
+  fflush(stdout);
+
+  for (int i = 0; i < workerCount; i++)
+  {
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0)
+    {
+      perror("socketpair");
+      exit(1);
+    }
+
+    workers[i].busy = FALSE;
+    workers[i].pid = fork();
+
+    if (workers[i].pid < 0)
+    {
+      perror("fork");
+      exit(1);
+    }
+    else if (workers[i].pid == 0)
+    {
+      // Child: drop the connections belonging to other workers.
+      close(sockets[0]);
+      for (int j = 0; j < i; j++)
+      {
+        close(workers[j].fd);
+      }
+
+      if (spawnCommand != NULL)
+      {
+        dup2(sockets[1], 0);
+        dup2(sockets[1], 1);
+        close(sockets[1]);
+        execl("/bin/sh", "sh", "-c", spawnCommand, (char *)NULL);
+        perror("execl");
+        _exit(127);
+      }
+
+      RunWorker(sockets[1], sockets[1]);
+      _exit(0);
+    }
+
+    close(sockets[1]);
+    workers[i].fd = sockets[0];
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Closing the connection tells each worker to exit, then wait for them.
+
+void StopWorkers(Worker workers[], int workerCount)
+{
+  for (int i = 0; i < workerCount; i++)
+  {
+    close(workers[i].fd);
+  }
+
+  for (int i = 0; i < workerCount; i++)
+  {
+    waitpid(workers[i].pid, NULL, 0);
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Hand out the work units of one iteration to the workers, one unit per
+//  idle worker at a time, until all units are searched. Once a solution is
+//  reported no further units are handed out, but results still in flight are
+//  collected so the workers are idle before the next call.
+//
+//  Returns the solution length (and fills in solutionMoves) if any unit
+//  found one, zero otherwise.
+
+int DistributeWorkUnits(Worker workers[], int workerCount, WorkQueue *queue,
+  int *nextLimit, unsigned long long *nodeCounter,
+  char solutionMoves[MAX_SOLUTION_LENGTH])
+{
+  struct pollfd pollList[MAX_WORKERS];
+  int pollWorker[MAX_WORKERS];
+  int pollCount;
+  int nextUnit = 0;
+  int outstanding = 0;
+  int length = 0;
+  WorkResult result;
+
+  while (outstanding > 0 || (nextUnit < queue->count && length == 0))
+  {
+    // Keep every idle worker busy while there is work left.
+    for (int i = 0; i < workerCount; i++)
+    {
+      if (!workers[i].busy && nextUnit < queue->count && length == 0)
+      {
+        if (!WriteFully(workers[i].fd, &queue->units[nextUnit], sizeof(WorkUnit)))
+        {
+          printf("ERROR: Lost connection to worker %d\n", i);
+          exit(1);
+        }
+        workers[i].busy = TRUE;
+        nextUnit++;
+        outstanding++;
+      }
+    }
+
+    // Wait for any busy worker to report back.
+    pollCount = 0;
+    for (int i = 0; i < workerCount; i++)
+    {
+      if (workers[i].busy)
+      {
+        pollList[pollCount].fd = workers[i].fd;
+        pollList[pollCount].events = POLLIN;
+        pollWorker[pollCount] = i;
+        pollCount++;
+      }
+    }
+
+    if (poll(pollList, pollCount, -1) < 0)
+    {
+      perror("poll");
+      exit(1);
+    }
+
+    for (int i = 0; i < pollCount; i++)
+    {
+      if (pollList[i].revents == 0)
+      {
+        continue;
+      }
+
+      if (!ReadFully(pollList[i].fd, &result, sizeof(result)))
+      {
+        printf("ERROR: Lost connection to worker %d\n", pollWorker[i]);
+        exit(1);
+      }
+
+      workers[pollWorker[i]].busy = FALSE;
+      outstanding--;
+
+      *nodeCounter += result.nodes;
+
+      if (*nextLimit > result.nextLimit)
+      {
+        *nextLimit = result.nextLimit;
+      }
+
+      if (result.length != 0 && (length == 0 || result.length < length))
+      {
+        length = result.length;
+        memcpy(solutionMoves, result.moves, length);
+      }
+    }
+  }
+
+  return length;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Execute the IDA* algorithm on the given puzzle state. Each iteration the
+//  coordinator searches the tree down to splitDepth itself, and the frontier
+//  below that is searched by the workers.
+//
+int IDAStar(int puzzle[PUZZLE_SIZE], Worker workers[], int workerCount, int splitDepth)
+{
+  unsigned long long nodesTotal=0;
+  unsigned long long nodesAtLimit = 0;
+  int length = 0;
+  int idx1, idx2, inv1, inv2;
+  int limit = HeuristicLookupIndices(puzzle, &idx1, &idx2, &inv1, &inv2);
+  int nextLimit = 999;
+  char solutionMoves[MAX_SOLUTION_LENGTH];
+  WorkQueue queue = { NULL, 0, 0 };
+
+  int blankIndex = GetBlankPosition(puzzle);
+
+  if (limit > 0)
+  {
+    while (1)
+    {
+      queue.count = 0;
+
+      // Search the top of the tree, collecting the frontier as work units.
+      length = ExamineNode(puzzle,
+                 blankIndex, -1 /* prevBlankIndex */,
+                 idx1, idx2, inv1, inv2,
+                 0 /* Starting length */, limit, &nextLimit,
+                 &nodesAtLimit, solutionMoves, &queue, splitDepth);
+
+      if (length == 0)
+      {
+        length = DistributeWorkUnits(workers, workerCount, &queue,
+                   &nextLimit, &nodesAtLimit, solutionMoves);
+      }
+
+      if (length != 0)
+      {
+        break;
+      }
+
+      printf("Limit: %d completed with %llu nodes\n", limit, nodesAtLimit);
+      nodesTotal += nodesAtLimit;
+      nodesAtLimit = 0;
+      limit = nextLimit;
+      nextLimit = 999;
+    }
+
+    printf("\nTile movements to arrive in this state:\n");
+    for (int i = length-1; i >= 0; i--)
+    {
+      printf(" %d", solutionMoves[i]);
+    }
+    printf("\n");
+
+    printf("\n\nLimit: %d halted at %llu nodes\n", limit, nodesAtLimit);
+
+    nodesTotal += nodesAtLimit;
+  }
+
+  printf("\n\nSolution of length %d found after searching %llu nodes\n", length, nodesTotal);
+
+  free(queue.units);
+
+  return length;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Read in puzzle state from user input: the first puzzle on standard
+//  input, in any of the formats puzInput.h accepts, on one line or spread
+//  over several. Returns FALSE if there is no valid puzzle to solve,
+//  instead of asking again.
+//
+
+int ReadPuzzleFromInput(int* puzzle)
+{
+  PuzzleInput input;
+  ParseStatus status;
+
+  printf("Enter the starting configuration for the puzzle:\n");
+  fflush(stdout);
+
+  if (OpenPuzzleInput(&input, NULL) != 0)
+  {
+    printf("ERROR: %s\n", ParseStatusText(PARSE_READ_ERROR));
+    return FALSE;
+  }
+
+  status = NextPuzzleAcrossLines(&input, puzzle);
+  ClosePuzzleInput(&input);
+
+  if (status != PARSE_OK)
+  {
+    printf("ERROR: Line %d: %s\n", input.line, ParseStatusText(status));
+    return FALSE;
+  }
+
+  printf("\nThe input received were as follows:\n\n");
+
+  PrintPuzzle(puzzle);
+
+  return TRUE;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Main
+//
+
+int main(int argc, char *argv[])
+{
+  int puzzle[PUZZLE_SIZE];
+  int idx1, idx2, inv1, inv2;
+  int workerCount = DEFAULT_WORKERS;
+  int splitDepth = DEFAULT_SPLIT_DEPTH;
+  int workerMode = FALSE;
+  const char *spawnCommand = NULL;
+  Worker workers[MAX_WORKERS];
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-w") == 0 && i+1 < argc)
+    {
+      workerCount = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-d") == 0 && i+1 < argc)
+    {
+      splitDepth = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-spawn") == 0 && i+1 < argc)
+    {
+      spawnCommand = argv[++i];
+    }
+    else if (strcmp(argv[i], "-worker") == 0)
+    {
+      workerMode = TRUE;
+    }
+    else
+    {
+      printf("Usage: %s [-w workers] [-d splitDepth] [-spawn command] | -worker\n", argv[0]);
+      return 1;
+    }
+  }
+
+  if (workerCount < 1 || workerCount > MAX_WORKERS || splitDepth < 1)
+  {
+    printf("Worker count must be 1 to %d and split depth at least 1\n", MAX_WORKERS);
+    return 1;
+  }
+
+  // A dead worker should surface as a read/write error, not kill us.
+  signal(SIGPIPE, SIG_IGN);
+
+  GenerateWalkingDistanceLookup();
+
+  if (workerMode)
+  {
+    // Stdout carries the protocol, so send everything printed to stderr.
+    int protocolFd = dup(1);
+    dup2(2, 1);
+    RunWorker(0, protocolFd);
+    return 0;
+  }
+
+  if (!ReadPuzzleFromInput(puzzle))
+  {
+    return 1;
+  }
+
+  printf("Initial heuristic value of %d\n\n", HeuristicLookupIndices(puzzle, &idx1, &idx2, &inv1, &inv2));
+  printf("Searching with %d worker processes below depth %d\n\n", workerCount, splitDepth);
+
+  StartWorkers(workers, workerCount, spawnCommand);
+
+  IDAStar(puzzle, workers, workerCount, splitDepth);
+
+  StopWorkers(workers, workerCount);
+
+  return 0;
+}
@@ -0,0 +1,175 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Convert a binary result file (see puzResult.h) back to text.
+//
+//  Each record becomes one line: the input line number, solution length,
+//  node count, search time, the starting board and the tiles moved, in the
+//  order they are moved. The moves are replayed from the starting board as
+//  they are printed, and a record whose moves don't end at the solved state
+//  is flagged.
+//
+//  Usage: puzDump resultFile
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "permRank.h"
+#include "puzResult.h"
+
+#define PUZZLE_COLUMN 4
+#define PUZZLE_ROW 4
+#define PUZZLE_SIZE (PUZZLE_COLUMN * PUZZLE_ROW)
+
+#define FALSE 0
+#define TRUE 1
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Print one record. Returns FALSE if its moves don't solve the puzzle.
+
+int DumpRecord(const ResultRecord *record)
+{
+  int puzzle[PUZZLE_SIZE];
+  int blankIndex = 0, childBlankIndex;
+  int solved = TRUE;
+
+  BoardFromIndex(record->boardIndex, PUZZLE_COLUMN, PUZZLE_ROW, puzzle);
+
+  printf("line %u length %u nodes %llu time %.6f board",
+    record->id, record->length, (unsigned long long)record->nodes,
+    record->microseconds * 1e-6);
+
+  for (int i = 0; i < PUZZLE_SIZE; i++)
+  {
+    printf(" %d", puzzle[i]);
+    if (puzzle[i] == 0)
+    {
+      blankIndex = i;
+    }
+  }
+
+  printf(" moves");
+
+  for (int i = 0; i < record->length && i < RESULT_MAX_MOVES; i++)
+  {
+    switch (ResultMove(record, i))
+    {
+      case MOVE_UP:
+        childBlankIndex = (blankIndex >= PUZZLE_COLUMN) ? blankIndex - PUZZLE_COLUMN : -1;
+        break;
+      case MOVE_DOWN:
+        childBlankIndex = (blankIndex < PUZZLE_SIZE - PUZZLE_COLUMN) ? blankIndex + PUZZLE_COLUMN : -1;
+        break;
+      case MOVE_LEFT:
+        childBlankIndex = (blankIndex % PUZZLE_COLUMN != 0) ? blankIndex - 1 : -1;
+        break;
+      default:
+        childBlankIndex = (blankIndex % PUZZLE_COLUMN != PUZZLE_COLUMN-1) ? blankIndex + 1 : -1;
+        break;
+    }
+
+    if (childBlankIndex < 0)
+    {
+      printf(" ?");
+      solved = FALSE;
+      break;
+    }
+
+    printf(" %d", puzzle[childBlankIndex]);
+    puzzle[blankIndex] = puzzle[childBlankIndex];
+    puzzle[childBlankIndex] = 0;
+    blankIndex = childBlankIndex;
+  }
+
+  for (int i = 0; i < PUZZLE_SIZE; i++)
+  {
+    if (puzzle[i] != (i+1) % PUZZLE_SIZE)
+    {
+      solved = FALSE;
+    }
+  }
+
+  if (!solved || record->length > RESULT_MAX_MOVES)
+  {
+    printf(" (does not solve)");
+    solved = FALSE;
+  }
+
+  printf("\n");
+
+  return solved;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Main
+//
+
+int main(int argc, char *argv[])
+{
+  struct stat fileStat;
+  const char *data;
+  const ResultFileHeader *header;
+  const ResultRecord *records;
+  size_t count;
+  int fd, bad = 0;
+
+  if (argc != 2)
+  {
+    fprintf(stderr, "Usage: %s resultFile\n", argv[0]);
+    return 1;
+  }
+
+  fd = open(argv[1], O_RDONLY);
+  if (fd < 0 || fstat(fd, &fileStat) != 0)
+  {
+    perror(argv[1]);
+    return 1;
+  }
+
+  if ((size_t)fileStat.st_size < sizeof(ResultFileHeader))
+  {
+    fprintf(stderr, "%s: Too short to be a result file\n", argv[1]);
+    return 1;
+  }
+
+  data = mmap(NULL, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (data == MAP_FAILED)
+  {
+    perror(argv[1]);
+    return 1;
+  }
+
+  header = (const ResultFileHeader *)data;
+  if (!ResultHeaderIsValid(header))
+  {
+    fprintf(stderr, "%s: Not a result file, or written by a different version\n", argv[1]);
+    return 1;
+  }
+
+  records = (const ResultRecord *)(data + sizeof(ResultFileHeader));
+  count = (fileStat.st_size - sizeof(ResultFileHeader)) / sizeof(ResultRecord);
+
+  if (sizeof(ResultFileHeader) + count * sizeof(ResultRecord) != (size_t)fileStat.st_size)
+  {
+    fprintf(stderr, "%s: Ignoring partial record at the end\n", argv[1]);
+  }
+
+  for (size_t i = 0; i < count; i++)
+  {
+    if (!DumpRecord(&records[i]))
+    {
+      bad++;
+    }
+  }
+
+  munmap((void *)data, fileStat.st_size);
+  close(fd);
+
+  return bad ? 1 : 0;
+}
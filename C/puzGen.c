@@ -0,0 +1,509 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Test instance generator for the 15-puzzle solvers.
+//
+//  Writes one puzzle per line in the format the solvers read, so the output
+//  can be fed straight to a batch run:
+//
+//    puzGen -random count [-seed n]        Uniformly random solvable states.
+//    puzGen -walk count moves [-seed n]    Random walks of the given length
+//                                          away from the solved state.
+//    puzGen -korf [file]                   Korf's 100 instances, built in or
+//                                          converted from a file.
+//    puzGen -korf -lengths                 Their published solution lengths.
+//
+//  The same seed always produces the same puzzles, on any machine.
+//
+//  Random states are drawn by picking a uniform index of the 16!/2 solvable
+//  states and unranking it with BoardFromIndex. Random walks never undo the
+//  move just made, but can still wander back, so the optimal solution is at
+//  most the walk length.
+//
+//  Korf's instances ("Depth-first iterative-deepening", 1985) have the goal
+//  with the blank at the top left and tile t at position t. Rotating the
+//  board 180 degrees and renumbering tile t as 16-t turns that goal into
+//  ours without changing any distance, so solution lengths match the
+//  published ones. The 100 instances are built in. Other sets in the same
+//  convention are usually distributed one per line as an instance number
+//  followed by sixteen tiles, and -korf file converts those. Every board is
+//  checked the way the solvers check their input, and bad lines are
+//  reported and counted as errors.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "puzInput.h"
+
+#define PUZZLE_COLUMN 4
+#define PUZZLE_ROW 4
+#define PUZZLE_SIZE (PUZZLE_COLUMN * PUZZLE_ROW)
+#define PUZZLE_MIN 0
+#define PUZZLE_MAX PUZZLE_SIZE-1
+
+#define FALSE 0
+#define TRUE 1
+
+#define DEFAULT_SEED 1
+
+typedef unsigned long long u64;
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Random number generation: splitmix64 to spread the seed, then
+//  xorshift64* for the sequence. Fixed algorithms rather than rand() so
+//  output doesn't depend on the C library.
+
+u64 randomState;
+
+void SeedRandom(u64 seed)
+{
+  u64 z = seed + 0x9E3779B97F4A7C15ULL;
+
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  randomState = z ^ (z >> 31);
+
+  if (randomState == 0)
+  {
+    randomState = 1;
+  }
+}
+
+u64 NextRandom()
+{
+  randomState ^= randomState >> 12;
+  randomState ^= randomState << 25;
+  randomState ^= randomState >> 27;
+  return randomState * 0x2545F4914F6CDD1DULL;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Uniform random number in [0, range) without modulo bias.
+
+u64 RandomBelow(u64 range)
+{
+  u64 limit = (~0ULL) - ((~0ULL) % range);
+  u64 value;
+
+  do
+  {
+    value = NextRandom();
+  }
+  while (value >= limit);
+
+  return value % range;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Given a position, decode it into row and column.
+//
+
+void GetColumnRow(int position, int *column, int *row)
+{
+  *column = position % PUZZLE_COLUMN;
+  *row = position / PUZZLE_COLUMN;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Print the puzzle on one line, the format ReadPuzzleFromInput reads.
+
+void WritePuzzle(int puzzle[PUZZLE_SIZE])
+{
+  for (int i = 0; i < PUZZLE_SIZE; i++)
+  {
+    printf(i ? " %d" : "%d", puzzle[i]);
+  }
+  printf("\n");
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Uniformly random solvable puzzles.
+
+void GenerateRandom(int count)
+{
+  int puzzle[PUZZLE_SIZE];
+
+  for (int i = 0; i < count; i++)
+  {
+    BoardFromIndex(RandomBelow(FACTORIAL[PUZZLE_SIZE]/2), PUZZLE_COLUMN, PUZZLE_ROW, puzzle);
+    WritePuzzle(puzzle);
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Random walks from the solved state, never reversing the previous move.
+
+void GenerateWalks(int count, int moves)
+{
+  int puzzle[PUZZLE_SIZE];
+  int candidates[4];
+  int candidateCount;
+  int blankIndex, prevBlankIndex, childBlankIndex;
+  int row, col;
+
+  for (int i = 0; i < count; i++)
+  {
+    for (int j = 0; j < PUZZLE_SIZE; j++)
+    {
+      puzzle[j] = (j+1) % PUZZLE_SIZE;
+    }
+    blankIndex = PUZZLE_SIZE-1;
+    prevBlankIndex = -1;
+
+    for (int move = 0; move < moves; move++)
+    {
+      GetColumnRow(blankIndex, &col, &row);
+      candidateCount = 0;
+
+      if (row > 0 && blankIndex - PUZZLE_COLUMN != prevBlankIndex)
+      {
+        candidates[candidateCount++] = blankIndex - PUZZLE_COLUMN;
+      }
+      if (row < PUZZLE_ROW-1 && blankIndex + PUZZLE_COLUMN != prevBlankIndex)
+      {
+        candidates[candidateCount++] = blankIndex + PUZZLE_COLUMN;
+      }
+      if (col > 0 && blankIndex - 1 != prevBlankIndex)
+      {
+        candidates[candidateCount++] = blankIndex - 1;
+      }
+      if (col < PUZZLE_COLUMN-1 && blankIndex + 1 != prevBlankIndex)
+      {
+        candidates[candidateCount++] = blankIndex + 1;
+      }
+
+      childBlankIndex = candidates[RandomBelow(candidateCount)];
+
+      puzzle[blankIndex] = puzzle[childBlankIndex];
+      puzzle[childBlankIndex] = 0;
+      prevBlankIndex = blankIndex;
+      blankIndex = childBlankIndex;
+    }
+
+    WritePuzzle(puzzle);
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Korf's 100 instances, in his goal convention, and their optimal solution
+//  lengths as published.
+
+#define KORF_COUNT 100
+
+const signed char KORF_INSTANCES[KORF_COUNT][PUZZLE_SIZE] = {
+  {14, 13, 15,  7, 11, 12,  9,  5,  6,  0,  2,  1,  4,  8, 10,  3 },  // 1
+  {13,  5,  4, 10,  9, 12,  8, 14,  2,  3,  7,  1,  0, 15, 11,  6 },  // 2
+  {14,  7,  8,  2, 13, 11, 10,  4,  9, 12,  5,  0,  3,  6,  1, 15 },  // 3
+  { 5, 12, 10,  7, 15, 11, 14,  0,  8,  2,  1, 13,  3,  4,  9,  6 },  // 4
+  { 4,  7, 14, 13, 10,  3,  9, 12, 11,  5,  6, 15,  1,  2,  8,  0 },  // 5
+  {14,  7,  1,  9, 12,  3,  6, 15,  8, 11,  2,  5, 10,  0,  4, 13 },  // 6
+  { 2, 11, 15,  5, 13,  4,  6,  7, 12,  8, 10,  1,  9,  3, 14,  0 },  // 7
+  {12, 11, 15,  3,  8,  0,  4,  2,  6, 13,  9,  5, 14,  1, 10,  7 },  // 8
+  { 3, 14,  9, 11,  5,  4,  8,  2, 13, 12,  6,  7, 10,  1, 15,  0 },  // 9
+  {13, 11,  8,  9,  0, 15,  7, 10,  4,  3,  6, 14,  5, 12,  2,  1 },  // 10
+  { 5,  9, 13, 14,  6,  3,  7, 12, 10,  8,  4,  0, 15,  2, 11,  1 },  // 11
+  {14,  1,  9,  6,  4,  8, 12,  5,  7,  2,  3,  0, 10, 11, 13, 15 },  // 12
+  { 3,  6,  5,  2, 10,  0, 15, 14,  1,  4, 13, 12,  9,  8, 11,  7 },  // 13
+  { 7,  6,  8,  1, 11,  5, 14, 10,  3,  4,  9, 13, 15,  2,  0, 12 },  // 14
+  {13, 11,  4, 12,  1,  8,  9, 15,  6,  5, 14,  2,  7,  3, 10,  0 },  // 15
+  { 1,  3,  2,  5, 10,  9, 15,  6,  8, 14, 13, 11, 12,  4,  7,  0 },  // 16
+  {15, 14,  0,  4, 11,  1,  6, 13,  7,  5,  8,  9,  3,  2, 10, 12 },  // 17
+  { 6,  0, 14, 12,  1, 15,  9, 10, 11,  4,  7,  2,  8,  3,  5, 13 },  // 18
+  { 7, 11,  8,  3, 14,  0,  6, 15,  1,  4, 13,  9,  5, 12,  2, 10 },  // 19
+  { 6, 12, 11,  3, 13,  7,  9, 15,  2, 14,  8, 10,  4,  1,  5,  0 },  // 20
+  {12,  8, 14,  6, 11,  4,  7,  0,  5,  1, 10, 15,  3, 13,  9,  2 },  // 21
+  {14,  3,  9,  1, 15,  8,  4,  5, 11,  7, 10, 13,  0,  2, 12,  6 },  // 22
+  {10,  9,  3, 11,  0, 13,  2, 14,  5,  6,  4,  7,  8, 15,  1, 12 },  // 23
+  { 7,  3, 14, 13,  4,  1, 10,  8,  5, 12,  9, 11,  2, 15,  6,  0 },  // 24
+  {11,  4,  2,  7,  1,  0, 10, 15,  6,  9, 14,  8,  3, 13,  5, 12 },  // 25
+  { 5,  7,  3, 12, 15, 13, 14,  8,  0, 10,  9,  6,  1,  4,  2, 11 },  // 26
+  {14,  1,  8, 15,  2,  6,  0,  3,  9, 12, 10, 13,  4,  7,  5, 11 },  // 27
+  {13, 14,  6, 12,  4,  5,  1,  0,  9,  3, 10,  2, 15, 11,  8,  7 },  // 28
+  { 9,  8,  0,  2, 15,  1,  4, 14,  3, 10,  7,  5, 11, 13,  6, 12 },  // 29
+  {12, 15,  2,  6,  1, 14,  4,  8,  5,  3,  7,  0, 10, 13,  9, 11 },  // 30
+  {12,  8, 15, 13,  1,  0,  5,  4,  6,  3,  2, 11,  9,  7, 14, 10 },  // 31
+  {14, 10,  9,  4, 13,  6,  5,  8,  2, 12,  7,  0,  1,  3, 11, 15 },  // 32
+  {14,  3,  5, 15, 11,  6, 13,  9,  0, 10,  2, 12,  4,  1,  7,  8 },  // 33
+  { 6, 11,  7,  8, 13,  2,  5,  4,  1, 10,  3,  9, 14,  0, 12, 15 },  // 34
+  { 1,  6, 12, 14,  3,  2, 15,  8,  4,  5, 13,  9,  0,  7, 11, 10 },  // 35
+  {12,  6,  0,  4,  7,  3, 15,  1, 13,  9,  8, 11,  2, 14,  5, 10 },  // 36
+  { 8,  1,  7, 12, 11,  0, 10,  5,  9, 15,  6, 13, 14,  2,  3,  4 },  // 37
+  { 7, 15,  8,  2, 13,  6,  3, 12, 11,  0,  4, 10,  9,  5,  1, 14 },  // 38
+  { 9,  0,  4, 10,  1, 14, 15,  3, 12,  6,  5,  7, 11, 13,  8,  2 },  // 39
+  {11,  5,  1, 14,  4, 12, 10,  0,  2,  7, 13,  3,  9, 15,  6,  8 },  // 40
+  { 8, 13, 10,  9, 11,  3, 15,  6,  0,  1,  2, 14, 12,  5,  4,  7 },  // 41
+  { 4,  5,  7,  2,  9, 14, 12, 13,  0,  3,  6, 11,  8,  1, 15, 10 },  // 42
+  {11, 15, 14, 13,  1,  9, 10,  4,  3,  6,  2, 12,  7,  5,  8,  0 },  // 43
+  {12,  9,  0,  6,  8,  3,  5, 14,  2,  4, 11,  7, 10,  1, 15, 13 },  // 44
+  { 3, 14,  9,  7, 12, 15,  0,  4,  1,  8,  5,  6, 11, 10,  2, 13 },  // 45
+  { 8,  4,  6,  1, 14, 12,  2, 15, 13, 10,  9,  5,  3,  7,  0, 11 },  // 46
+  { 6, 10,  1, 14, 15,  8,  3,  5, 13,  0,  2,  7,  4,  9, 11, 12 },  // 47
+  { 8, 11,  4,  6,  7,  3, 10,  9,  2, 12, 15, 13,  0,  1,  5, 14 },  // 48
+  {10,  0,  2,  4,  5,  1,  6, 12, 11, 13,  9,  7, 15,  3, 14,  8 },  // 49
+  {12,  5, 13, 11,  2, 10,  0,  9,  7,  8,  4,  3, 14,  6, 15,  1 },  // 50
+  {10,  2,  8,  4, 15,  0,  1, 14, 11, 13,  3,  6,  9,  7,  5, 12 },  // 51
+  {10,  8,  0, 12,  3,  7,  6,  2,  1, 14,  4, 11, 15, 13,  9,  5 },  // 52
+  {14,  9, 12, 13, 15,  4,  8, 10,  0,  2,  1,  7,  3, 11,  5,  6 },  // 53
+  {12, 11,  0,  8, 10,  2, 13, 15,  5,  4,  7,  3,  6,  9, 14,  1 },  // 54
+  {13,  8, 14,  3,  9,  1,  0,  7, 15,  5,  4, 10, 12,  2,  6, 11 },  // 55
+  { 3, 15,  2,  5, 11,  6,  4,  7, 12,  9,  1,  0, 13, 14, 10,  8 },  // 56
+  { 5, 11,  6,  9,  4, 13, 12,  0,  8,  2, 15, 10,  1,  7,  3, 14 },  // 57
+  { 5,  0, 15,  8,  4,  6,  1, 14, 10, 11,  3,  9,  7, 12,  2, 13 },  // 58
+  {15, 14,  6,  7, 10,  1,  0, 11, 12,  8,  4,  9,  2,  5, 13,  3 },  // 59
+  {11, 14, 13,  1,  2,  3, 12,  4, 15,  7,  9,  5, 10,  6,  8,  0 },  // 60
+  { 6, 13,  3,  2, 11,  9,  5, 10,  1,  7, 12, 14,  8,  4,  0, 15 },  // 61
+  { 4,  6, 12,  0, 14,  2,  9, 13, 11,  8,  3, 15,  7, 10,  1,  5 },  // 62
+  { 8, 10,  9, 11, 14,  1,  7, 15, 13,  4,  0, 12,  6,  2,  5,  3 },  // 63
+  { 5,  2, 14,  0,  7,  8,  6,  3, 11, 12, 13, 15,  4, 10,  9,  1 },  // 64
+  { 7,  8,  3,  2, 10, 12,  4,  6, 11, 13,  5, 15,  0,  1,  9, 14 },  // 65
+  {11,  6, 14, 12,  3,  5,  1, 15,  8,  0, 10, 13,  9,  7,  4,  2 },  // 66
+  { 7,  1,  2,  4,  8,  3,  6, 11, 10, 15,  0,  5, 14, 12, 13,  9 },  // 67
+  { 7,  3,  1, 13, 12, 10,  5,  2,  8,  0,  6, 11, 14, 15,  4,  9 },  // 68
+  { 6,  0,  5, 15,  1, 14,  4,  9,  2, 13,  8, 10, 11, 12,  7,  3 },  // 69
+  {15,  1,  3, 12,  4,  0,  6,  5,  2,  8, 14,  9, 13, 10,  7, 11 },  // 70
+  { 5,  7,  0, 11, 12,  1,  9, 10, 15,  6,  2,  3,  8,  4, 13, 14 },  // 71
+  {12, 15, 11, 10,  4,  5, 14,  0, 13,  7,  1,  2,  9,  8,  3,  6 },  // 72
+  { 6, 14, 10,  5, 15,  8,  7,  1,  3,  4,  2,  0, 12,  9, 11, 13 },  // 73
+  {14, 13,  4, 11, 15,  8,  6,  9,  0,  7,  3,  1,  2, 10, 12,  5 },  // 74
+  {14,  4,  0, 10,  6,  5,  1,  3,  9,  2, 13, 15, 12,  7,  8, 11 },  // 75
+  {15, 10,  8,  3,  0,  6,  9,  5,  1, 14, 13, 11,  7,  2, 12,  4 },  // 76
+  { 0, 13,  2,  4, 12, 14,  6,  9, 15,  1, 10,  3, 11,  5,  8,  7 },  // 77
+  { 3, 14, 13,  6,  4, 15,  8,  9,  5, 12, 10,  0,  2,  7,  1, 11 },  // 78
+  { 0,  1,  9,  7, 11, 13,  5,  3, 14, 12,  4,  2,  8,  6, 10, 15 },  // 79
+  {11,  0, 15,  8, 13, 12,  3,  5, 10,  1,  4,  6, 14,  9,  7,  2 },  // 80
+  {13,  0,  9, 12, 11,  6,  3,  5, 15,  8,  1, 10,  4, 14,  2,  7 },  // 81
+  {14, 10,  2,  1, 13,  9,  8, 11,  7,  3,  6, 12, 15,  5,  4,  0 },  // 82
+  {12,  3,  9,  1,  4,  5, 10,  2,  6, 11, 15,  0, 14,  7, 13,  8 },  // 83
+  {15,  8, 10,  7,  0, 12, 14,  1,  5,  9,  6,  3, 13, 11,  4,  2 },  // 84
+  { 4,  7, 13, 10,  1,  2,  9,  6, 12,  8, 14,  5,  3,  0, 11, 15 },  // 85
+  { 6,  0,  5, 10, 11, 12,  9,  2,  1,  7,  4,  3, 14,  8, 13, 15 },  // 86
+  { 9,  5, 11, 10, 13,  0,  2,  1,  8,  6, 14, 12,  4,  7,  3, 15 },  // 87
+  {15,  2, 12, 11, 14, 13,  9,  5,  1,  3,  8,  7,  0, 10,  6,  4 },  // 88
+  {11,  1,  7,  4, 10, 13,  3,  8,  9, 14,  0, 15,  6,  5,  2, 12 },  // 89
+  { 5,  4,  7,  1, 11, 12, 14, 15, 10, 13,  8,  6,  2,  0,  9,  3 },  // 90
+  { 9,  7,  5,  2, 14, 15, 12, 10, 11,  3,  6,  1,  8, 13,  0,  4 },  // 91
+  { 3,  2,  7,  9,  0, 15, 12,  4,  6, 11,  5, 14,  8, 13, 10,  1 },  // 92
+  {13,  9, 14,  6, 12,  8,  1,  2,  3,  4,  0,  7,  5, 10, 11, 15 },  // 93
+  { 5,  7, 11,  8,  0, 14,  9, 13, 10, 12,  3, 15,  6,  1,  4,  2 },  // 94
+  { 4,  3,  6, 13,  7, 15,  9,  0, 10,  5,  8, 11,  2, 12,  1, 14 },  // 95
+  { 1,  7, 15, 14,  2,  6,  4,  9, 12, 11, 13,  3,  0,  8,  5, 10 },  // 96
+  { 9, 14,  5,  7,  8, 15,  1,  2, 10,  4, 13,  6, 12,  0, 11,  3 },  // 97
+  { 0, 11,  3, 12,  5,  2,  1,  9,  8, 10, 14, 15,  7,  4, 13,  6 },  // 98
+  { 7, 15,  4,  0, 10,  9,  2,  5, 12, 11, 13,  6,  1,  3, 14,  8 },  // 99
+  {11,  4,  0,  8,  6, 10,  5, 13, 12,  7, 14,  3,  1,  2,  9, 15 },  // 100
+};
+
+const signed char KORF_LENGTHS[KORF_COUNT] = {
+  57, 55, 59, 56, 56, 52, 52, 50, 46, 59,
+  57, 45, 46, 59, 62, 42, 66, 55, 46, 52,
+  54, 59, 49, 54, 52, 58, 53, 52, 54, 47,
+  50, 59, 60, 52, 55, 52, 58, 53, 49, 54,
+  54, 42, 64, 50, 51, 49, 47, 49, 59, 53,
+  56, 56, 64, 56, 41, 55, 50, 51, 57, 66,
+  45, 57, 56, 51, 47, 61, 50, 51, 53, 52,
+  44, 56, 49, 56, 48, 57, 54, 53, 42, 57,
+  53, 62, 49, 55, 44, 45, 52, 65, 54, 50,
+  57, 57, 46, 53, 50, 49, 44, 54, 57, 54
+};
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Turn a board in Korf's convention into ours and validate it. Tiles
+//  outside 0 to 15 come out as -1, so they are reported as out of range
+//  rather than renumbered into the board.
+
+ParseStatus ConvertKorfBoard(const int korf[PUZZLE_SIZE], int puzzle[PUZZLE_SIZE])
+{
+  for (int i = 0; i < PUZZLE_SIZE; i++)
+  {
+    int tile = korf[i];
+
+    if (tile < 0 || tile > PUZZLE_MAX)
+    {
+      puzzle[PUZZLE_MAX - i] = -1;
+    }
+    else
+    {
+      puzzle[PUZZLE_MAX - i] = (tile == 0) ? 0 : PUZZLE_SIZE - tile;
+    }
+  }
+
+  return ValidatePuzzle(puzzle);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  The built-in instances, or their published lengths, one per line.
+
+void WriteKorf(int lengthsOnly)
+{
+  int korf[PUZZLE_SIZE];
+  int puzzle[PUZZLE_SIZE];
+
+  for (int i = 0; i < KORF_COUNT; i++)
+  {
+    if (lengthsOnly)
+    {
+      printf("%d\n", KORF_LENGTHS[i]);
+      continue;
+    }
+
+    for (int j = 0; j < PUZZLE_SIZE; j++)
+    {
+      korf[j] = KORF_INSTANCES[i][j];
+    }
+    ConvertKorfBoard(korf, puzzle);
+    WritePuzzle(puzzle);
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Convert a file of instances in Korf's convention. Lines of 17 numbers
+//  have the leading instance number dropped, lines of 16 are taken as they
+//  are. Returns the number of lines that could not be converted.
+
+int ConvertKorf(const char *path)
+{
+  PuzzleInput input;
+  const char *line;
+  size_t length, skip;
+  int korf[PUZZLE_SIZE];
+  int puzzle[PUZZLE_SIZE];
+  int lineNumber = 0, errors = 0;
+  ParseStatus status;
+
+  if (OpenPuzzleInput(&input, path) != 0)
+  {
+    perror(path);
+    return 1;
+  }
+
+  while ((line = NextLine(&input, &length)) != NULL)
+  {
+    lineNumber++;
+
+    // The tiles are read in Korf's convention, where a board solvable
+    // for his goal is unsolvable for ours, so only the converted board's
+    // solvability counts.
+    status = ParsePuzzleLine(line, length, korf);
+    if (status == PARSE_TOO_MANY)
+    {
+      // Drop the instance number and whatever separates it from the tiles.
+      for (skip = 0; skip < length && (line[skip] == ' ' || line[skip] == '\t'); skip++);
+      for (; skip < length && line[skip] >= '0' && line[skip] <= '9'; skip++);
+      status = ParsePuzzleLine(line + skip, length - skip, korf);
+    }
+
+    if (status == PARSE_EMPTY)
+    {
+      continue;
+    }
+
+    if (status == PARSE_OK || status == PARSE_UNSOLVABLE)
+    {
+      status = ConvertKorfBoard(korf, puzzle);
+    }
+
+    if (status != PARSE_OK)
+    {
+      fprintf(stderr, "Line %d: %s\n", lineNumber, ParseStatusText(status));
+      errors++;
+      continue;
+    }
+
+    WritePuzzle(puzzle);
+  }
+
+  ClosePuzzleInput(&input);
+
+  return errors;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Main
+//
+
+int main(int argc, char *argv[])
+{
+  u64 seed = DEFAULT_SEED;
+  int mode = 0;
+  int count = 0;
+  int moves = 0;
+  const char *korfPath = NULL;
+  int lengthsOnly = FALSE;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-random") == 0 && i+1 < argc)
+    {
+      mode = 'r';
+      count = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-walk") == 0 && i+2 < argc)
+    {
+      mode = 'w';
+      count = atoi(argv[++i]);
+      moves = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-korf") == 0)
+    {
+      mode = 'k';
+      if (i+1 < argc && (argv[i+1][0] != '-' || strcmp(argv[i+1], "-") == 0))
+      {
+        korfPath = argv[++i];
+      }
+    }
+    else if (strcmp(argv[i], "-lengths") == 0)
+    {
+      lengthsOnly = TRUE;
+    }
+    else if (strcmp(argv[i], "-seed") == 0 && i+1 < argc)
+    {
+      seed = strtoull(argv[++i], NULL, 10);
+    }
+    else
+    {
+      mode = 0;
+      break;
+    }
+  }
+
+  if (mode == 0 || count < 0 || moves < 0 || (lengthsOnly && (mode != 'k' || korfPath != NULL)))
+  {
+    fprintf(stderr, "Usage: %s -random count [-seed n]\n", argv[0]);
+    fprintf(stderr, "       %s -walk count moves [-seed n]\n", argv[0]);
+    fprintf(stderr, "       %s -korf [file]\n", argv[0]);
+    fprintf(stderr, "       %s -korf -lengths\n", argv[0]);
+    return 1;
+  }
+
+  SeedRandom(seed);
+
+  if (mode == 'r')
+  {
+    GenerateRandom(count);
+  }
+  else if (mode == 'w')
+  {
+    GenerateWalks(count, moves);
+  }
+  else if (korfPath != NULL)
+  {
+    return ConvertKorf(korfPath) ? 1 : 0;
+  }
+  else
+  {
+    WriteKorf(lengthsOnly);
+  }
+
+  return 0;
+}
@@ -0,0 +1,433 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Fast puzzle input parsing, one puzzle per line.
+//
+//  Replaces reading sixteen scanf("%d") calls per puzzle. Files given by name
+//  are mapped into memory, standard input is read in large blocks, and each
+//  line is parsed by hand. Every line gets a status code of its own, so a
+//  bad line in a batch is reported and skipped instead of stopping the run.
+//
+//  Accepted line formats:
+//    1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 0     (whitespace separated)
+//    1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,0     (comma separated)
+//    123456789abcdef0                          (one hex digit per tile)
+//  Blank lines and lines starting with # are skipped.
+//
+//  A batch holds one puzzle per line, so a short line is an error there.
+//  A single puzzle typed or piped in may instead be spread over several
+//  lines, a row per line for instance, as the scanf loop used to allow:
+//  NextPuzzleAcrossLines reads on until it has sixteen tiles.
+//
+//  The puzzle is 4x4 with the blank as 0, the same as the solvers.
+//
+#ifndef PUZ_INPUT_H
+#define PUZ_INPUT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "permRank.h"
+
+#define INPUT_COLUMN 4
+#define INPUT_ROW 4
+#define INPUT_SIZE (INPUT_COLUMN * INPUT_ROW)
+
+// Buffer for standard input. Also the longest line accepted from it.
+#define INPUT_BUFFER_SIZE (1 << 20)
+
+// Longest puzzle accepted when spread over several lines, all its lines
+// together.
+#define INPUT_JOINED_SIZE 1024
+
+typedef enum
+{
+  PARSE_OK = 0,
+  PARSE_END,              // No more input.
+  PARSE_EMPTY,            // Blank or comment line. Skipped by NextPuzzle.
+  PARSE_TOO_FEW,          // Fewer than 16 tiles on the line.
+  PARSE_TOO_MANY,         // More than 16 tiles on the line.
+  PARSE_BAD_CHARACTER,    // Something other than digits and separators.
+  PARSE_OUT_OF_RANGE,     // A tile number above 15.
+  PARSE_DUPLICATE,        // The same tile more than once.
+  PARSE_UNSOLVABLE,       // Fails the inversion count rules.
+  PARSE_READ_ERROR        // The input itself could not be read.
+} ParseStatus;
+
+typedef struct
+{
+  int fd;
+  int mapped;             // TRUE if data is an mmap of the whole file.
+  char *data;
+  size_t size;            // Bytes of valid data.
+  size_t position;        // Start of the next line within data.
+  int endOfFile;          // No more data to read into the buffer.
+  int line;               // Line number of the most recent record.
+} PuzzleInput;
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Human readable text for a status code.
+
+static const char *ParseStatusText(ParseStatus status)
+{
+  switch (status)
+  {
+    case PARSE_OK:            return "OK";
+    case PARSE_END:           return "No puzzle found in input";
+    case PARSE_EMPTY:         return "Empty line";
+    case PARSE_TOO_FEW:       return "Fewer than 16 tiles";
+    case PARSE_TOO_MANY:      return "More than 16 tiles";
+    case PARSE_BAD_CHARACTER: return "Unexpected character";
+    case PARSE_OUT_OF_RANGE:  return "Tile number out of range";
+    case PARSE_DUPLICATE:     return "Duplicate tile";
+    case PARSE_UNSOLVABLE:    return "Unsolvable puzzle configuration";
+    case PARSE_READ_ERROR:    return "Unable to read input";
+  }
+
+  return "Unknown status";
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Open the named file, or standard input if path is NULL or "-". Regular
+//  files are mapped into memory whole. Returns 0 on success, -1 on failure.
+
+static int OpenPuzzleInput(PuzzleInput *input, const char *path)
+{
+  struct stat fileStat;
+
+  memset(input, 0, sizeof(PuzzleInput));
+
+  if (path == NULL || strcmp(path, "-") == 0)
+  {
+    input->fd = 0;
+  }
+  else
+  {
+    input->fd = open(path, O_RDONLY);
+    if (input->fd < 0)
+    {
+      return -1;
+    }
+
+    if (fstat(input->fd, &fileStat) == 0 && S_ISREG(fileStat.st_mode) && fileStat.st_size > 0)
+    {
+      input->data = mmap(NULL, fileStat.st_size, PROT_READ, MAP_PRIVATE, input->fd, 0);
+      if (input->data != MAP_FAILED)
+      {
+        madvise(input->data, fileStat.st_size, MADV_SEQUENTIAL);
+        input->mapped = 1;
+        input->size = fileStat.st_size;
+        input->endOfFile = 1;
+        return 0;
+      }
+    }
+  }
+
+  input->data = malloc(INPUT_BUFFER_SIZE);
+
+  return (input->data == NULL) ? -1 : 0;
+}
+
+static void ClosePuzzleInput(PuzzleInput *input)
+{
+  if (input->mapped)
+  {
+    munmap(input->data, input->size);
+  }
+  else
+  {
+    free(input->data);
+  }
+
+  if (input->fd > 0)
+  {
+    close(input->fd);
+  }
+
+  input->data = NULL;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Find the next line. Returns a pointer to it and its length (without the
+//  newline), or NULL at the end of input. For standard input, the unread
+//  part of the buffer is slid down and topped up whenever no complete line
+//  is left in it.
+
+static const char *NextLine(PuzzleInput *input, size_t *length)
+{
+  char *start;
+  char *newline;
+  ssize_t count;
+
+  while (1)
+  {
+    start = input->data + input->position;
+    newline = memchr(start, '\n', input->size - input->position);
+
+    if (newline != NULL)
+    {
+      *length = newline - start;
+      input->position += *length + 1;
+      return start;
+    }
+
+    if (input->endOfFile || input->size - input->position == INPUT_BUFFER_SIZE)
+    {
+      // Last line without a newline, or a line too long for the buffer.
+      if (input->position == input->size)
+      {
+        return NULL;
+      }
+      *length = input->size - input->position;
+      input->position = input->size;
+      return start;
+    }
+
+    memmove(input->data, start, input->size - input->position);
+    input->size -= input->position;
+    input->position = 0;
+
+    count = read(input->fd, input->data + input->size, INPUT_BUFFER_SIZE - input->size);
+    if (count <= 0)
+    {
+      input->endOfFile = 1;
+    }
+    else
+    {
+      input->size += count;
+    }
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Check that a board holds each of the tiles 0 to 15 once and can be
+//  solved. Returns PARSE_OK, PARSE_OUT_OF_RANGE, PARSE_DUPLICATE or
+//  PARSE_UNSOLVABLE.
+
+static ParseStatus ValidatePuzzle(const int puzzle[INPUT_SIZE])
+{
+  unsigned int seen = 0;
+  int solvable;
+
+  for (int i = 0; i < INPUT_SIZE; i++)
+  {
+    if (puzzle[i] < 0 || puzzle[i] >= INPUT_SIZE)
+    {
+      return PARSE_OUT_OF_RANGE;
+    }
+    if (seen & (1U << puzzle[i]))
+    {
+      return PARSE_DUPLICATE;
+    }
+    seen |= 1U << puzzle[i];
+  }
+
+  // Solvability comes from the parity of the board's rank digits.
+  BoardIndexOf(puzzle, INPUT_COLUMN, INPUT_ROW, &solvable);
+  if (!solvable)
+  {
+    return PARSE_UNSOLVABLE;
+  }
+
+  return PARSE_OK;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Parse one line into a puzzle and validate it.
+
+static ParseStatus ParsePuzzleLine(const char *line, size_t length, int puzzle[INPUT_SIZE])
+{
+  const char *end = line + length;
+  const char *token;
+  int count = 0;
+  int value;
+
+  while (line < end && (*line == ' ' || *line == '\t' || *line == '\r'))
+  {
+    line++;
+  }
+  while (end > line && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r'))
+  {
+    end--;
+  }
+
+  if (line == end || *line == '#')
+  {
+    return PARSE_EMPTY;
+  }
+
+  if (end - line == INPUT_SIZE)
+  {
+    // Possibly the hex digit format. Anything else this long would need
+    // sixteen single digit numbers and no separators, which isn't valid.
+    for (token = line; token < end; token++)
+    {
+      if (*token >= '0' && *token <= '9')
+      {
+        value = *token - '0';
+      }
+      else if ((*token | 0x20) >= 'a' && (*token | 0x20) <= 'f')
+      {
+        value = (*token | 0x20) - 'a' + 10;
+      }
+      else
+      {
+        break;
+      }
+      puzzle[count++] = value;
+    }
+
+    if (token != end)
+    {
+      count = 0;
+    }
+  }
+
+  if (count == 0)
+  {
+    while (line < end)
+    {
+      if (*line == ' ' || *line == '\t' || *line == ',' || *line == '\r')
+      {
+        line++;
+        continue;
+      }
+
+      if (*line < '0' || *line > '9')
+      {
+        return PARSE_BAD_CHARACTER;
+      }
+
+      value = 0;
+      for (token = line; line < end && *line >= '0' && *line <= '9'; line++)
+      {
+        if (line - token < 3)
+        {
+          value = value*10 + (*line - '0');
+        }
+        else
+        {
+          value = INPUT_SIZE;  // Too many digits, certainly out of range.
+        }
+      }
+
+      if (line < end && *line != ' ' && *line != '\t' && *line != ',' && *line != '\r')
+      {
+        return PARSE_BAD_CHARACTER;
+      }
+
+      if (count == INPUT_SIZE)
+      {
+        return PARSE_TOO_MANY;
+      }
+      puzzle[count++] = value;
+    }
+  }
+
+  if (count < INPUT_SIZE)
+  {
+    return PARSE_TOO_FEW;
+  }
+
+  return ValidatePuzzle(puzzle);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Read the next puzzle, skipping blank and comment lines. Returns PARSE_OK
+//  with the puzzle filled in, PARSE_END when the input is exhausted, or the
+//  error for this record. Either way input->line is the line just read, and
+//  the following call moves on to the next line.
+
+static inline ParseStatus NextPuzzle(PuzzleInput *input, int puzzle[INPUT_SIZE])
+{
+  const char *line;
+  size_t length;
+  ParseStatus status;
+
+  if (input->data == NULL)
+  {
+    return PARSE_READ_ERROR;
+  }
+
+  do
+  {
+    line = NextLine(input, &length);
+    if (line == NULL)
+    {
+      return PARSE_END;
+    }
+    input->line++;
+
+    status = ParsePuzzleLine(line, length, puzzle);
+  }
+  while (status == PARSE_EMPTY);
+
+  return status;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Read the next puzzle like NextPuzzle, except that while it is short of
+//  sixteen tiles, the following lines are joined on. Blank and comment
+//  lines in between are skipped. input->line is the last line read.
+
+static inline ParseStatus NextPuzzleAcrossLines(PuzzleInput *input, int puzzle[INPUT_SIZE])
+{
+  char joined[INPUT_JOINED_SIZE];
+  size_t joinedLength = 0;
+  const char *line;
+  size_t length;
+  ParseStatus status;
+
+  if (input->data == NULL)
+  {
+    return PARSE_READ_ERROR;
+  }
+
+  for (;;)
+  {
+    line = NextLine(input, &length);
+    if (line == NULL)
+    {
+      return joinedLength == 0 ? PARSE_END : PARSE_TOO_FEW;
+    }
+    input->line++;
+
+    status = ParsePuzzleLine(line, length, puzzle);
+    if (status == PARSE_EMPTY)
+    {
+      continue;
+    }
+    if (joinedLength == 0 && status != PARSE_TOO_FEW)
+    {
+      // A whole puzzle on one line, or an error there, as for NextPuzzle.
+      return status;
+    }
+
+    if (joinedLength + length + 1 > sizeof(joined))
+    {
+      return PARSE_TOO_MANY;
+    }
+    memcpy(joined + joinedLength, line, length);
+    joinedLength += length;
+    joined[joinedLength++] = ' ';
+
+    status = ParsePuzzleLine(joined, joinedLength, puzzle);
+    if (status != PARSE_TOO_FEW)
+    {
+      return status;
+    }
+  }
+}
+
+#endif // PUZ_INPUT_H
@@ -0,0 +1,1103 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Sliding tile puzzle solver using IDA* search with the Walking Distance
+//  heuristic, with each iteration split across several threads.
+//
+//  The main thread searches the top of the tree down to a split depth and
+//  collects the frontier as work units, the same way puzDist.c does for
+//  processes. The search threads then pull units off the list and search
+//  them with the puzWD.c ExamineNode core. All cross-thread signalling uses
+//  the lock-free primitives in parallelSearch.h.
+//
+//  Usage: puzMT [-t threads] [-d splitDepth] [-endgame depth [-endmem MB]]
+//               [-batch file] [-trace file] [-counters]
+//
+//  With -batch, every puzzle in the file is solved, in an order chosen by
+//  predicting how long each one will take (see SolveBatch).
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "parallelSearch.h"
+#include "puzInput.h"
+#include "endgame.h"
+#include "trace.h"
+#include "counters.h"
+#include "walkDist.h"
+
+#define PUZZLE_COLUMN 4
+#define PUZZLE_ROW 4
+#define PUZZLE_SIZE (PUZZLE_COLUMN * PUZZLE_ROW)
+#define PUZZLE_MIN 0
+#define PUZZLE_MAX PUZZLE_SIZE-1
+
+#define FALSE 0
+#define TRUE 1
+
+// Longest optimal solution of any 15-puzzle configuration is 80 moves.
+#define MAX_SOLUTION_LENGTH 100
+
+// Returned up the recursion when another thread has already found a solution.
+#define SEARCH_ABORTED -1
+
+// Status lines are printed every 2^30 (about a billion) nodes per thread.
+#define STATUS_INTERVAL_MASK ((1ULL << 30) - 1)
+
+#define DEFAULT_SPLIT_DEPTH 8
+#define DEFAULT_ENDGAME_MEGABYTES 256
+#define MAX_THREADS 256
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Simple linear search to find the location of the blank (zero) tile
+//
+
+int GetBlankPosition(int puzzle[PUZZLE_SIZE])
+{
+    int indexBlank = -1;
+
+    for(int i = 0; i < PUZZLE_SIZE && indexBlank == -1; i++)
+    {
+      if (puzzle[i] == 0)
+      {
+        indexBlank = i;
+      }
+    }
+
+    if (indexBlank==-1)
+    {
+      printf("ERROR: Blank tile not found\n");
+    }
+
+    return indexBlank;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Print the puzzle state to stdout
+
+void PrintPuzzle(int puzzle[PUZZLE_SIZE])
+{
+    for(int i = 0; i < PUZZLE_ROW; i++) 
+    {
+      for (int j = 0; j < PUZZLE_COLUMN; j++)
+      {
+        printf("%3d", puzzle[(i*PUZZLE_COLUMN) + j]);
+      }
+      printf("\n");
+    }
+
+    printf("\n");
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Work unit handed to a search thread: a frontier node with
+//  everything ExamineNode needs to resume the search from there, plus the
+//  moves that led to it so the thread can report a complete solution.
+
+typedef struct
+{
+  int id;
+  int limitLength;
+  int currentLength;
+  int blankIndex;
+  int prevBlankIndex;
+  int idx1, idx2, inv1, inv2;
+  char puzzle[PUZZLE_SIZE];
+  char moves[MAX_SOLUTION_LENGTH];
+} WorkUnit;
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Growable list of work units produced by the coordinator's expansion.
+
+typedef struct
+{
+  WorkUnit *units;
+  int count;
+  int capacity;
+} WorkQueue;
+
+void AppendWorkUnit(WorkQueue *queue, int puzzle[PUZZLE_SIZE],
+  int blankIndex, int prevBlankIndex,
+  int idx1, int idx2, int inv1, int inv2,
+  int currentLength, int limitLength, char moves[MAX_SOLUTION_LENGTH])
+{
+  WorkUnit *unit;
+
+  if (queue->count == queue->capacity)
+  {
+    queue->capacity = queue->capacity ? queue->capacity*2 : 256;
+    queue->units = realloc(queue->units, sizeof(WorkUnit)*queue->capacity);
+    if (queue->units == NULL)
+    {
+      printf("ERROR: Out of memory for work queue\n");
+      exit(1);
+    }
+  }
+
+  unit = &queue->units[queue->count];
+  memset(unit, 0, sizeof(WorkUnit));
+
+  unit->id = queue->count;
+  unit->limitLength = limitLength;
+  unit->currentLength = currentLength;
+  unit->blankIndex = blankIndex;
+  unit->prevBlankIndex = prevBlankIndex;
+  unit->idx1 = idx1;
+  unit->idx2 = idx2;
+  unit->inv1 = inv1;
+  unit->inv2 = inv2;
+
+  for (int i = 0; i < PUZZLE_SIZE; i++)
+  {
+    unit->puzzle[i] = (char)puzzle[i];
+  }
+  memcpy(unit->moves, moves, currentLength);
+
+  queue->count++;
+}
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Examine a node and recursively call self to search deeper in the tree
+//
+//  Same search core as puzWD.c, on an array board with each move stepped
+//  by WalkingDistanceMove (walkDist.h), with a few changes so it can be
+//  split across threads:
+//  * The smallest f value that exceeded the limit is nominated into nextLimit.
+//  * The tile moved at each depth is recorded into solutionMoves[] on the way
+//    down instead of being printed on the way back up. When a solution is
+//    found, the array holds the full path.
+//  * When given a work queue, nodes at splitDepth are not searched. They are
+//    appended to the queue as work units for the search threads.
+//  * Nodes are counted in this thread's own counter, and the shared solution
+//    flag is polled every few thousand nodes. Once any thread has found a
+//    solution within this limit, the rest unwind with SEARCH_ABORTED.
+//  * With an endgame table (shared by all threads, read only), nodes close
+//    to the goal get their exact distance from it, as in puzWD.c.
+
+int ExamineNode(int puzzle[PUZZLE_SIZE],
+  int currentBlankIndex, int prevBlankIndex,
+  int idx1o, int idx2o, int inv1o, int inv2o,
+  int currentLength, int limitLength, int *nextLimit,
+  ThreadCounter *counter, SharedSearchState *shared,
+  char solutionMoves[MAX_SOLUTION_LENGTH], WorkQueue *queue, int splitDepth,
+  const EndgameTable *endgame, u64 packedBoard)
+{
+  if (queue != NULL && currentLength == splitDepth)
+  {
+    // Frontier node: hand it off instead of searching it here. The worker
+    // counts this node, so it is not counted here.
+    AppendWorkUnit(queue, puzzle, currentBlankIndex, prevBlankIndex,
+      idx1o, idx2o, inv1o, inv2o, currentLength, limitLength, solutionMoves);
+    return 0;
+  }
+
+  int val = HeuristicValue(idx1o, idx2o, inv1o, inv2o);
+  unsigned long long nodes = CountNode(counter);
+
+  if ((nodes & SIGNAL_POLL_MASK) == 0)
+  {
+    if (SolutionFoundWithin(shared, limitLength))
+    {
+      // Another thread already has the answer for this limit.
+      return SEARCH_ABORTED;
+    }
+
+    if ((nodes & STATUS_INTERVAL_MASK) == 0)
+    {
+      // Status update roughly every billion nodes of this thread
+      printf("Limit: %d ongoing - with %llu nodes\n", limitLength, AggregateNodeCount(shared));
+    }
+  }
+
+  if(puzzle[currentBlankIndex]!=0)
+  {
+    printf("ERROR: Blank index is not blank.\n");
+  }
+
+  if (endgame != NULL && val <= endgame->depth)
+  {
+    int distance = EndgameDistance(endgame, packedBoard);
+
+    if (distance < 0)
+    {
+      val = EndgameBound(endgame, currentBlankIndex);
+    }
+    else if (currentLength + distance <= limitLength)
+    {
+      // Problem solved, with the last moves from the endgame table.
+      char directions[MAX_SOLUTION_LENGTH];
+
+      EndgamePath(endgame, packedBoard, directions, &solutionMoves[currentLength]);
+      return currentLength + distance;
+    }
+    else
+    {
+      val = distance;
+    }
+  }
+
+  if (val == 0)
+  {
+    // Problem solved!
+    return currentLength;
+  }
+  else if (currentLength + val > limitLength)
+  {
+    // Exceeded limit
+    if (*nextLimit > currentLength+val)
+    {
+      // Nominate our length+heuristic value as next highest limit
+      *nextLimit = currentLength+val;
+    }
+    return 0;
+  }
+  else
+  {
+    // Not terminating, so let's dig deeper
+    int ret=0, childBlankIndex=0;
+    int idx1, idx2, inv1, inv2;
+
+    for (int i = 0; i < 4; i++)
+    {
+      // Reset indices between iterations
+      idx1 = idx1o;
+      idx2 = idx2o;
+      inv1 = inv1o;
+      inv2 = inv2o;
+
+      childBlankIndex = WalkingDistanceMove(puzzle, currentBlankIndex, i,
+        &idx1, &idx2, &inv1, &inv2);
+
+      if (childBlankIndex < 0)
+      {
+        // That move would leave the board.
+        continue;
+      }
+
+      if(childBlankIndex == prevBlankIndex)
+      {
+        // This retracts the move our parent just did, no point.
+        continue;
+      }
+
+      // Record the tile we're about to move
+      solutionMoves[currentLength] = (char)puzzle[childBlankIndex];
+
+      // Perform the swap
+      puzzle[currentBlankIndex] = puzzle[childBlankIndex];
+      puzzle[childBlankIndex] = 0;
+
+      // Recursive call to look at the next node
+      ret = ExamineNode(puzzle, 
+        childBlankIndex, currentBlankIndex,
+        idx1, idx2, inv1, inv2,
+        currentLength+1, limitLength, nextLimit, counter, shared,
+        solutionMoves, queue, splitDepth,
+        endgame, PackedMove(packedBoard, childBlankIndex, currentBlankIndex));
+
+      // Revert the swap
+      puzzle[childBlankIndex] = puzzle[currentBlankIndex];
+      puzzle[currentBlankIndex] = 0;
+
+      // Did the child find anything? (Or was told to stop looking?)
+      if (ret != 0)
+      {
+        return ret;
+      }
+    }
+
+    // None of the four directions proved fruitful
+    return 0;
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Everything a search thread needs for one IDA* iteration. The work list
+//  and shared state are common to all threads, the rest is per thread.
+
+typedef struct
+{
+  int threadIndex;
+  WorkQueue *queue;
+  _Atomic int *nextUnit;
+  SharedSearchState *shared;
+  const EndgameTable *endgame;
+  char *solutionMoves;        // Shared, written only by the winning thread.
+  char moves[MAX_SOLUTION_LENGTH];
+} SearchThread;
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Search thread body: claim work units one at a time until the list is
+//  exhausted or some thread has found a solution.
+
+void *SearchWorkUnits(void *parameter)
+{
+  SearchThread *thread = parameter;
+  ThreadCounter *counter = &thread->shared->counters[thread->threadIndex];
+  int puzzle[PUZZLE_SIZE];
+  int nextLimit;
+  int length;
+  int unitIndex;
+  WorkUnit *unit;
+  uint64_t traceBegin;
+
+  TraceBindThread(thread->threadIndex + 1, "search");
+
+  while ((unitIndex = atomic_fetch_add(thread->nextUnit, 1)) < thread->queue->count)
+  {
+    unit = &thread->queue->units[unitIndex];
+
+    if (SolutionFoundWithin(thread->shared, unit->limitLength))
+    {
+      break;
+    }
+
+    for (int i = 0; i < PUZZLE_SIZE; i++)
+    {
+      puzzle[i] = unit->puzzle[i];
+    }
+    memcpy(thread->moves, unit->moves, unit->currentLength);
+    nextLimit = NOTHING_RECORDED;
+    traceBegin = TraceBegin();
+
+    length = ExamineNode(puzzle,
+      unit->blankIndex, unit->prevBlankIndex,
+      unit->idx1, unit->idx2, unit->inv1, unit->inv2,
+      unit->currentLength, unit->limitLength, &nextLimit,
+      counter, thread->shared, thread->moves, NULL /* queue */, 0,
+      thread->endgame, PackBoard(puzzle));
+    TraceEnd(traceBegin, "search", "unit", "unit", unitIndex);
+
+    // One atomic minimum per work unit, not per node.
+    NominateNextLimit(thread->shared, nextLimit);
+
+    if (length > 0 && RecordSolution(thread->shared, length))
+    {
+      memcpy(thread->solutionMoves, thread->moves, length);
+    }
+  }
+
+  return NULL;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Execute the IDA* algorithm on the given puzzle state. Each iteration the
+//  main thread searches the tree down to splitDepth, then the search threads
+//  split the frontier below that between them. Returns the solution length,
+//  with the tiles moved in moves and the node count in nodesSearched. With
+//  verbose FALSE it prints nothing, for batch runs. The counters, if any,
+//  must have been opened to inherit, so they take in the search threads
+//  once they are joined.
+//
+int IDAStar(int puzzle[PUZZLE_SIZE], int threadCount, int splitDepth,
+  const EndgameTable *endgame, int verbose, const PerfCounters *counters,
+  char moves[MAX_SOLUTION_LENGTH], unsigned long long *nodesSearched)
+{
+  unsigned long long nodesTotal=0;
+  unsigned long long nodesAtLimit = 0;
+  int length = 0;
+  int idx1, idx2, inv1, inv2;
+  int limit = HeuristicLookupIndices(puzzle, &idx1, &idx2, &inv1, &inv2);
+  int nextLimit;
+  char solutionMoves[MAX_SOLUTION_LENGTH];
+  WorkQueue queue = { NULL, 0, 0 };
+  _Atomic int nextUnit;
+  SearchThread threads[MAX_THREADS];
+  pthread_t threadIds[MAX_THREADS];
+  uint64_t iterationBegin, traceBegin;
+  PerfSample searchStart, iterationStart, sample;
+
+  SharedSearchState *shared = CreateSharedSearchState(threadCount);
+  int blankIndex = GetBlankPosition(puzzle);
+
+  if (shared == NULL)
+  {
+    printf("ERROR: Out of memory for shared search state\n");
+    exit(1);
+  }
+
+  PerfRead(counters, &searchStart);
+
+  if (limit > 0)
+  {
+    while (1)
+    {
+      PerfRead(counters, &iterationStart);
+      queue.count = 0;
+      nextLimit = NOTHING_RECORDED;
+      ResetSharedSearchState(shared);
+      iterationBegin = traceBegin = TraceBegin();
+
+      // Search the top of the tree on this thread, collecting the frontier
+      // as work units. Counted against thread 0, which isn't running yet.
+      length = ExamineNode(puzzle,
+                 blankIndex, -1 /* prevBlankIndex */,
+                 idx1, idx2, inv1, inv2,
+                 0 /* Starting length */, limit, &nextLimit,
+                 &shared->counters[0], shared, solutionMoves, &queue, splitDepth,
+                 endgame, PackBoard(puzzle));
+      NominateNextLimit(shared, nextLimit);
+      TraceEnd(traceBegin, "search", "expand top", "units", queue.count);
+
+      if (length == 0 && queue.count > 0)
+      {
+        atomic_store(&nextUnit, 0);
+
+        for (int i = 0; i < threadCount; i++)
+        {
+          threads[i].threadIndex = i;
+          threads[i].queue = &queue;
+          threads[i].nextUnit = &nextUnit;
+          threads[i].shared = shared;
+          threads[i].endgame = endgame;
+          threads[i].solutionMoves = solutionMoves;
+
+          if (pthread_create(&threadIds[i], NULL, SearchWorkUnits, &threads[i]) != 0)
+          {
+            printf("ERROR: Unable to start search thread %d\n", i);
+            exit(1);
+          }
+        }
+
+        // Joining the threads is the barrier between iterations.
+        traceBegin = TraceBegin();
+        for (int i = 0; i < threadCount; i++)
+        {
+          pthread_join(threadIds[i], NULL);
+        }
+        TraceEnd(traceBegin, "sync", "barrier", "threads", threadCount);
+
+        length = atomic_load(&shared->solutionLength);
+        if (length == NOTHING_RECORDED)
+        {
+          length = 0;
+        }
+      }
+
+      nodesAtLimit = AggregateNodeCount(shared);
+      TraceEnd(iterationBegin, "search", "iteration", "limit", limit);
+      PerfRead(counters, &sample);
+
+      if (length != 0)
+      {
+        break;
+      }
+
+      if (verbose)
+      {
+        printf("Limit: %d completed with %llu nodes\n", limit, nodesAtLimit);
+        PerfPrint(counters, "  per node", &iterationStart, &sample, nodesAtLimit);
+      }
+      nodesTotal += nodesAtLimit;
+      limit = atomic_load(&shared->nextLimit);
+    }
+
+    if (verbose)
+    {
+      printf("\nTile movements to arrive in this state:\n");
+      for (int i = length-1; i >= 0; i--)
+      {
+        printf(" %d", solutionMoves[i]);
+      }
+      printf("\n");
+
+      printf("\n\nLimit: %d halted at %llu nodes\n", limit, nodesAtLimit);
+      PerfPrint(counters, "  per node", &iterationStart, &sample, nodesAtLimit);
+    }
+
+    nodesTotal += nodesAtLimit;
+    memcpy(moves, solutionMoves, length);
+  }
+
+  if (verbose)
+  {
+    printf("\n\nSolution of length %d found after searching %llu nodes\n", length, nodesTotal);
+    PerfPrint(counters, "Split IDA* per node", &searchStart, &sample, nodesTotal);
+  }
+
+  *nodesSearched = nodesTotal;
+
+  free(queue.units);
+  FreeSharedSearchState(shared);
+
+  return length;
+}
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Batch solving with a predictive scheduler.
+//
+//  In a large batch a few long puzzles take most of the time. If one of
+//  them is started last, every other thread sits idle while it finishes.
+//  So every puzzle is first probed: its first few IDA* iterations are
+//  searched on one thread, stopping before an iteration that looks like it
+//  would pass PROBE_NODES. Each iteration searches several times as many
+//  nodes as the one before, and that growth ratio stays fairly steady for
+//  a puzzle, so the probe gives a prediction of the full search:
+//
+//    the last iteration's nodes times growth^i, summed over the iterations
+//    still to go, up to the initial bound plus SOLUTION_GAP.
+//
+//  Then the puzzles predicted to take more than a thread's fair share of
+//  the total are solved one at a time, each split across all the threads
+//  by IDAStar. The rest go to the threads one puzzle each, longest first,
+//  carrying on from where their probe stopped. Most puzzles in a batch of
+//  medium ones are solved by the probe outright.
+//
+//  The weak point is the solution length. Given the true length, this
+//  extrapolation ranks the puzzles of batch-random100 almost exactly in
+//  order of their real cost, but the gap between the bound and the length
+//  varies from 4 to 22, and a few early iterations say next to nothing
+//  about it. So the order is only a rough one, and the split into shared
+//  and single-thread puzzles matters more than the sort.
+
+// A probe stops before an iteration predicted to search more than this.
+#define PROBE_NODES (1ULL << 20)
+
+// Growth ratio assumed when the probe only completed one iteration.
+#define DEFAULT_GROWTH 8.0
+
+// Typical optimal length minus initial Walking Distance bound. On
+// batch-random100 the mean is 13.4 and the most common value 14.
+#define SOLUTION_GAP 14
+
+typedef struct
+{
+  int line;
+  int puzzle[PUZZLE_SIZE];
+  int bound;                  // Initial heuristic value.
+  int limit;                  // Next limit to search.
+  unsigned long long lastNodes, previousNodes;  // Last two iterations.
+  unsigned long long probeNodes;
+  double predicted;           // Nodes, for unsolved puzzles after the probe.
+  int split;                  // Solved across all threads.
+  int solved;
+  int length;
+  unsigned long long nodes;
+  char moves[MAX_SOLUTION_LENGTH];
+} BatchJob;
+
+typedef struct
+{
+  BatchJob *jobs;
+  int *order;                 // Indices of the jobs to work through.
+  int count;
+  _Atomic int next;
+  _Atomic int nextSlot;       // Next trace slot for a started thread.
+  const EndgameTable *endgame;
+  unsigned long long budget;  // 0 to search until solved.
+} BatchPool;
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Search a job's iterations on this thread, from where it last stopped.
+//  With a budget, stop before an iteration whose predicted node count
+//  would pass it. Returns TRUE once solved.
+
+int SolveJobSerial(BatchJob *job, SharedSearchState *shared,
+  const EndgameTable *endgame, unsigned long long budget)
+{
+  int idx1, idx2, inv1, inv2;
+  int blankIndex = GetBlankPosition(job->puzzle);
+  int nextLimit, length;
+  unsigned long long nodes;
+
+  HeuristicLookupIndices(job->puzzle, &idx1, &idx2, &inv1, &inv2);
+
+  while (!job->solved)
+  {
+    if (budget != 0 && job->previousNodes > 0 &&
+        job->lastNodes * ((double)job->lastNodes / job->previousNodes) > budget)
+    {
+      return FALSE;
+    }
+
+    ResetSharedSearchState(shared);
+    nextLimit = NOTHING_RECORDED;
+
+    length = ExamineNode(job->puzzle, blankIndex, -1,
+      idx1, idx2, inv1, inv2, 0, job->limit, &nextLimit,
+      &shared->counters[0], shared, job->moves, NULL, 0,
+      endgame, PackBoard(job->puzzle));
+
+    nodes = AggregateNodeCount(shared);
+    job->nodes += nodes;
+
+    if (length > 0)
+    {
+      job->length = length;
+      job->solved = TRUE;
+    }
+    else
+    {
+      job->previousNodes = job->lastNodes;
+      job->lastNodes = nodes;
+      job->limit = nextLimit;
+    }
+  }
+
+  return TRUE;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Thread body for the probe and the serial phase: claim jobs in order
+//  until there are none left.
+
+void *BatchWorker(void *parameter)
+{
+  BatchPool *pool = parameter;
+  SharedSearchState *shared = CreateSharedSearchState(1);
+  BatchJob *job;
+  uint64_t traceBegin;
+  int index;
+
+  if (shared == NULL)
+  {
+    printf("ERROR: Out of memory for shared search state\n");
+    exit(1);
+  }
+
+  TraceBindThread(atomic_fetch_add(&pool->nextSlot, 1), "batch");
+
+  while ((index = atomic_fetch_add(&pool->next, 1)) < pool->count)
+  {
+    job = &pool->jobs[pool->order[index]];
+    traceBegin = TraceBegin();
+    SolveJobSerial(job, shared, pool->endgame, pool->budget);
+    TraceEnd(traceBegin, "search", pool->budget ? "probe" : "solve", "line", job->line);
+  }
+
+  FreeSharedSearchState(shared);
+
+  return NULL;
+}
+
+void RunBatchPool(BatchPool *pool, int threadCount)
+{
+  pthread_t threadIds[MAX_THREADS];
+  uint64_t traceBegin = TraceBegin();
+
+  atomic_store(&pool->next, 0);
+  atomic_store(&pool->nextSlot, 1);
+
+  for (int i = 0; i < threadCount; i++)
+  {
+    if (pthread_create(&threadIds[i], NULL, BatchWorker, pool) != 0)
+    {
+      printf("ERROR: Unable to start batch thread %d\n", i);
+      exit(1);
+    }
+  }
+
+  for (int i = 0; i < threadCount; i++)
+  {
+    pthread_join(threadIds[i], NULL);
+  }
+  TraceEnd(traceBegin, "sync", pool->budget ? "probe phase" : "serial phase", "jobs", pool->count);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Predicted nodes still to search for a probed job.
+
+double PredictJobCost(const BatchJob *job)
+{
+  double growth = DEFAULT_GROWTH;
+  double iteration = job->lastNodes;
+  double total = 0;
+  int expected = job->bound + SOLUTION_GAP;
+
+  if (job->previousNodes > 0 && job->lastNodes > job->previousNodes)
+  {
+    growth = (double)job->lastNodes / job->previousNodes;
+  }
+
+  if (expected < job->limit)
+  {
+    expected = job->limit;
+  }
+
+  // Limits go up by two: every move changes the heuristic's parity.
+  for (int limit = job->limit; limit <= expected; limit += 2)
+  {
+    iteration *= growth;
+    total += iteration;
+  }
+
+  return total;
+}
+
+typedef struct
+{
+  double predicted;
+  int index;
+} ScheduleEntry;
+
+// Largest prediction first.
+int CompareByPrediction(const void *a, const void *b)
+{
+  double pa = ((const ScheduleEntry *)a)->predicted;
+  double pb = ((const ScheduleEntry *)b)->predicted;
+
+  return (pa < pb) - (pa > pb);
+}
+
+double SecondsSince(const struct timespec *start)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Solve every puzzle line of a file. Bad lines are reported and skipped.
+//  The results are printed in input order at the end. Returns FALSE if
+//  the file can't be read.
+
+int SolveBatch(const char *path, int threadCount, int splitDepth, const EndgameTable *endgame)
+{
+  PuzzleInput input;
+  ParseStatus status;
+  BatchJob *jobs = NULL;
+  ScheduleEntry *schedule;
+  BatchPool pool;
+  struct timespec start;
+  double probeSeconds, splitSeconds, totalPredicted = 0;
+  int count = 0, capacity = 0, errors = 0, probed = 0, splitCount = 0, serialCount = 0;
+  int puzzle[PUZZLE_SIZE];
+  int idx1, idx2, inv1, inv2;
+  int *order;
+  uint64_t traceBegin = TraceBegin();
+
+  if (OpenPuzzleInput(&input, path) != 0)
+  {
+    printf("ERROR: Unable to read %s\n", path);
+    return FALSE;
+  }
+
+  while ((status = NextPuzzle(&input, puzzle)) != PARSE_END)
+  {
+    if (status != PARSE_OK)
+    {
+      printf("ERROR: Line %d: %s\n", input.line, ParseStatusText(status));
+      if (status == PARSE_READ_ERROR)
+      {
+        break;
+      }
+      errors++;
+      continue;
+    }
+
+    if (count == capacity)
+    {
+      capacity = capacity ? capacity*2 : 256;
+      jobs = realloc(jobs, sizeof(BatchJob)*capacity);
+      if (jobs == NULL)
+      {
+        printf("ERROR: Out of memory for batch\n");
+        exit(1);
+      }
+    }
+
+    memset(&jobs[count], 0, sizeof(BatchJob));
+    jobs[count].line = input.line;
+    memcpy(jobs[count].puzzle, puzzle, sizeof(puzzle));
+    count++;
+  }
+  ClosePuzzleInput(&input);
+  TraceEnd(traceBegin, "io", "read input", "puzzles", count);
+
+  printf("%d puzzles, %d threads\n", count, threadCount);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  order = malloc(sizeof(int) * (count + 1));
+  schedule = malloc(sizeof(ScheduleEntry) * (count + 1));
+  if (order == NULL || schedule == NULL)
+  {
+    printf("ERROR: Out of memory for batch of %d puzzles\n", count);
+    exit(1);
+  }
+
+  // Probe, in input order.
+  for (int i = 0; i < count; i++)
+  {
+    BatchJob *job = &jobs[i];
+
+    job->bound = job->limit = HeuristicLookupIndices(job->puzzle, &idx1, &idx2, &inv1, &inv2);
+    job->solved = (job->bound == 0);
+    order[i] = i;
+  }
+
+  pool.jobs = jobs;
+  pool.order = order;
+  pool.count = count;
+  pool.endgame = endgame;
+  pool.budget = PROBE_NODES;
+  RunBatchPool(&pool, threadCount);
+  probeSeconds = SecondsSince(&start);
+
+  for (int i = 0; i < count; i++)
+  {
+    jobs[i].probeNodes = jobs[i].nodes;
+    if (!jobs[i].solved)
+    {
+      jobs[i].predicted = PredictJobCost(&jobs[i]);
+      totalPredicted += jobs[i].predicted;
+      schedule[probed].predicted = jobs[i].predicted;
+      schedule[probed].index = i;
+      probed++;
+    }
+  }
+
+  qsort(schedule, probed, sizeof(ScheduleEntry), CompareByPrediction);
+  for (int i = 0; i < probed; i++)
+  {
+    order[i] = schedule[i].index;
+  }
+
+  // The biggest ones, split across all the threads, one at a time.
+  while (splitCount < probed && threadCount > 1 &&
+         jobs[order[splitCount]].predicted > totalPredicted / threadCount)
+  {
+    BatchJob *job = &jobs[order[splitCount]];
+    unsigned long long nodes;
+
+    traceBegin = TraceBegin();
+    job->length = IDAStar(job->puzzle, threadCount, splitDepth, endgame, FALSE, NULL, job->moves, &nodes);
+    TraceEnd(traceBegin, "search", "split solve", "line", job->line);
+    job->nodes = nodes;
+    job->split = TRUE;
+    job->solved = TRUE;
+    splitCount++;
+  }
+  splitSeconds = SecondsSince(&start) - probeSeconds;
+
+  // The rest one per thread, longest first.
+  serialCount = probed - splitCount;
+  pool.order = order + splitCount;
+  pool.count = serialCount;
+  pool.budget = 0;
+  RunBatchPool(&pool, threadCount);
+
+  for (int i = 0; i < count; i++)
+  {
+    BatchJob *job = &jobs[i];
+
+    printf("\nLine %d: length %d, %llu nodes", job->line, job->length, job->nodes);
+    if (job->predicted > 0)
+    {
+      printf(", predicted %.0f more after a %llu node probe%s",
+        job->predicted, job->probeNodes, job->split ? ", split" : "");
+    }
+    printf("\n");
+    for (int m = job->length - 1; m >= 0; m--)
+    {
+      printf(" %d", job->moves[m]);
+    }
+    printf("\n");
+  }
+
+  printf("\nBatch complete: %d puzzles solved, %d lines rejected, %.2f s\n",
+    count, errors, SecondsSince(&start));
+  printf("  %d solved by the probe (%.2f s), %d split across threads (%.2f s), %d one per thread (%.2f s)\n",
+    count - probed, probeSeconds, splitCount, splitSeconds, serialCount,
+    SecondsSince(&start) - probeSeconds - splitSeconds);
+
+  free(schedule);
+  free(order);
+  free(jobs);
+
+  return TRUE;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Read in puzzle state from user input: the first puzzle on standard
+//  input, in any of the formats puzInput.h accepts, on one line or spread
+//  over several. Returns FALSE if there is no valid puzzle to solve,
+//  instead of asking again.
+//
+
+int ReadPuzzleFromInput(int* puzzle)
+{
+  PuzzleInput input;
+  ParseStatus status;
+
+  printf("Enter the starting configuration for the puzzle:\n");
+  fflush(stdout);
+
+  if (OpenPuzzleInput(&input, NULL) != 0)
+  {
+    printf("ERROR: %s\n", ParseStatusText(PARSE_READ_ERROR));
+    return FALSE;
+  }
+
+  status = NextPuzzleAcrossLines(&input, puzzle);
+  ClosePuzzleInput(&input);
+
+  if (status != PARSE_OK)
+  {
+    printf("ERROR: Line %d: %s\n", input.line, ParseStatusText(status));
+    return FALSE;
+  }
+
+  printf("\nThe input received were as follows:\n\n");
+
+  PrintPuzzle(puzzle);
+
+  return TRUE;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Main
+//
+
+int main(int argc, char *argv[])
+{
+  int puzzle[PUZZLE_SIZE];
+  int idx1, idx2, inv1, inv2;
+  int threadCount = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  int splitDepth = DEFAULT_SPLIT_DEPTH;
+  int endgameDepth = 0;
+  int endgameMegabytes = DEFAULT_ENDGAME_MEGABYTES;
+  EndgameTable endgameStore;
+  EndgameTable *endgame = NULL;
+  const char *batchPath = NULL;
+  char moves[MAX_SOLUTION_LENGTH];
+  unsigned long long nodes;
+  const char *tracePath = NULL;
+  uint64_t traceBegin;
+  int useCounters = FALSE;
+  PerfCounters counterStore;
+  PerfCounters *counters = NULL;
+  int ok;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-t") == 0 && i+1 < argc)
+    {
+      threadCount = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-d") == 0 && i+1 < argc)
+    {
+      splitDepth = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-endgame") == 0 && i+1 < argc)
+    {
+      endgameDepth = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-endmem") == 0 && i+1 < argc)
+    {
+      endgameMegabytes = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-batch") == 0 && i+1 < argc)
+    {
+      batchPath = argv[++i];
+    }
+    else if (strcmp(argv[i], "-trace") == 0 && i+1 < argc)
+    {
+      tracePath = argv[++i];
+    }
+    else if (strcmp(argv[i], "-counters") == 0)
+    {
+      useCounters = TRUE;
+    }
+    else
+    {
+      printf("Usage: %s [-t threads] [-d splitDepth] [-endgame depth [-endmem megabytes]] [-batch file]\n", argv[0]);
+      printf("       [-trace file] [-counters]\n");
+      return 1;
+    }
+  }
+
+  if (threadCount < 1 || threadCount > MAX_THREADS || splitDepth < 1)
+  {
+    printf("Thread count must be 1 to %d and split depth at least 1\n", MAX_THREADS);
+    return 1;
+  }
+
+  if (useCounters && batchPath != NULL)
+  {
+    printf("-counters prints per iteration, which -batch doesn't\n");
+    return 1;
+  }
+
+  // One trace slot for the main thread and one for each search thread.
+  if (tracePath != NULL && !TraceStart(threadCount + 1))
+  {
+    printf("ERROR: Out of memory for trace\n");
+    return 1;
+  }
+
+  traceBegin = TraceBegin();
+  GenerateWalkingDistanceLookup();
+  TraceEnd(traceBegin, "tables", "walking distance", NULL, 0);
+
+  if (endgameDepth > 0)
+  {
+    traceBegin = TraceBegin();
+    if (BuildEndgameTable(&endgameStore, endgameDepth, (size_t)endgameMegabytes << 20) != 0)
+    {
+      printf("ERROR: Out of memory for endgame table\n");
+      return 1;
+    }
+    endgame = &endgameStore;
+    TraceEnd(traceBegin, "tables", "endgame", "depth", endgame->depth);
+    printf("Endgame table complete to depth %d with %llu states\n\n",
+      endgame->depth, (unsigned long long)endgame->count);
+  }
+
+  if (batchPath != NULL)
+  {
+    ok = SolveBatch(batchPath, threadCount, splitDepth, endgame);
+  }
+  else if (!ReadPuzzleFromInput(puzzle))
+  {
+    return 1;
+  }
+  else
+  {
+    printf("Initial heuristic value of %d\n\n", HeuristicLookupIndices(puzzle, &idx1, &idx2, &inv1, &inv2));
+    printf("Searching with %d threads below depth %d\n\n", threadCount, splitDepth);
+
+    if (useCounters && PerfOpen(&counterStore, TRUE))
+    {
+      counters = &counterStore;
+    }
+
+    IDAStar(puzzle, threadCount, splitDepth, endgame, TRUE, counters, moves, &nodes);
+    ok = TRUE;
+
+    if (counters != NULL)
+    {
+      PerfClose(counters);
+    }
+  }
+
+  if (endgame != NULL)
+  {
+    FreeEndgameTable(endgame);
+  }
+
+  if (tracePath != NULL && !TraceWrite(tracePath))
+  {
+    perror(tracePath);
+    ok = FALSE;
+  }
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,988 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Sliding tile puzzle solver using IDA* search with additive pattern
+//  databases, as built by pdbBuild.c.
+//
+//  The heuristic is the sum of the loaded tables' values, plus the
+//  Manhattan Distance of any tile that isn't in one of them. Each table only
+//  counts moves of its own tiles, and the Manhattan Distance of a tile only
+//  counts that tile's, so the sum never overestimates as long as no tile is
+//  in two tables. With no tables at all it is plain Manhattan Distance.
+//
+//  A move only changes one tile, so each node looks up just the table that
+//  tile belongs to. The search keeps every table's current value, and the
+//  Manhattan Distance of its tiles, and updates only the one that changed.
+//  How the entry becomes a value depends on the table's encoding (pdb.h):
+//  as it is, as steps above that Manhattan Distance, or as one up or down
+//  from the value before the move. A move of a tile outside a mod 3 table
+//  doesn't change its value, even though the blank moved.
+//
+//  With -epe the search does partial expansion (EPEIDA*): a child whose f
+//  would be over the limit is never entered, only counted towards the next
+//  limit. For a tile outside the tables the change in value comes from an
+//  operator selection table, keyed on the tile, the blank position and the
+//  direction, before anything is moved. A table tile's move still has to be
+//  made to look up its new value, but the child isn't entered.
+//
+//  Symmetric lookups (symmetry.h) take the most of several values for the
+//  same board, from the same tables. -reflect adds the tables' value for the
+//  board reflected across the diagonal, kept up to date move by move like
+//  the board's own. -dual adds the value for the dual board, worked out in
+//  full, so only for nodes the cheaper lookups haven't cut off. -dualsearch
+//  also jumps to the dual (DIDA*) wherever the blank is home and the dual's
+//  value is higher, and carries on searching from there. The moves found
+//  from a dual then solve the dual, not the board, so they are turned back
+//  round once the search is over (PrintDualSearchSolution).
+//
+//  Usage: puzPDB [-pdb file]... [-batch file] [-epe] [-reflect] [-dual] [-dualsearch]
+//                [-counters]
+//
+//  The 6-6-3 split used in the README is built with:
+//    pdbBuild -tiles 1,2,5,6,9,13 -o pdb663a
+//    pdbBuild -tiles 3,4,7,8,11,12 -o pdb663b
+//    pdbBuild -tiles 10,14,15 -o pdb663c
+//
+//  Any of those can add -encoding nibble or mod3, and -compress 2 to 16.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "puzInput.h"
+#include "pdb.h"
+#include "symmetry.h"
+#include "counters.h"
+
+#define PUZZLE_COLUMN 4
+#define PUZZLE_ROW 4
+#define PUZZLE_SIZE (PUZZLE_COLUMN * PUZZLE_ROW)
+
+#define FALSE 0
+#define TRUE 1
+
+#define MAX_PATTERNS PUZZLE_SIZE
+
+// Deepest the search goes.
+#define MAX_DEPTH 256
+
+// Symmetric lookups, as flags.
+#define LOOKUP_REFLECT 1        // -reflect
+#define LOOKUP_DUAL 2           // -dual
+#define LOOKUP_DUAL_SEARCH 4    // -dualsearch, which includes -dual
+
+// The search variants, each a copy of ExamineBody with these as constants.
+#define VARIANT_PARTIAL 1       // Partial expansion (-epe).
+#define VARIANT_SYMMETRIC 2     // Any symmetric lookups.
+#define VARIANT_COUNT 4
+
+// Status lines are printed every 2^30 (about a billion) nodes.
+#define STATUS_INTERVAL_MASK ((1ULL << 30) - 1)
+
+typedef struct
+{
+  PatternDatabase pdbs[MAX_PATTERNS];
+  int patternCount;
+  int owner[PUZZLE_SIZE];               // Table holding each tile, -1 for none.
+  int manhattan[PUZZLE_SIZE][PUZZLE_SIZE];
+  // Change in Manhattan Distance when the tile moves into the blank from the
+  // given direction (up, down, left, right of the blank).
+  signed char manhattanChange[PUZZLE_SIZE][PUZZLE_SIZE][4];
+  int reflectTile[PUZZLE_SIZE];         // Each tile's number once reflected.
+} Heuristic;
+
+typedef struct
+{
+  const Heuristic *heuristic;
+  int puzzle[PUZZLE_SIZE];
+  int position[PUZZLE_SIZE];            // Where each tile is.
+  int part[MAX_PATTERNS];               // Current value of each table.
+  int manhattan[MAX_PATTERNS];          // Manhattan Distance of its tiles.
+  int limitLength;
+  int nextLimit;
+  unsigned long long nodeCounter;
+  int lookups;                          // LOOKUP_ flags.
+  // The reflected board's tile positions, tables and value, with -reflect.
+  int reflectPosition[PUZZLE_SIZE];
+  int reflectPart[MAX_PATTERNS];
+  int reflectManhattan[MAX_PATTERNS];
+  int reflectValue;
+  // With -dualsearch, the move made at each depth of the current path, and
+  // whether the node there jumped to its dual first.
+  char moves[MAX_DEPTH];
+  char jumped[MAX_DEPTH];
+} SearchState;
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Print the puzzle state to stdout
+
+void PrintPuzzle(int puzzle[PUZZLE_SIZE])
+{
+  for (int i = 0; i < PUZZLE_ROW; i++)
+  {
+    for (int j = 0; j < PUZZLE_COLUMN; j++)
+    {
+      printf("%3d", puzzle[(i*PUZZLE_COLUMN) + j]);
+    }
+    printf("\n");
+  }
+
+  printf("\n");
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Load the tables and work out which tiles fall back to Manhattan
+//  Distance. Returns FALSE if a table can't be loaded or shares a tile
+//  with another.
+
+int LoadHeuristic(Heuristic *heuristic, const char **paths, int pathCount)
+{
+  memset(heuristic, 0, sizeof(Heuristic));
+
+  for (int tile = 0; tile < PUZZLE_SIZE; tile++)
+  {
+    heuristic->owner[tile] = -1;
+  }
+
+  for (int p = 0; p < pathCount; p++)
+  {
+    PatternDatabase *pdb = &heuristic->pdbs[p];
+
+    if (LoadPatternDatabase(paths[p], pdb) != 0)
+    {
+      printf("ERROR: Unable to load pattern database %s\n", paths[p]);
+      return FALSE;
+    }
+    heuristic->patternCount++;
+
+    printf("Pattern database %s (%s", paths[p], PdbEncodingName(pdb->encoding));
+    if (pdb->compressionShift > 0)
+    {
+      printf(", compressed %d to 1", 1 << pdb->compressionShift);
+    }
+    printf(", %.1f MB):", pdb->dataBytes / 1048576.0);
+    for (int i = 0; i < pdb->tileCount; i++)
+    {
+      int tile = pdb->tiles[i];
+
+      if (heuristic->owner[tile] >= 0)
+      {
+        printf("\nERROR: Tile %d is in more than one pattern database\n", tile);
+        return FALSE;
+      }
+      heuristic->owner[tile] = p;
+      printf(" %d", tile);
+    }
+    printf("\n");
+  }
+
+  for (int tile = 1; tile < PUZZLE_SIZE; tile++)
+  {
+    int goal = tile - 1;
+
+    for (int position = 0; position < PUZZLE_SIZE; position++)
+    {
+      heuristic->manhattan[tile][position] =
+        abs(goal % PUZZLE_COLUMN - position % PUZZLE_COLUMN) +
+        abs(goal / PUZZLE_COLUMN - position / PUZZLE_COLUMN);
+    }
+  }
+
+  for (int tile = 1; tile < PUZZLE_SIZE; tile++)
+  {
+    for (int blank = 0; blank < PUZZLE_SIZE; blank++)
+    {
+      static const int offset[4] = { -PUZZLE_COLUMN, PUZZLE_COLUMN, -1, 1 };
+
+      for (int i = 0; i < 4; i++)
+      {
+        int from = blank + offset[i];
+
+        if (from >= 0 && from < PUZZLE_SIZE &&
+            (i < 2 || from / PUZZLE_COLUMN == blank / PUZZLE_COLUMN))
+        {
+          heuristic->manhattanChange[tile][blank][i] =
+            (signed char)(heuristic->manhattan[tile][blank] - heuristic->manhattan[tile][from]);
+        }
+      }
+    }
+  }
+
+  for (int tile = 0; tile < PUZZLE_SIZE; tile++)
+  {
+    heuristic->reflectTile[tile] = SymmetryTileOf(SymmetryTranspose(SymmetryHome(tile)));
+  }
+
+  return TRUE;
+}
+
+void FreeHeuristic(Heuristic *heuristic)
+{
+  for (int p = 0; p < heuristic->patternCount; p++)
+  {
+    FreePatternDatabase(&heuristic->pdbs[p]);
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  A table's value from its entry. manhattan is the Manhattan Distance of
+//  the table's tiles, and parentPart its value before the move (only used
+//  by mod 3 tables). The encoding is the same on every call for a table,
+//  so the branch is well predicted.
+
+static inline int PatternPart(const PatternDatabase *pdb, int entry, int manhattan, int parentPart)
+{
+  switch (pdb->encoding)
+  {
+    case PDB_ENCODING_NIBBLE:
+      return manhattan + 2 * entry;
+
+    case PDB_ENCODING_MOD3:
+      return DecodeMod3(parentPart, entry);
+  }
+
+  return entry;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  The heuristic value of the board with the tiles at the given positions,
+//  with each table's value and the Manhattan Distance of its tiles filled
+//  in. Returns -1 if a table turns out to be damaged.
+
+int BoardValue(const Heuristic *heuristic, const int position[PUZZLE_SIZE],
+  int part[MAX_PATTERNS], int manhattan[MAX_PATTERNS])
+{
+  int value = 0;
+
+  memset(manhattan, 0, MAX_PATTERNS * sizeof(int));
+
+  for (int tile = 1; tile < PUZZLE_SIZE; tile++)
+  {
+    int distance = heuristic->manhattan[tile][position[tile]];
+
+    if (heuristic->owner[tile] < 0)
+    {
+      value += distance;
+    }
+    else
+    {
+      manhattan[heuristic->owner[tile]] += distance;
+    }
+  }
+
+  for (int p = 0; p < heuristic->patternCount; p++)
+  {
+    const PatternDatabase *pdb = &heuristic->pdbs[p];
+
+    if (pdb->encoding == PDB_ENCODING_MOD3)
+    {
+      part[p] = Mod3Value(pdb, position);
+      if (part[p] < 0)
+      {
+        printf("ERROR: No way down to the goal in mod 3 pattern database %d\n", p + 1);
+        return -1;
+      }
+    }
+    else
+    {
+      part[p] = PatternPart(pdb, PatternEntry(pdb, PatternIndex(pdb, position)), manhattan[p], 0);
+    }
+    value += part[p];
+  }
+
+  return value;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Put a board in the search state, reflection included, and return its
+//  heuristic value, or -1 if a table turns out to be damaged.
+
+int SetBoard(SearchState *state, const int puzzle[PUZZLE_SIZE])
+{
+  for (int i = 0; i < PUZZLE_SIZE; i++)
+  {
+    state->puzzle[i] = puzzle[i];
+    state->position[puzzle[i]] = i;
+  }
+
+  if (state->lookups & LOOKUP_REFLECT)
+  {
+    int reflected[PUZZLE_SIZE];
+
+    ReflectBoard(puzzle, reflected);
+    for (int i = 0; i < PUZZLE_SIZE; i++)
+    {
+      state->reflectPosition[reflected[i]] = i;
+    }
+    state->reflectValue = BoardValue(state->heuristic, state->reflectPosition,
+                                     state->reflectPart, state->reflectManhattan);
+    if (state->reflectValue < 0)
+    {
+      return -1;
+    }
+  }
+
+  return BoardValue(state->heuristic, state->position, state->part, state->manhattan);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Set up the search state for a puzzle and return its heuristic value,
+//  or -1 if a table turns out to be damaged.
+
+int InitSearchState(SearchState *state, const Heuristic *heuristic, int lookups,
+  int puzzle[PUZZLE_SIZE])
+{
+  memset(state, 0, sizeof(SearchState));
+  state->heuristic = heuristic;
+  state->lookups = lookups;
+
+  return SetBoard(state, puzzle);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  The bound a node gets from its dual. walk is set to the moves it took to
+//  walk the blank home first, and dual to the dual board.
+
+static __attribute__((noinline))
+int DualLookup(const SearchState *state, int dual[PUZZLE_SIZE], int *walk)
+{
+  int position[PUZZLE_SIZE], part[MAX_PATTERNS], manhattan[MAX_PATTERNS];
+
+  *walk = DualBoard(state->puzzle, dual);
+  for (int i = 0; i < PUZZLE_SIZE; i++)
+  {
+    position[dual[i]] = i;
+  }
+
+  return DualBound(BoardValue(state->heuristic, position, part, manhattan), *walk);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  A value of zero doesn't always mean solved: a min-compressed byte entry
+//  can be zero for placements that share it with the goal.
+
+static inline int Solved(const int position[PUZZLE_SIZE])
+{
+  for (int tile = 1; tile < PUZZLE_SIZE; tile++)
+  {
+    if (position[tile] != tile - 1)
+    {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Examine a node and recursively call self to search deeper in the tree.
+//  value is the node's heuristic value, from the tables on the board as it
+//  is. Compiled once for each variant, with variant a constant, so the
+//  plain search carries no tests for partial expansion or symmetric
+//  lookups.
+
+typedef int (*ExamineFunction)(SearchState *state, int currentBlankIndex, int prevBlankIndex,
+  int currentLength, int value);
+
+int ExamineNode(SearchState *state, int currentBlankIndex, int prevBlankIndex,
+  int currentLength, int value);
+int ExaminePartial(SearchState *state, int currentBlankIndex, int prevBlankIndex,
+  int currentLength, int value);
+int ExamineSymmetric(SearchState *state, int currentBlankIndex, int prevBlankIndex,
+  int currentLength, int value);
+int ExaminePartialSymmetric(SearchState *state, int currentBlankIndex, int prevBlankIndex,
+  int currentLength, int value);
+
+static ExamineFunction const EXAMINE[VARIANT_COUNT] = {
+  ExamineNode, ExaminePartial, ExamineSymmetric, ExaminePartialSymmetric
+};
+
+static inline __attribute__((always_inline))
+int ExamineBody(SearchState *state, int currentBlankIndex, int prevBlankIndex,
+  int currentLength, int value, const int variant)
+{
+  const Heuristic *heuristic = state->heuristic;
+  const int partial = variant & VARIANT_PARTIAL;
+  const int symmetric = variant & VARIANT_SYMMETRIC;
+  int row = currentBlankIndex / PUZZLE_COLUMN;
+  int col = currentBlankIndex % PUZZLE_COLUMN;
+  int childBlankIndex = 0, ret = 0;
+  int bound = value;
+  int jumped = FALSE;
+
+  state->nodeCounter++;
+
+  if ((state->nodeCounter & STATUS_INTERVAL_MASK) == 0)
+  {
+    printf("Limit: %d ongoing - with %llu nodes\n", state->limitLength, state->nodeCounter);
+    fflush(stdout);
+  }
+
+  if (value == 0 && Solved(state->position))
+  {
+    // Problem solved!
+    if (!(state->lookups & LOOKUP_DUAL_SEARCH))
+    {
+      printf("\nTile movements to arrive in this state:\n");
+    }
+    return currentLength;
+  }
+
+  if (symmetric && (state->lookups & LOOKUP_REFLECT) && state->reflectValue > bound)
+  {
+    bound = state->reflectValue;
+  }
+
+  if (currentLength + bound > state->limitLength)
+  {
+    // Nominate our length+heuristic value as next highest limit
+    if (state->nextLimit > currentLength + bound)
+    {
+      state->nextLimit = currentLength + bound;
+    }
+    return 0;
+  }
+
+  if (symmetric && (state->lookups & LOOKUP_DUAL))
+  {
+    int dual[PUZZLE_SIZE];
+    int walk;
+    int dualBound = DualLookup(state, dual, &walk);
+
+    if (currentLength + dualBound > state->limitLength)
+    {
+      if (state->nextLimit > currentLength + dualBound)
+      {
+        state->nextLimit = currentLength + dualBound;
+      }
+      return 0;
+    }
+
+    // Dual search: with the blank home, the dual is exactly as far from
+    // the goal, so if it looks further it is the better board to search.
+    // Jumping back to the board afterwards is just another jump.
+    state->jumped[currentLength] = FALSE;
+    if ((state->lookups & LOOKUP_DUAL_SEARCH) && walk == 0 && dualBound > bound)
+    {
+      value = SetBoard(state, dual);
+      prevBlankIndex = -1;
+      jumped = TRUE;
+      state->jumped[currentLength] = TRUE;
+    }
+  }
+
+  for (int i = 0; i < 4; i++)
+  {
+    int tile, pattern, childValue, childBound;
+    int oldPart = 0, oldManhattan = 0;
+    int reflectTile = 0, reflectPattern = -1, oldReflectValue = 0;
+    int oldReflectPart = 0, oldReflectManhattan = 0;
+
+    if (i == 0)
+    {
+      if (row == 0)
+      {
+        continue;
+      }
+      childBlankIndex = currentBlankIndex - PUZZLE_COLUMN;
+    }
+    else if (i == 1)
+    {
+      if (row == PUZZLE_ROW-1)
+      {
+        continue;
+      }
+      childBlankIndex = currentBlankIndex + PUZZLE_COLUMN;
+    }
+    else if (i == 2)
+    {
+      if (col == 0)
+      {
+        continue;
+      }
+      childBlankIndex = currentBlankIndex - 1;
+    }
+    else
+    {
+      if (col == PUZZLE_COLUMN-1)
+      {
+        continue;
+      }
+      childBlankIndex = currentBlankIndex + 1;
+    }
+
+    if (childBlankIndex == prevBlankIndex)
+    {
+      // This retracts the move our parent just did, no point.
+      continue;
+    }
+
+    tile = state->puzzle[childBlankIndex];
+    pattern = heuristic->owner[tile];
+
+    if (pattern < 0)
+    {
+      childValue = value + heuristic->manhattanChange[tile][currentBlankIndex][i];
+
+      if (partial && currentLength + 1 + childValue > state->limitLength)
+      {
+        if (state->nextLimit > currentLength + 1 + childValue)
+        {
+          state->nextLimit = currentLength + 1 + childValue;
+        }
+        continue;
+      }
+    }
+
+    // Perform the swap
+    state->puzzle[currentBlankIndex] = tile;
+    state->puzzle[childBlankIndex] = 0;
+    state->position[tile] = currentBlankIndex;
+    state->position[0] = childBlankIndex;
+
+    // Only the moved tile's share of the heuristic changes.
+    if (pattern >= 0)
+    {
+      const PatternDatabase *pdb = &heuristic->pdbs[pattern];
+
+      oldPart = state->part[pattern];
+      oldManhattan = state->manhattan[pattern];
+      state->manhattan[pattern] += heuristic->manhattan[tile][currentBlankIndex] -
+                                   heuristic->manhattan[tile][childBlankIndex];
+      state->part[pattern] = PatternPart(pdb, PatternEntry(pdb, PatternIndex(pdb, state->position)),
+                                         state->manhattan[pattern], oldPart);
+      childValue = value - oldPart + state->part[pattern];
+    }
+    childBound = childValue;
+
+    // The same move on the reflected board.
+    if (symmetric && (state->lookups & LOOKUP_REFLECT))
+    {
+      int to = SymmetryTranspose(currentBlankIndex);
+      int from = SymmetryTranspose(childBlankIndex);
+
+      reflectTile = heuristic->reflectTile[tile];
+      reflectPattern = heuristic->owner[reflectTile];
+      oldReflectValue = state->reflectValue;
+      state->reflectPosition[reflectTile] = to;
+      state->reflectPosition[0] = from;
+
+      if (reflectPattern < 0)
+      {
+        state->reflectValue += heuristic->manhattan[reflectTile][to] -
+                               heuristic->manhattan[reflectTile][from];
+      }
+      else
+      {
+        const PatternDatabase *pdb = &heuristic->pdbs[reflectPattern];
+
+        oldReflectPart = state->reflectPart[reflectPattern];
+        oldReflectManhattan = state->reflectManhattan[reflectPattern];
+        state->reflectManhattan[reflectPattern] += heuristic->manhattan[reflectTile][to] -
+                                                   heuristic->manhattan[reflectTile][from];
+        state->reflectPart[reflectPattern] =
+          PatternPart(pdb, PatternEntry(pdb, PatternIndex(pdb, state->reflectPosition)),
+                      state->reflectManhattan[reflectPattern], oldReflectPart);
+        state->reflectValue += state->reflectPart[reflectPattern] - oldReflectPart;
+      }
+
+      if (state->reflectValue > childBound)
+      {
+        childBound = state->reflectValue;
+      }
+    }
+
+    if (partial && currentLength + 1 + childBound > state->limitLength)
+    {
+      if (state->nextLimit > currentLength + 1 + childBound)
+      {
+        state->nextLimit = currentLength + 1 + childBound;
+      }
+      ret = 0;
+    }
+    else
+    {
+      if (symmetric)
+      {
+        state->moves[currentLength] = (char)i;
+      }
+      ret = EXAMINE[variant](state, childBlankIndex, currentBlankIndex, currentLength+1, childValue);
+    }
+
+    // Revert the swap
+    if (symmetric && (state->lookups & LOOKUP_REFLECT))
+    {
+      if (reflectPattern >= 0)
+      {
+        state->reflectPart[reflectPattern] = oldReflectPart;
+        state->reflectManhattan[reflectPattern] = oldReflectManhattan;
+      }
+      state->reflectValue = oldReflectValue;
+      state->reflectPosition[reflectTile] = SymmetryTranspose(childBlankIndex);
+      state->reflectPosition[0] = SymmetryTranspose(currentBlankIndex);
+    }
+    if (pattern >= 0)
+    {
+      state->part[pattern] = oldPart;
+      state->manhattan[pattern] = oldManhattan;
+    }
+    state->position[tile] = childBlankIndex;
+    state->position[0] = currentBlankIndex;
+    state->puzzle[childBlankIndex] = tile;
+    state->puzzle[currentBlankIndex] = 0;
+
+    // Did the child find anything?
+    if (ret != 0)
+    {
+      if (!(state->lookups & LOOKUP_DUAL_SEARCH))
+      {
+        printf(" %d", tile);
+      }
+      break;
+    }
+  }
+
+  if (symmetric && jumped && ret == 0)
+  {
+    int board[PUZZLE_SIZE];
+    int walk;
+
+    DualLookup(state, board, &walk);
+    SetBoard(state, board);
+  }
+
+  return ret;
+}
+
+int ExamineNode(SearchState *state, int currentBlankIndex, int prevBlankIndex,
+  int currentLength, int value)
+{
+  return ExamineBody(state, currentBlankIndex, prevBlankIndex, currentLength, value, 0);
+}
+
+int ExaminePartial(SearchState *state, int currentBlankIndex, int prevBlankIndex,
+  int currentLength, int value)
+{
+  return ExamineBody(state, currentBlankIndex, prevBlankIndex, currentLength, value,
+                     VARIANT_PARTIAL);
+}
+
+int ExamineSymmetric(SearchState *state, int currentBlankIndex, int prevBlankIndex,
+  int currentLength, int value)
+{
+  return ExamineBody(state, currentBlankIndex, prevBlankIndex, currentLength, value,
+                     VARIANT_SYMMETRIC);
+}
+
+int ExaminePartialSymmetric(SearchState *state, int currentBlankIndex, int prevBlankIndex,
+  int currentLength, int value)
+{
+  return ExamineBody(state, currentBlankIndex, prevBlankIndex, currentLength, value,
+                     VARIANT_PARTIAL | VARIANT_SYMMETRIC);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Print the moves of a solution found by dual search. From a node that
+//  jumped to its dual, the rest of the moves solve the dual, and the same
+//  moves run backwards, each one reversed, solve the node itself. Turning
+//  the moves round from the deepest jump up gives the moves from the root,
+//  which are replayed for the tile numbers and printed last move first, as
+//  the plain search prints them.
+
+void PrintDualSearchSolution(const int puzzle[PUZZLE_SIZE], const SearchState *state, int length)
+{
+  static const int offset[4] = { -PUZZLE_COLUMN, PUZZLE_COLUMN, -1, 1 };
+  char moves[MAX_DEPTH];
+  int tiles[MAX_DEPTH];
+  int board[PUZZLE_SIZE];
+  int blank = 0;
+
+  memcpy(moves, state->moves, length);
+  for (int depth = length - 1; depth >= 0; depth--)
+  {
+    if (state->jumped[depth])
+    {
+      for (int i = depth, j = length - 1; i <= j; i++, j--)
+      {
+        char move = moves[i] ^ 1;   // Up and down, left and right, are pairs.
+
+        moves[i] = moves[j] ^ 1;
+        moves[j] = move;
+      }
+    }
+  }
+
+  for (int i = 0; i < PUZZLE_SIZE; i++)
+  {
+    board[i] = puzzle[i];
+    if (puzzle[i] == 0)
+    {
+      blank = i;
+    }
+  }
+
+  for (int depth = 0; depth < length; depth++)
+  {
+    int child = blank + offset[(int)moves[depth]];
+
+    tiles[depth] = board[child];
+    board[blank] = board[child];
+    board[child] = 0;
+    blank = child;
+  }
+
+  printf("\nTile movements to arrive in this state:\n");
+  for (int depth = length - 1; depth >= 0; depth--)
+  {
+    printf(" %d", tiles[depth]);
+  }
+
+  for (int i = 0; i < PUZZLE_SIZE; i++)
+  {
+    if (board[i] != SymmetryTileOf(i))
+    {
+      printf("\nERROR: The moves don't solve the puzzle");
+      break;
+    }
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Execute the IDA* algorithm on the given puzzle state. Returns the
+//  solution length, with the node count in nodesSearched. With counters,
+//  each iteration's line is followed by its costs per node.
+
+int IDAStar(int puzzle[PUZZLE_SIZE], const Heuristic *heuristic, int partialExpansion,
+  int lookups, const PerfCounters *counters, unsigned long long *nodesSearched)
+{
+  SearchState state;
+  PerfSample searchStart, iterationStart, sample;
+  unsigned long long nodesTotal = 0;
+  int value = InitSearchState(&state, heuristic, lookups, puzzle);
+  int blankIndex = state.position[0];
+  int variant = (partialExpansion ? VARIANT_PARTIAL : 0) | (lookups ? VARIANT_SYMMETRIC : 0);
+  int length = 0;
+
+  *nodesSearched = 0;
+  if (value < 0)
+  {
+    return -1;
+  }
+
+  printf("Initial heuristic value of %d", value);
+  if (lookups & LOOKUP_REFLECT)
+  {
+    printf(", reflected %d", state.reflectValue);
+  }
+  printf("\n\n");
+
+  PerfRead(counters, &searchStart);
+  iterationStart = searchStart;
+
+  if (!Solved(state.position))
+  {
+    state.limitLength = value;
+    state.nextLimit = 999;
+
+    while (0 == (length = EXAMINE[variant](&state, blankIndex, -1, 0, value)))
+    {
+      printf("Limit: %d completed with %llu nodes\n", state.limitLength, state.nodeCounter);
+      PerfRead(counters, &sample);
+      PerfPrint(counters, "  per node", &iterationStart, &sample, state.nodeCounter);
+      iterationStart = sample;
+      nodesTotal += state.nodeCounter;
+      state.nodeCounter = 0;
+      state.limitLength = state.nextLimit;
+      state.nextLimit = 999;
+    }
+
+    nodesTotal += state.nodeCounter;
+    PerfRead(counters, &sample);
+
+    if (lookups & LOOKUP_DUAL_SEARCH)
+    {
+      PrintDualSearchSolution(puzzle, &state, length);
+    }
+  }
+
+  printf("\n\nSolution of length %d found after searching %llu nodes\n", length, nodesTotal);
+  PerfPrint(counters, "  last iteration per node", &iterationStart, &sample, state.nodeCounter);
+  PerfPrint(counters, partialExpansion ? "EPEIDA* per node" : "IDA* per node",
+    &searchStart, &sample, nodesTotal);
+
+  *nodesSearched = nodesTotal;
+
+  return length;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Solve every puzzle line of a file in turn. Bad lines are reported and
+//  skipped. Returns FALSE if the file can't be read.
+
+int SolveBatch(const char *path, const Heuristic *heuristic, int partialExpansion, int lookups,
+  const PerfCounters *counters)
+{
+  PuzzleInput input;
+  ParseStatus status;
+  int puzzle[PUZZLE_SIZE];
+  unsigned long long nodes, nodesTotal = 0;
+  int solved = 0, errors = 0;
+
+  if (OpenPuzzleInput(&input, path) != 0)
+  {
+    printf("ERROR: Unable to read %s\n", path);
+    return FALSE;
+  }
+
+  while ((status = NextPuzzle(&input, puzzle)) != PARSE_END)
+  {
+    if (status != PARSE_OK)
+    {
+      printf("ERROR: Line %d: %s\n", input.line, ParseStatusText(status));
+      if (status == PARSE_READ_ERROR)
+      {
+        break;
+      }
+      errors++;
+      continue;
+    }
+
+    printf("\nPuzzle on line %d:\n\n", input.line);
+    PrintPuzzle(puzzle);
+
+    if (IDAStar(puzzle, heuristic, partialExpansion, lookups, counters, &nodes) < 0)
+    {
+      break;
+    }
+    nodesTotal += nodes;
+    solved++;
+  }
+
+  ClosePuzzleInput(&input);
+
+  printf("\nBatch complete: %d puzzles solved, %d lines rejected, %llu nodes\n",
+    solved, errors, nodesTotal);
+
+  return TRUE;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Main
+//
+
+int main(int argc, char *argv[])
+{
+  Heuristic heuristic;
+  PuzzleInput input;
+  ParseStatus status;
+  const char *pdbPaths[MAX_PATTERNS];
+  const char *batchPath = NULL;
+  int puzzle[PUZZLE_SIZE];
+  unsigned long long nodes;
+  int pdbCount = 0;
+  int partialExpansion = FALSE;
+  int lookups = 0;
+  int useCounters = FALSE;
+  PerfCounters counterStore;
+  PerfCounters *counters = NULL;
+  int ok = TRUE;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-pdb") == 0 && i + 1 < argc && pdbCount < MAX_PATTERNS)
+    {
+      pdbPaths[pdbCount++] = argv[++i];
+    }
+    else if (strcmp(argv[i], "-batch") == 0 && i + 1 < argc)
+    {
+      batchPath = argv[++i];
+    }
+    else if (strcmp(argv[i], "-epe") == 0)
+    {
+      partialExpansion = TRUE;
+    }
+    else if (strcmp(argv[i], "-reflect") == 0)
+    {
+      lookups |= LOOKUP_REFLECT;
+    }
+    else if (strcmp(argv[i], "-dual") == 0)
+    {
+      lookups |= LOOKUP_DUAL;
+    }
+    else if (strcmp(argv[i], "-dualsearch") == 0)
+    {
+      lookups |= LOOKUP_DUAL | LOOKUP_DUAL_SEARCH;
+    }
+    else if (strcmp(argv[i], "-counters") == 0)
+    {
+      useCounters = TRUE;
+    }
+    else
+    {
+      printf("Usage: puzPDB [-pdb file]... [-batch file] [-epe] [-reflect] [-dual] [-dualsearch]\n");
+      printf("              [-counters]\n");
+      return 1;
+    }
+  }
+
+  if (!LoadHeuristic(&heuristic, pdbPaths, pdbCount))
+  {
+    return 1;
+  }
+
+  if (useCounters && PerfOpen(&counterStore, FALSE))
+  {
+    counters = &counterStore;
+  }
+
+  if (batchPath != NULL)
+  {
+    ok = SolveBatch(batchPath, &heuristic, partialExpansion, lookups, counters);
+  }
+  else
+  {
+    printf("Enter the starting configuration for the puzzle:\n");
+    fflush(stdout);
+
+    if (OpenPuzzleInput(&input, NULL) != 0)
+    {
+      printf("ERROR: %s\n", ParseStatusText(PARSE_READ_ERROR));
+      return 1;
+    }
+
+    status = NextPuzzleAcrossLines(&input, puzzle);
+    ClosePuzzleInput(&input);
+
+    if (status != PARSE_OK)
+    {
+      printf("ERROR: Line %d: %s\n", input.line, ParseStatusText(status));
+      return 1;
+    }
+
+    printf("\nThe input received were as follows:\n\n");
+    PrintPuzzle(puzzle);
+
+    IDAStar(puzzle, &heuristic, partialExpansion, lookups, counters, &nodes);
+  }
+
+  if (counters != NULL)
+  {
+    PerfClose(counters);
+  }
+
+  FreeHeuristic(&heuristic);
+
+  return ok ? 0 : 1;
+}
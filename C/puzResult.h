@@ -0,0 +1,95 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Binary result stream: one fixed size record per solved puzzle.
+//
+//  A result file is a ResultFileHeader followed by ResultRecords back to
+//  back, so record i starts at sizeof(ResultFileHeader) + i*sizeof(ResultRecord)
+//  and a consumer can mmap the file and index it directly. All fields are
+//  fixed width and naturally aligned, stored in the byte order of the
+//  machine that wrote them (little-endian on x86 and ARM Linux).
+//
+//  Moves are the blank's direction at each step, 2 bits each, first move in
+//  the low bits of moves[0]. The starting board can be recovered from its
+//  boardIndex with BoardFromIndex in permRank.h, and the moves replayed from
+//  there. puzDump.c turns a result file back into text.
+//
+#ifndef PUZ_RESULT_H
+#define PUZ_RESULT_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define RESULT_MAGIC "PUZRSLT"
+#define RESULT_VERSION 1
+
+// Blank move directions, in the order ExamineNode tries them.
+#define MOVE_UP    0
+#define MOVE_DOWN  1
+#define MOVE_LEFT  2
+#define MOVE_RIGHT 3
+
+// Room for 96 moves. The longest optimal 15-puzzle solution is 80.
+#define RESULT_MOVE_BYTES 24
+#define RESULT_MAX_MOVES (RESULT_MOVE_BYTES * 4)
+
+typedef struct
+{
+  char magic[8];              // RESULT_MAGIC, NUL terminated.
+  uint32_t version;           // RESULT_VERSION
+  uint32_t recordSize;        // sizeof(ResultRecord), as a layout check.
+} ResultFileHeader;
+
+typedef struct
+{
+  uint64_t boardIndex;        // BoardIndexOf the starting board.
+  uint64_t nodes;             // Nodes searched, all iterations.
+  uint64_t microseconds;      // Wall clock time for the search.
+  uint32_t id;                // Input line number.
+  uint16_t length;            // Solution length in moves.
+  uint16_t reserved;
+  uint8_t moves[RESULT_MOVE_BYTES];
+} ResultRecord;
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Fill in a file header.
+
+static inline void InitializeResultHeader(ResultFileHeader *header)
+{
+  memset(header, 0, sizeof(ResultFileHeader));
+  strcpy(header->magic, RESULT_MAGIC);
+  header->version = RESULT_VERSION;
+  header->recordSize = sizeof(ResultRecord);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  TRUE if the header is one this build can read.
+
+static inline int ResultHeaderIsValid(const ResultFileHeader *header)
+{
+  return memcmp(header->magic, RESULT_MAGIC, sizeof(RESULT_MAGIC)) == 0 &&
+         header->version == RESULT_VERSION &&
+         header->recordSize == sizeof(ResultRecord);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Pack a list of directions into a record, or read one back out.
+
+static inline void PackResultMoves(ResultRecord *record, const char *directions, int length)
+{
+  memset(record->moves, 0, RESULT_MOVE_BYTES);
+
+  for (int i = 0; i < length && i < RESULT_MAX_MOVES; i++)
+  {
+    record->moves[i >> 2] |= (uint8_t)((directions[i] & 3) << ((i & 3) * 2));
+  }
+}
+
+static inline int ResultMove(const ResultRecord *record, int i)
+{
+  return (record->moves[i >> 2] >> ((i & 3) * 2)) & 3;
+}
+
+#endif // PUZ_RESULT_H
@@ -0,0 +1,528 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Engine router: predicts how long each solver would take on a puzzle,
+//  and hands the puzzle to the one predicted to be quickest.
+//
+//  The engines are puzPDB with no tables (plain Manhattan Distance), puzWD
+//  (Walking Distance plus inversions), and puzPDB with the tables given by
+//  -pdb. Each engine's heuristic is also evaluated here, so that predict.h
+//  can predict the nodes its IDA* would search, from its own starting bound
+//  up to an estimate of the solution length. Those nodes at the engine's
+//  measured time per node, plus its start-up time, are its predicted cost.
+//
+//  The solution length isn't known before the search. The estimate is the
+//  starting bound of the best informed engine loaded plus its typical gap
+//  between bound and solution. It is the same for every engine, so when it
+//  is off, it is off for all of them, and the choice mostly stands.
+//
+//  Usage: puzRoute [-pdb file]... [-batch file] [-dry]
+//
+//  With -dry the predictions are printed and nothing is solved. Otherwise
+//  the chosen solver is run from the directory puzRoute itself is in, with
+//  the puzzle on its standard input, and its output follows.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+#include "puzInput.h"
+#include "pdb.h"
+#include "predict.h"
+#include "walkDist.h"
+
+#define PUZZLE_COLUMN 4
+#define PUZZLE_ROW 4
+#define PUZZLE_SIZE (PUZZLE_COLUMN * PUZZLE_ROW)
+
+#define FALSE 0
+#define TRUE 1
+
+#define MAX_PATTERNS PUZZLE_SIZE
+
+// Real nodes searched per engine and puzzle to scale the predictions by.
+#define ROUTE_CALIBRATION_NODES 20000
+
+#define ROUTE_PATH_SIZE 4096
+
+// Arguments of the longest engine command: the program, a -pdb and a path
+// for every table, and the terminating NULL.
+#define ROUTE_MAX_ARGUMENTS (2 * MAX_PATTERNS + 2)
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Manhattan Distance of every tile from every position.
+
+int MANHATTAN[PUZZLE_SIZE][PUZZLE_SIZE];
+
+void GenerateManhattanLookup()
+{
+  for (int tile = 1; tile < PUZZLE_SIZE; tile++)
+  {
+    int goal = tile - 1;
+
+    for (int position = 0; position < PUZZLE_SIZE; position++)
+    {
+      MANHATTAN[tile][position] =
+        abs(goal % PUZZLE_COLUMN - position % PUZZLE_COLUMN) +
+        abs(goal / PUZZLE_COLUMN - position / PUZZLE_COLUMN);
+    }
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  The pattern databases, loaded the same way puzPDB loads them.
+
+typedef struct
+{
+  PatternDatabase pdbs[MAX_PATTERNS];
+  int patternCount;
+  int owner[PUZZLE_SIZE];               // Table holding each tile, -1 for none.
+} PatternSet;
+
+int LoadPatternSet(PatternSet *patterns, const char **paths, int pathCount)
+{
+  memset(patterns, 0, sizeof(PatternSet));
+
+  for (int tile = 0; tile < PUZZLE_SIZE; tile++)
+  {
+    patterns->owner[tile] = -1;
+  }
+
+  for (int p = 0; p < pathCount; p++)
+  {
+    PatternDatabase *pdb = &patterns->pdbs[p];
+
+    if (LoadPatternDatabase(paths[p], pdb) != 0)
+    {
+      printf("ERROR: Unable to load pattern database %s\n", paths[p]);
+      return FALSE;
+    }
+    patterns->patternCount++;
+
+    for (int i = 0; i < pdb->tileCount; i++)
+    {
+      if (patterns->owner[pdb->tiles[i]] >= 0)
+      {
+        printf("ERROR: Tile %d is in more than one pattern database\n", pdb->tiles[i]);
+        return FALSE;
+      }
+      patterns->owner[pdb->tiles[i]] = p;
+    }
+  }
+
+  return TRUE;
+}
+
+void FreePatternSet(PatternSet *patterns)
+{
+  for (int p = 0; p < patterns->patternCount; p++)
+  {
+    FreePatternDatabase(&patterns->pdbs[p]);
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  The three heuristics as whole-board callbacks for predict.h.
+
+int ManhattanValue(const int puzzle[PUZZLE_SIZE], void *data)
+{
+  int value = 0;
+
+  (void)data;
+  for (int i = 0; i < PUZZLE_SIZE; i++)
+  {
+    value += puzzle[i] ? MANHATTAN[puzzle[i]][i] : 0;
+  }
+
+  return value;
+}
+
+int WalkingDistanceValue(const int puzzle[PUZZLE_SIZE], void *data)
+{
+  int idx1, idx2, inv1, inv2;
+
+  (void)data;
+  return HeuristicLookupIndices((int *)puzzle, &idx1, &idx2, &inv1, &inv2);
+}
+
+// A compressed table can give zero short of the goal. One is still a lower
+// bound there, and keeps zero for the goal, as predict.h expects. A damaged
+// mod 3 table gives -1, which predict.h takes as failure.
+int PatternValue(const int puzzle[PUZZLE_SIZE], void *data)
+{
+  const PatternSet *patterns = data;
+  int position[PUZZLE_SIZE];
+  int manhattan[MAX_PATTERNS] = { 0 };
+  int value = 0, distance = 0, part;
+
+  for (int i = 0; i < PUZZLE_SIZE; i++)
+  {
+    position[puzzle[i]] = i;
+  }
+
+  for (int tile = 1; tile < PUZZLE_SIZE; tile++)
+  {
+    distance += MANHATTAN[tile][position[tile]];
+    if (patterns->owner[tile] < 0)
+    {
+      value += MANHATTAN[tile][position[tile]];
+    }
+    else
+    {
+      manhattan[patterns->owner[tile]] += MANHATTAN[tile][position[tile]];
+    }
+  }
+
+  for (int p = 0; p < patterns->patternCount; p++)
+  {
+    const PatternDatabase *pdb = &patterns->pdbs[p];
+
+    switch (pdb->encoding)
+    {
+      case PDB_ENCODING_MOD3:
+        part = Mod3Value(pdb, position);
+        if (part < 0)
+        {
+          printf("ERROR: No way down to the goal in mod 3 pattern database %d\n", p + 1);
+          return -1;
+        }
+        value += part;
+        break;
+
+      case PDB_ENCODING_NIBBLE:
+        value += manhattan[p] + 2 * PatternEntry(pdb, PatternIndex(pdb, position));
+        break;
+
+      default:
+        value += PatternEntry(pdb, PatternIndex(pdb, position));
+        break;
+    }
+  }
+
+  return value == 0 && distance > 0 ? 1 : value;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  An engine and what it costs. The time per node comes from timing the
+//  calibration searches PredictSearch runs here, on this machine, over
+//  all the puzzles so far. Those evaluate the whole board at every node,
+//  which costs more than the engine's own incremental search, by a factor
+//  that depends on the heuristic but hardly on the machine. searchShare is
+//  that factor, the engine's time per node over the calibration search's,
+//  from Test/54 (MD) and Test/68 (WD, and the 6-6-3 byte tables for PDB).
+//  The gaps are the mean optimal length less the starting bound over
+//  batch-random100.
+
+typedef struct
+{
+  const char *name;
+  const char *program;              // Solver binary, beside puzRoute.
+  PredictHeuristic heuristic;
+  void *data;
+  double searchShare;
+  double startupSeconds;            // Building or loading tables.
+  int typicalGap;
+  Predictor *predictor;
+  PredictTiming calibration;        // Real nodes counted so far, and their time.
+} Engine;
+
+#define ENGINE_MD 0
+#define ENGINE_WD 1
+#define ENGINE_PDB 2
+#define ENGINE_COUNT 3
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Predict each engine's cost for a puzzle and return the cheapest, or -1
+//  if a prediction failed.
+
+int RoutePuzzle(Engine engines[], int engineCount, const int puzzle[PUZZLE_SIZE])
+{
+  int bound[ENGINE_COUNT] = { 0 };
+  int informed = 0, estimate, best = 0;
+  double seconds[ENGINE_COUNT];
+
+  for (int e = 0; e < engineCount; e++)
+  {
+    bound[e] = engines[e].heuristic(puzzle, engines[e].data);
+    if (bound[e] < 0)
+    {
+      printf("ERROR: Can't evaluate %s's heuristic\n", engines[e].name);
+      return -1;
+    }
+    if (engines[e].typicalGap < engines[informed].typicalGap)
+    {
+      informed = e;
+    }
+  }
+
+  estimate = bound[informed] + engines[informed].typicalGap;
+  printf("Bounds");
+  for (int e = 0; e < engineCount; e++)
+  {
+    printf(" %s %d", engines[e].name, bound[e]);
+  }
+  printf(", solution estimated at %d moves\n", estimate);
+
+  for (int e = 0; e < engineCount; e++)
+  {
+    const PredictTiming *calibration = &engines[e].calibration;
+    double nodes = PredictSearch(engines[e].predictor, puzzle, bound[e], estimate,
+                                 ROUTE_CALIBRATION_NODES, &engines[e].calibration);
+    double nanoseconds;
+
+    if (nodes < 0.0)
+    {
+      printf("ERROR: Can't predict %s's search\n", engines[e].name);
+      return -1;
+    }
+
+    nanoseconds = calibration->seconds * 1e9 / calibration->nodes * engines[e].searchShare;
+    seconds[e] = engines[e].startupSeconds + nodes * nanoseconds * 1e-9;
+    printf("  %-4s predicted %.3g nodes at %.0f ns, %.2f seconds\n",
+           engines[e].name, nodes, nanoseconds, seconds[e]);
+
+    if (seconds[e] < seconds[best])
+    {
+      best = e;
+    }
+  }
+
+  return best;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Run an engine on a puzzle, with the puzzle written to its standard
+//  input. The engine is started directly rather than through a shell, so
+//  the paths in its arguments are taken as they are. Its output goes
+//  straight to ours.
+
+int RunEngine(char *const arguments[], const int puzzle[PUZZLE_SIZE])
+{
+  char line[4 * PUZZLE_SIZE];
+  int fds[2];
+  int length = 0, status;
+  pid_t pid;
+
+  for (int i = 0; i < PUZZLE_SIZE; i++)
+  {
+    length += snprintf(line + length, sizeof(line) - length, "%d%c",
+                       puzzle[i], i == PUZZLE_SIZE - 1 ? '\n' : ' ');
+  }
+
+  fflush(stdout);
+  if (pipe(fds) != 0)
+  {
+    perror("pipe");
+    return FALSE;
+  }
+
+  pid = fork();
+  if (pid < 0)
+  {
+    perror("fork");
+    close(fds[0]);
+    close(fds[1]);
+    return FALSE;
+  }
+  else if (pid == 0)
+  {
+    dup2(fds[0], 0);
+    close(fds[0]);
+    close(fds[1]);
+    execv(arguments[0], arguments);
+    perror(arguments[0]);
+    _exit(127);
+  }
+
+  close(fds[0]);
+  if (write(fds[1], line, length) != length)
+  {
+    perror(arguments[0]);
+  }
+  close(fds[1]);
+
+  if (waitpid(pid, &status, 0) != pid)
+  {
+    return FALSE;
+  }
+
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  The directory this program is in, where the engines are.
+
+void ProgramDirectory(const char *argv0, char *directory, size_t size)
+{
+  ssize_t length = readlink("/proc/self/exe", directory, size - 1);
+  char *slash;
+
+  if (length <= 0)
+  {
+    snprintf(directory, size, "%s", argv0);
+  }
+  else
+  {
+    directory[length] = '\0';
+  }
+
+  if ((slash = strrchr(directory, '/')) != NULL)
+  {
+    *slash = '\0';
+  }
+  else
+  {
+    snprintf(directory, size, ".");
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Main
+//
+
+int main(int argc, char *argv[])
+{
+  Engine engines[ENGINE_COUNT] = {
+    { "MD",  "puzPDB", ManhattanValue,       NULL, 0.60, 0.002, 16, NULL, { 0 } },
+    { "WD",  "puzWD",  WalkingDistanceValue, NULL, 0.15, 0.010, 14, NULL, { 0 } },
+    { "PDB", "puzPDB", PatternValue,         NULL, 0.36, 0.010, 12, NULL, { 0 } }
+  };
+  char programs[ENGINE_COUNT][ROUTE_PATH_SIZE];
+  char *arguments[ENGINE_COUNT][ROUTE_MAX_ARGUMENTS];
+  char directory[ROUTE_PATH_SIZE / 2];
+  PatternSet patterns;
+  PuzzleInput input;
+  ParseStatus status;
+  const char *pdbPaths[MAX_PATTERNS];
+  const char *batchPath = NULL;
+  int puzzle[PUZZLE_SIZE];
+  int routed[ENGINE_COUNT] = { 0 };
+  int pdbCount = 0, engineCount = ENGINE_COUNT;
+  int dry = FALSE, failed = FALSE;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-pdb") == 0 && i + 1 < argc && pdbCount < MAX_PATTERNS)
+    {
+      pdbPaths[pdbCount++] = argv[++i];
+    }
+    else if (strcmp(argv[i], "-batch") == 0 && i + 1 < argc)
+    {
+      batchPath = argv[++i];
+    }
+    else if (strcmp(argv[i], "-dry") == 0)
+    {
+      dry = TRUE;
+    }
+    else
+    {
+      printf("Usage: puzRoute [-pdb file]... [-batch file] [-dry]\n");
+      return 1;
+    }
+  }
+
+  GenerateWalkingDistanceLookup();
+  GenerateManhattanLookup();
+
+  if (!LoadPatternSet(&patterns, pdbPaths, pdbCount))
+  {
+    return 1;
+  }
+  if (pdbCount == 0)
+  {
+    engineCount = ENGINE_PDB;
+  }
+  engines[ENGINE_PDB].data = &patterns;
+
+  ProgramDirectory(argv[0], directory, sizeof(directory));
+  for (int e = 0; e < engineCount; e++)
+  {
+    snprintf(programs[e], ROUTE_PATH_SIZE, "%s/%s", directory, engines[e].program);
+    arguments[e][0] = programs[e];
+    arguments[e][1] = NULL;
+  }
+  for (int p = 0; p < pdbCount; p++)
+  {
+    arguments[ENGINE_PDB][1 + 2*p] = "-pdb";
+    arguments[ENGINE_PDB][2 + 2*p] = (char *)pdbPaths[p];
+    arguments[ENGINE_PDB][3 + 2*p] = NULL;
+  }
+
+  // An engine that quits early must not take the router down with it.
+  signal(SIGPIPE, SIG_IGN);
+
+  for (int e = 0; e < engineCount; e++)
+  {
+    engines[e].predictor = CreatePredictor(engines[e].heuristic, engines[e].data,
+                                           PREDICT_DEFAULT_SAMPLES);
+    if (engines[e].predictor == NULL)
+    {
+      printf("ERROR: Can't sample %s's heuristic\n", engines[e].name);
+      return 1;
+    }
+  }
+
+  if (OpenPuzzleInput(&input, batchPath) != 0)
+  {
+    printf("ERROR: Unable to read %s\n", batchPath ? batchPath : "standard input");
+    return 1;
+  }
+
+  while ((status = NextPuzzle(&input, puzzle)) != PARSE_END)
+  {
+    int engine;
+
+    if (status != PARSE_OK)
+    {
+      printf("ERROR: Line %d: %s\n", input.line, ParseStatusText(status));
+      if (status == PARSE_READ_ERROR)
+      {
+        failed = TRUE;
+        break;
+      }
+      continue;
+    }
+
+    printf("\nLine %d: ", input.line);
+    engine = RoutePuzzle(engines, engineCount, puzzle);
+    if (engine < 0)
+    {
+      failed = TRUE;
+      continue;
+    }
+    routed[engine]++;
+    printf("Routed to %s\n", engines[engine].name);
+
+    if (!dry && !RunEngine(arguments[engine], puzzle))
+    {
+      printf("ERROR: %s failed on line %d\n", programs[engine], input.line);
+      failed = TRUE;
+    }
+  }
+
+  ClosePuzzleInput(&input);
+
+  printf("\nRouted");
+  for (int e = 0; e < engineCount; e++)
+  {
+    printf(" %d to %s%s", routed[e], engines[e].name, e < engineCount - 1 ? "," : "\n");
+  }
+
+  for (int e = 0; e < engineCount; e++)
+  {
+    FreePredictor(engines[e].predictor);
+  }
+  FreePatternSet(&patterns);
+
+  return failed ? 1 : 0;
+}
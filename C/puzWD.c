@@ -6,6 +6,21 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "puzInput.h"
+#include "puzResult.h"
+#include "solCache.h"
+#include "endgame.h"
+#include "astar.h"
+#include "predict.h"
+#include "trace.h"
+#include "counters.h"
+#include "walkDist.h"
 
 #define PUZZLE_COLUMN 4
 #define PUZZLE_ROW 4
@@ -16,322 +31,17 @@
 #define FALSE 0
 #define TRUE 1
 
-/////////////////////////////////////////////////////////////////////////////
-//
-//  Adaptation of the Walking Distance algorithm by takaken (puz15wd.c)
-//  
-//  Goals of adaptation in priority order:
-//  * Bring up to current C standard.
-//  * More comments, and in English.
-//  * Eliminate use of global variables.
-//  
-//  Originally I had the ambition to add flexibility for configuration other 
-//  than 4x4 15-puzzle but that's going to be difficult. Problems are:
-//  1. Current implementation depends on the puzzle being a square (with same
-//     dimension on both sides) because it reuses the same lookup table for
-//     both horizontal and vertical axis. The only way to do a non-square
-//     puzzle (like 4x5 19-puzzle) would require two separate tables.
-//  2. The lookup table size shoots up tremendously with size. When size is 4
-//     the table can still fit in L3 cache. Table of 5 is going to dump into
-//     main memory... would the memory latency kill us?
-//
-#define BOARD_WIDTH 4
-
-#define WDTBL_SIZE 24964 // Don't understand where this value came from
-#define IDTBL_SIZE 106
-
-typedef unsigned long long u64; // MSVC 'unsigned __int64' now C99 'unsigned long long'
-
-// Each element in TABLE is a count of the number of tiles mapping their 
-// current row  against their desired row.
-//
-// Rephrase: TABLE[i][j] holds the count of tiles that are currently in row
-//  i and need to be in row j for the puzzle's solved state. When i equals
-//  j, that count is the number of tiles sitting in their correct final row.
-//
-// Example: TABLE representing the solved state, with all tiles in their
-//  correct position (and therefore correct row) would look like this:
-//             
-//      j=0  1  2  3
-//
-// i = 0  4  0  0  0
-// i = 1  0  4  0  0
-// i = 2  0  0  4  0
-// i = 3  0  0  0  3
-int   TABLE[BOARD_WIDTH][BOARD_WIDTH];
-
-// WDTOP and WDEND are used while generating the lookup table via breadth
-// first search. WDTOP represents the end of the closed list, and WDEND 
-// represents the end of the open list. Everything in between are nodes still
-// still to be examined. Table generation ends when WDTOP catches up to WDEND
-// (The values of which, when things work correctly, would be WDTBL_SIZE.)
-int   WDTOP, WDEND;
-
-// The value of a WDPTN element is a representation of a particular TABLE
-// configuration. So given a TABLE, we can pack it into a pattern and perform
-// a linear search of WDPTN until we find a match. The index value is used to 
-// look at WDTBL to retrieve the Walking Distance corresponding to the TABLE.
-u64   WDPTN[WDTBL_SIZE];
-char  WDTBL[WDTBL_SIZE];
-
-// WDLNK table stores transitions from one TABLE pattern to another. This
-// allows the Walking Distance values to be updated without going through the
-// steps of packing the TABLE and searching in WDPTN.
-short WDLNK[WDTBL_SIZE][2][BOARD_WIDTH];
-
-// Inversion Distance is another heuristic employed here. It tracks the number
-// of tiles that are out-of-place relative to tiles with a lower number.
-// In the solved state, all tile numbers are increasing and the inversion
-// distance is zero. IDTBL maps an inversion count to the minimum number of 
-// moves required to put tiles back in order.
-char  IDTBL[IDTBL_SIZE];
-
-// Walking Distance performs its calculations along one axis, then repeats
-// the calculation along the other axis. The CONVersion table here is used
-// to map tile positions across this axis flip, so that the same lookup
-// tables can be used for both horizontal and vertical calculation.
-int CONV[PUZZLE_SIZE] = {
-  0,
-  1, 5, 9,13,
-  2, 6,10,14,
-  3, 7,11,15,
-  4, 8,12
-};
-
-/////////////////////////////////////////////////////////////////////////////
-//
-// Pack the TABLE array (each element represented by 3 bits) into a 48-bit 
-// representation.
-
-u64 PackTable()
-{
-  u64 packedValue = 0;
-
-  for (int i=0; i<BOARD_WIDTH; i++)
-  {
-    for (int j=0; j<BOARD_WIDTH; j++)
-    {
-      packedValue = (packedValue << 3) | TABLE[i][j];
-    }
-  }
-
-  return packedValue;
-}
-
-/////////////////////////////////////////////////////////////////////////////
-//
-// Pack the given puzzle array (each element is the tile number at that space)
-// into the 48-bit representation of their walking distance displacement.
-// Can calculate either vertical or horizontal depending on flipAxis parameter.
-
-u64 PackPuzzle(int* puzzle, int flipAxis)
-{
-  int i,j;
-  int tileNum;
-
-  int work[BOARD_WIDTH];  // Temporary work space
-
-  u64 packedPuzzle = 0;
-
-  for (i=0;i<BOARD_WIDTH;i++)
-  {
-    // Zero out work array
-    for (j=0; j<BOARD_WIDTH; j++)
-    {
-      work[j] = 0;
-    }
-
-    // Look at each of the tiles in this row.
-    for (j=0; j<BOARD_WIDTH; j++)
-    {
-      tileNum = flipAxis? CONV[puzzle[j*BOARD_WIDTH + i]] : puzzle[i*BOARD_WIDTH + j];
-
-      if (tileNum == 0)
-      {
-        // Skip blank tile
-        continue;
-      }
-      // Take the tile number, subtract one, then drop the least significant 
-      // 2 bits (a.k.a. divide by four) gives us the desired row number for
-      // that tile. Increment the desired row counter in the work array.
-      work[(tileNum-1)>>2]++;
-    }
-
-    // Pack results of work array into lookup table encoding
-    for (j=0; j<BOARD_WIDTH; j++)
-    {
-      packedPuzzle = (packedPuzzle<<3) | work[j];
-    }
-  }
-
-  return packedPuzzle;
-}
-
-/////////////////////////////////////////////////////////////////////////////
-//
-// Initialize the link table entry at the given index to the starting value
-// of WDTBL_SIZE
-
-void InitializeLink(int linkIndex)
-{
-  for (int j=0;j<2;j++)
-  {
-    for (int k=0;k<4;k++)
-    {
-      WDLNK[linkIndex][j][k] = WDTBL_SIZE;
-    }
-  }
-}
-
-/////////////////////////////////////////////////////////////////////////////
-// 
-//  Given a tile index and a space index, explore all the possible swaps
-//  between those and record valid states into the lookup tables.
-
-void SwapAndWrite(int tileIndex, int spaceIndex, int walkingDistance, int direction)
-{
-  u64 packedTable;
-  int tableIndex;
-
-  for (int group=0; group<4; group++)
-  {
-    // Check if there's even a tile of the appropriate class to swap with
-    if (TABLE[tileIndex][group])
-    {
-      // Swap that tile with the space
-      TABLE[tileIndex][group]--;
-      TABLE[spaceIndex][group]++;
-
-      packedTable = PackTable();
-
-      // Examine the WDPTN table to see if this TABLE configuration is already
-      // represented.
-      for (tableIndex=0; tableIndex<WDEND; tableIndex++)
-      {
-        if (WDPTN[tableIndex] == packedTable)
-        {
-          break;
-        }
-      }
-
-      // At this point, if i < WDEND, we found an existing entry in the table
-      // matching our packed table value. If i==WDEND we hit the end without
-      // find it and would need to add it to the table.
-      if (tableIndex==WDEND)
-      {
-        WDPTN[WDEND] = packedTable; // Representing a TABLE configuration.
-        WDTBL[WDEND] = walkingDistance; // The Walking Distance for this TABLE configuration.
-        WDEND++;
-
-        // When a new entry is added, we also initialize the corresponding
-        // transition lookup entry for this TABLE configuration.
-        InitializeLink(tableIndex);
-      }
-
-      // Fill in the transition lookup table entry for transition between the
-      // currently examined node (WDTOP-1) and this new node. First fill in 
-      // the given direction, then flip the direction with the ^ (XOR) operator
-      // and fill in the other way.
-      WDLNK[WDTOP - 1 ][direction  ][group] = (short)tableIndex;
-      WDLNK[tableIndex][direction^1][group] = (short)WDTOP-1; 
-
-      // Revert the swap so we can look at the next candidate.
-      TABLE[tileIndex][group]++;
-      TABLE[spaceIndex][group]--;
-    }
-  }
-}
-
-/////////////////////////////////////////////////////////////////////////////
-//
-// Breadth-first walk through the Walking Distance space to generate all the
-// lookup data used in the heuristic search later on.
-
-void GenerateWalkingDistanceLookup()
-{
-  int i,j,k,space=0,piece;
-  char walkingDistance;
-  u64 packedTable;
-
-  // The breadth-first search begins with the solved puzzle state and expands
-  // from there to the full Walking Distance table configurations.
-
-  // Create TABLE representing the solved state. 
-  // First initialize to zero.
-  for (i=0; i<4; i++)
-  {
-    for (j=0; j<4; j++)
-    {
-      TABLE[i][j] = 0;
-    }
-  }
-  // Then fill in the diagonals representing tiles in their proper places.
-  TABLE[0][0] = TABLE[1][1] = TABLE[2][2] = 4; // 4 tiles in correct row positions
-  TABLE[3][3] = 3; // 3 tiles in correct row position for final row.
-
-  // The solved state and its representation sits at the beginning of the
-  // Walking Distance lookup table.
-  WDPTN[0] = PackTable(); // Representing the solved TABLE configuration
-  WDTBL[0] = 0;           // Solved state has walking distance of zero.
+#define MAX_SOLUTION_LENGTH 100
 
-  // Initialize the transition lookup entry for the solved state.
-  InitializeLink(0);
-
-  // With the start state initialized to the solved configuration, it is
-  // time to explore all the possible changes from that point.
-  WDTOP=0; // Index of the node currently being expanded (the solved state)
-  WDEND=1; // End of the open list where we append new nodes.
-  while (WDTOP < WDEND)
-  {
-    // Retrieve the TABLE representation pattern and the Walking Distance
-    // count for the node to be expanded.
-    packedTable = WDPTN[WDTOP];
-    walkingDistance = WDTBL[WDTOP] + 1;
-    WDTOP++;
-
-    // Unpack the representation back into the TABLE array so we can 
-    // use it to explore valid states.
-    for (i=3; i>=0; i--)
-    {
-      piece = 0; // This tracks the number of tile pieces on this row
-      for (j=3; j>=0; j--)
-      {
-        TABLE[i][j] = (int)(packedTable&7);
-        packedTable >>= 3;
-        piece += TABLE[i][j];
-      }
-      if (piece==3)
-      {
-        // Only three tiles live on this row - so the blank space is here.
-        space = i;
-      }
-    }
+#define DEFAULT_CACHE_ENTRIES (1 << 20)
 
-    // If the space is not on the bottom-most row, explore the states that
-    // involve moving a tile up into the space.
-    if ((piece = space + 1) < 4)
-    {
-      SwapAndWrite(piece, space, walkingDistance, 0);
-    }
+#define DEFAULT_ENDGAME_MEGABYTES 256
 
-    // If the space is not on the top-most row, explore the states that
-    // involve moving a tile down into the space.
-    if ((piece = space - 1) >= 0)
-    {
-      SwapAndWrite(piece, space, walkingDistance, 1);
-    }
-  }
+#define DEFAULT_CHECKPOINT_SECONDS 300
 
-  ///////////////////////////////////////////////////////////////////////////
+#define MAX_THREADS 64
 
-  // The inversion count table maps the count of inversion along an axis (i)
-  // to the minimum number of moves that would be needed to fix the inversion
-  // so the tiles are in order.
-  for (i=0; i<IDTBL_SIZE; i++)
-  {
-    IDTBL[i] = (char)((i/3) + (i%3));
-  }
-}
+#define MAX_LANES 64
 
 /////////////////////////////////////////////////////////////////////////////
 //
@@ -389,517 +99,2410 @@ void PrintPuzzle(int puzzle[PUZZLE_SIZE])
 
 /////////////////////////////////////////////////////////////////////////////
 //
-//  Calculates the inversion count used for lookup into the inversion distance
-//  heuristic. Can flip the axis of calculation via flipAxis parameter.
+//  Pack the puzzle across the axis flip, the way PackBoard packs it as it
+//  is: the tile numbers through CONV, at positions through CONVP.
 
-int InversionCount(int* puzzle, int flipAxis)
+u64 PackTransposed(int puzzle[PUZZLE_SIZE])
 {
-  int i,j;
-  int inversionCount = 0;
-  int currentTile;
-  int compareTile;
-
-  // For tile position index i, convp[i] will be the index of the position
-  // of the flipped-axis array.
-  int convp[PUZZLE_SIZE] = { 
-    0, 4, 8,12, 
-    1, 5, 9,13, 
-    2, 6,10,14, 
-    3, 7,11,15
-  };
+  u64 packed = 0;
 
-  for (i=0; i<PUZZLE_SIZE; i++)
+  for (int i = 0; i < PUZZLE_SIZE; i++)
   {
-    currentTile = flipAxis ? CONV[puzzle[convp[i]]] : puzzle[i];
-  
-    if (currentTile) // Skip blank
-    {
-      for (j=i+1; j<PUZZLE_SIZE; j++)
-      {
-        compareTile = flipAxis ? CONV[puzzle[convp[j]]] : puzzle[j];
-
-        if (compareTile && compareTile<currentTile) 
-        {
-          // Not blank && Inverted ordering
-          inversionCount++;
-        }
-      }
-    }
+    packed |= (u64)CONV[puzzle[i]] << (CONVP[i] * 4);
   }
 
-  return inversionCount;
+  return packed;
 }
 
+
 /////////////////////////////////////////////////////////////////////////////
 //
-//  Given the full set of indices, calculate the lower bound value to use
-//  as heuristic for the IDA* search.
+//  The heuristic as a whole-board callback for predict.h.
 
-int HeuristicValue(int idxV, int idxH, int invV, int invH)
+int PredictedWalkingDistance(const int puzzle[PUZZLE_SIZE], void *data)
 {
-  int wdV = WDTBL[idxV]; // Walking Distance for vertical tile movements.
-  int wdH = WDTBL[idxH]; // Walking Distance for horizontal tile movements.
-  int idV = IDTBL[invV]; // Inversion Distance for vertical tile movements.
-  int idH = IDTBL[invH]; // Inversion Distance for horizontal tile movements.
-  int lowbV = (wdV>idV)? wdV:idV; // Maximum of WD or ID is the lower bound.
-  int lowbH = (wdH>idH)? wdH:idH; // Maximum of WD or ID is the lower bound.
+  int idx1, idx2, inv1, inv2;
 
-  return lowbV + lowbH;
+  (void)data;
+  return HeuristicLookupIndices((int *)puzzle, &idx1, &idx2, &inv1, &inv2);
 }
 
 /////////////////////////////////////////////////////////////////////////////
 //
-//  The full set of Walking Distance calculations. This is required for the
-//  initial state of the search. After startup, as we search the problem tree,
-//  the WDLNK array can take care of updating the walking distance from step
-//  to step with far less computation involved.
-//
-//  Debug note: If we suspect the WDLNK update mechanism is broken, we can 
-//  fall back to performing this full calculation. But it is not recommended,
-//  it is extremely computationally expensive to do this for each tree node.
+//  Progress reports. While an iteration runs, the callback is given the
+//  node counts and an estimate of how far through the iteration the search
+//  is. The estimate treats every branch below a node as the same size, so
+//  it is rough early in an iteration, when the first few branches haven't
+//  been weighed against the rest.
 
-int HeuristicLookupIndices(int* puzzle, int *pidx1, int *pidx2, int *pinv1, int *pinv2)
+typedef struct
 {
-  int idx1, idx2, inv1, inv2;
-  u64 packedPuzzle;
-
-  // Calculate IDX1 - index into the Walking Distance table corresponding to
-  // the minimum number of tile movements across rows. (Vertical tile moves.)
-  packedPuzzle = PackPuzzle(puzzle, FALSE);
+  int limit;                          // Limit of the current iteration.
+  unsigned long long nodesAtLimit;    // Nodes so far in this iteration.
+  unsigned long long nodesTotal;      // Nodes in the iterations before it.
+  double fraction;                    // Estimated share of this iteration done.
+  double predictedNodes;              // Predicted nodes in this iteration, 0 if none.
+  double seconds;                     // Time spent in this iteration so far.
+} SearchProgress;
 
-  // Look for index of the WDPTN entry corresponding to this pattern.
-  for (idx1=0; WDPTN[idx1] != packedPuzzle; idx1++);
+typedef void (*ProgressCallback)(const SearchProgress *progress, void *userData);
 
-  // Calculate IDX2 - repeat the calculation made for IDX1, but this time
-  // for movement across columns. (Horizontal tile moves.) 
-  packedPuzzle = PackPuzzle(puzzle, TRUE);
+// Nodes between progress reports, less one: about a billion.
+#define PROGRESS_INTERVAL_MASK ((1ULL << 30) - 1)
 
-  // Look for index of the WDPTN entry corresponding to this pattern.
-  for (idx2=0; WDPTN[idx2] != packedPuzzle; idx2++);
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Everything needed to pick an interrupted search back up. The path is the
+//  blank directions from the starting board to the node the search was
+//  about to enter, and nodesAtLimit the node count of the iteration before
+//  it. Everything to the left of that path has been searched, so a resumed
+//  search walks straight down it and carries on, and arrives at the same
+//  node counts as a search that was never stopped.
+//
+//  Checkpoints are only taken on entering a node at most CHECKPOINT_DEPTH
+//  moves from the start. That keeps the check off the deeper levels, where
+//  almost all the nodes are, and still reaches a checkpoint within a
+//  fraction of a second of one being asked for.
 
-  // Calculate inv1 - the number of tile inversions along the horizontal axis
-  inv1 = InversionCount(puzzle, FALSE);
+#define CHECKPOINT_MAGIC 0x3154504B435A5550ULL // "PUZCKPT1"
+#define CHECKPOINT_DEPTH 16
 
-  // Calculate inv1 - the number of tile inversions along the vertical axis
-  inv2 = InversionCount(puzzle, TRUE);
+typedef struct
+{
+  u64 magic;
+  u64 boardIndex;               // BoardIndexOf the starting board.
+  u64 nodesTotal;               // Nodes in the completed iterations.
+  u64 nodesAtLimit;             // Nodes in this iteration before the path's end.
+  int limit;
+  int pathLength;
+  char path[CHECKPOINT_DEPTH];  // Blank directions, MOVE_UP etc.
+} Checkpoint;
+
+// Set from signal handlers, acted on by the search at the next node within
+// CHECKPOINT_DEPTH of the start.
+#define CHECKPOINT_NONE 0
+#define CHECKPOINT_SAVE 1       // Save and carry on.
+#define CHECKPOINT_STOP 2       // Save and stop searching.
+
+static volatile sig_atomic_t checkpointRequest = CHECKPOINT_NONE;
+
+// TRUE while the checkpoint file holds a checkpoint of the board being
+// searched: one it resumed from, or one it saved. Only then is the file
+// removed when the board is solved, since in a batch it may belong to a
+// later board.
+static int checkpointHeld = FALSE;
+
+// Returned up through the search when it stops for a checkpoint.
+#define SEARCH_STOPPED (-1)
 
-  // Copy values to outparams.
-  *pidx1 = idx1;
-  *pidx2 = idx2;
-  *pinv1 = inv1;
-  *pinv2 = inv2;
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Search settings that come from the command line.
 
-  return HeuristicValue(idx1, idx2, inv1, inv2);
-}
+typedef struct
+{
+  const EndgameTable *endgame;
+  const char *checkpointPath;   // NULL for no checkpoints.
+  ProgressCallback progress;    // NULL for no progress reports.
+  void *progressData;
+  int distanceOnly;             // Print nothing, only the length is wanted.
+  int astarMegabytes;           // Try A* in this much memory first, 0 not to.
+  const Predictor *predictor;   // NULL for no node count predictions.
+  int partialExpansion;         // Don't enter children the limit cuts off.
+  const PerfCounters *counters; // NULL for no per node counts.
+} SearchOptions;
 
 /////////////////////////////////////////////////////////////////////////////
 //
-//  Examine a node and recursively call self to search deeper in the tree
+//  The search state that doesn't change from node to node, passed down by
+//  pointer so each call carries fewer arguments.
 
-int ExamineNode(int puzzle[PUZZLE_SIZE],
-  int currentBlankIndex, int prevBlankIndex,
-  int idx1o, int idx2o, int inv1o, int inv2o,
-  int currentLength, int limitLength, unsigned long long *nodeCounter)
+typedef struct
 {
-  int val = HeuristicValue(idx1o, idx2o, inv1o, inv2o);;
+  int limitLength;
+  unsigned long long nodeCounter;
+  char *solutionMoves;
+  const EndgameTable *endgame;
+  const SearchOptions *options;
+  unsigned long long nodesTotal;    // Nodes in the completed iterations.
+  u64 boardIndex;                   // Of the starting board, for checkpoints.
+  int rootBlankIndex;
+  char path[MAX_SOLUTION_LENGTH];   // Blank directions to the current node.
+  double predictedNodes;            // In this iteration, 0 if not predicted.
+  struct timespec iterationStart;
+} SearchContext;
 
-  (*nodeCounter)++;
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Checkpoint file handling. Written to a temporary name and renamed over
+//  the old one, so a crash mid-write leaves the previous checkpoint intact.
 
-  if (((*nodeCounter) % 1000000000) == 0)
-  {
-    // Status update every billion nodes
-    printf("Limit: %d ongoing - with %llu nodes\n", limitLength, *nodeCounter);
-  }  
+int LoadCheckpoint(const char *path, Checkpoint *checkpoint)
+{
+  FILE *file = fopen(path, "rb");
+  int loaded;
 
-  if(puzzle[currentBlankIndex]!=0)
+  if (file == NULL)
   {
-    printf("ERROR: Blank index is not blank.\n");
+    return FALSE;
   }
 
-  if (val == 0)
+  loaded = (fread(checkpoint, sizeof(Checkpoint), 1, file) == 1 &&
+            checkpoint->magic == CHECKPOINT_MAGIC &&
+            checkpoint->pathLength >= 0 &&
+            checkpoint->pathLength <= CHECKPOINT_DEPTH);
+  fclose(file);
+
+  return loaded;
+}
+
+int SaveCheckpoint(const char *path, const Checkpoint *checkpoint)
+{
+  char tempPath[4096];
+  FILE *file;
+
+  snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+
+  file = fopen(tempPath, "wb");
+  if (file == NULL ||
+      fwrite(checkpoint, sizeof(Checkpoint), 1, file) != 1 ||
+      fflush(file) != 0 ||
+      fsync(fileno(file)) != 0)
   {
-    // Problem solved!
-    printf("\nTile movements to arrive in this state:\n");
-    return currentLength;
+    perror(tempPath);
+    if (file != NULL)
+    {
+      fclose(file);
+    }
+    return FALSE;
   }
-  else if (currentLength + val > limitLength)
+  fclose(file);
+
+  if (rename(tempPath, path) != 0)
   {
-    // Exceeded limit
-    return 0;
+    perror(path);
+    return FALSE;
   }
-  else
+
+  return TRUE;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Signal handlers. SIGTERM and SIGINT ask for a last checkpoint, SIGALRM
+//  for a periodic one, and rearm the alarm for the next.
+
+static unsigned int checkpointSeconds = DEFAULT_CHECKPOINT_SECONDS;
+
+static void StopSignal(int signalNumber)
+{
+  (void)signalNumber;
+  checkpointRequest = CHECKPOINT_STOP;
+}
+
+static void AlarmSignal(int signalNumber)
+{
+  (void)signalNumber;
+  if (checkpointRequest == CHECKPOINT_NONE)
   {
-    // Not terminating, so let's dig deeper
-    int row=0, col=0, ret=0, childBlankIndex=0;
-    int idx1, idx2, inv1, inv2;
+    checkpointRequest = CHECKPOINT_SAVE;
+  }
+  alarm(checkpointSeconds);
+}
 
-    GetColumnRow(currentBlankIndex, &col, &row);
+void InstallCheckpointSignals(unsigned int seconds)
+{
+  struct sigaction action;
 
-    for (int i = 0; i < 4; i++)
-    {
-      // Reset indices between iterations
-      idx1 = idx1o;
-      idx2 = idx2o;
-      inv1 = inv1o;
-      inv2 = inv2o;
+  memset(&action, 0, sizeof(action));
+  sigemptyset(&action.sa_mask);
 
-      if (i==0)
-      {
-        // Try moving the blank up
-        if (row==0)
-        {
-          // Can't move up - it's already on the top row.
-          continue;
-        }
-        else
-        {
-          childBlankIndex = currentBlankIndex - PUZZLE_COLUMN;
+  action.sa_handler = StopSignal;
+  sigaction(SIGTERM, &action, NULL);
+  sigaction(SIGINT, &action, NULL);
 
-          // Update inversion count for this move.
-          for (int j = childBlankIndex+1; j < currentBlankIndex; j++)
-          {
-            if (puzzle[j] > puzzle[childBlankIndex])
-            {
-              inv1++;
-            }
-            else
-            {
-              inv1--;
-            }
-          }
+  action.sa_handler = AlarmSignal;
+  sigaction(SIGALRM, &action, NULL);
 
-          // Look up the new Walking Distance index for this move.
-          idx1 = WDLNK[idx1][1][(puzzle[childBlankIndex]-1)>>2];
-        }
-      }
-      else if (i == 1)
-      {
-        // Try moving the blank down
-        if (row==PUZZLE_ROW-1)
-        {
-          // Can't move down - already on the bottom row.
-          continue;
-        }
-        else
-        {
-          childBlankIndex = currentBlankIndex + PUZZLE_COLUMN;
+  checkpointSeconds = seconds;
+  alarm(seconds);
+}
 
-          // Update inversion count for this move.
-          for (int j = currentBlankIndex+1; j < childBlankIndex; j++)
-          {
-            if (puzzle[j] > puzzle[childBlankIndex])
-            {
-              inv1--;
-            }
-            else
-            {
-              inv1++;
-            }
-          }
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Save a checkpoint at the node about to be entered at the given depth,
+//  if one is wanted. Returns TRUE if the search should stop. Kept out of
+//  line, as it runs once every few minutes at most.
 
-          // Look up the new Walking Distance index for this move.
-          idx1 = WDLNK[idx1][0][(puzzle[childBlankIndex]-1)>>2];
-        }
-      }
-      else if (i == 2)
-      {
-        // Try moving the blank left
-        if (col == 0)
-        {
-          // Can't move left - already on leftmost column.
-          continue;
-        }
-        else
-        {
-          childBlankIndex = currentBlankIndex - 1;
+static __attribute__((noinline, cold))
+int TakeCheckpoint(SearchContext *context, int currentLength)
+{
+  int stop = (checkpointRequest == CHECKPOINT_STOP);
+  Checkpoint checkpoint;
 
-          int convTile = CONV[puzzle[childBlankIndex]];
+  checkpointRequest = CHECKPOINT_NONE;
 
-          // Update inversion count for this move.
-          for (int j = childBlankIndex + PUZZLE_COLUMN; j < PUZZLE_SIZE; j+= PUZZLE_COLUMN)
-          {
-            if (CONV[puzzle[j]] > convTile)
-            {
-              inv2++;
-            }
-            else
-            {
-              inv2--;
-            }
-          }
+  if (context->options->checkpointPath == NULL)
+  {
+    return FALSE;
+  }
 
-          for (int j = currentBlankIndex - PUZZLE_COLUMN; j >= 0; j -= PUZZLE_COLUMN)
-          {
-            if (CONV[puzzle[j]] > convTile)
-            {
-              inv2++;
-            }
-            else
-            {
-              inv2--;
-            }
-          }
+  memset(&checkpoint, 0, sizeof(checkpoint));
+  checkpoint.magic = CHECKPOINT_MAGIC;
+  checkpoint.boardIndex = context->boardIndex;
+  checkpoint.nodesTotal = context->nodesTotal;
+  checkpoint.nodesAtLimit = context->nodeCounter;
+  checkpoint.limit = context->limitLength;
+  checkpoint.pathLength = currentLength;
+  memcpy(checkpoint.path, context->path, currentLength);
 
-          // Look up the new Walking Distance index for this move.
-          idx2 = WDLNK[idx2][1][(convTile-1)>>2];
-        }
-      }
-      else if (i == 3)
-      {
-        // Try moving the blank right
-        if (col == PUZZLE_COLUMN-1)
-        {
-          // Can't move right - already on the rightmost column.
-          continue;
-        }
-        else
-        {
-          childBlankIndex = currentBlankIndex + 1;
+  if (SaveCheckpoint(context->options->checkpointPath, &checkpoint))
+  {
+    checkpointHeld = TRUE;
+    printf("Limit: %d checkpoint saved at %llu nodes\n", context->limitLength, context->nodeCounter);
+  }
+  else
+  {
+    printf("Limit: %d checkpoint not saved at %llu nodes\n", context->limitLength, context->nodeCounter);
+  }
 
-          int convTile = CONV[puzzle[childBlankIndex]];
+  return stop;
+}
 
-          // Update inversion count for this move.
-          for (int j = currentBlankIndex+PUZZLE_COLUMN; j < PUZZLE_SIZE; j += PUZZLE_COLUMN)
-          {
-            if (CONV[puzzle[j]] > convTile)
-            {
-              inv2--;
-            }
-            else
-            {
-              inv2++;
-            }
-          }
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Estimate how much of the iteration is done from the path to the current
+//  node: at each step, the branches already passed over count as finished,
+//  and each branch is taken to be an equal share of its parent.
 
-          for (int j = childBlankIndex- PUZZLE_COLUMN; j >= 0; j -= PUZZLE_COLUMN)
-          {
-            if (CONV[puzzle[j]] > convTile)
-            {
-              inv2--;
-            }
-            else
-            {
-              inv2++;
-            }
-          }
+double EstimateIterationFraction(const SearchContext *context, int currentLength)
+{
+  static const int offset[4] = { -PUZZLE_COLUMN, PUZZLE_COLUMN, -1, 1 };
+  int blankIndex = context->rootBlankIndex;
+  int prevBlankIndex = -1;
+  int child, passed, branches;
+  double fraction = 0.0;
+  double share = 1.0;
+
+  for (int depth = 0; depth < currentLength; depth++)
+  {
+    passed = branches = 0;
 
-          // Look up the new Walking Distance index for this move.
-          idx2 = WDLNK[idx2][0][(convTile-1) >> 2];
-        }
-      }
+    for (int direction = MOVE_UP; direction <= MOVE_RIGHT; direction++)
+    {
+      child = blankIndex + offset[direction];
 
-      if(childBlankIndex == prevBlankIndex)
+      if (child < 0 || child >= PUZZLE_SIZE || child == prevBlankIndex ||
+          (direction >= MOVE_LEFT && child / PUZZLE_COLUMN != blankIndex / PUZZLE_COLUMN))
       {
-        // This retracts the move our parent just did, no point.
         continue;
       }
 
-      // Perform the swap
-      puzzle[currentBlankIndex] = puzzle[childBlankIndex];
-      puzzle[childBlankIndex] = 0;
-
-      // Recursive call to look at the next node
-      ret = ExamineNode(puzzle, 
-        childBlankIndex, currentBlankIndex,
-        idx1, idx2, inv1, inv2,
-        currentLength+1, limitLength, nodeCounter);
-
-      // Revert the swap
-      puzzle[childBlankIndex] = puzzle[currentBlankIndex];
-      puzzle[currentBlankIndex] = 0;
-
-      // Did the child find anything?
-      if (ret != 0)
+      branches++;
+      if (direction < context->path[depth])
       {
-        printf(" %d", puzzle[childBlankIndex]);
-        return ret;
+        passed++;
       }
     }
 
-    // None of the four directions proved fruitful
-    return 0;
+    share /= branches;
+    fraction += share * passed;
+
+    prevBlankIndex = blankIndex;
+    blankIndex += offset[(int)context->path[depth]];
   }
-}
 
+  return fraction;
+}
 
-/////////////////////////////////////////////////////////////////////////////
-//
-//  Execute the IDA* algorithm on the given puzzle state with given lookup table
-//  for calculating heuristic.
-//
-int IDAStar(int puzzle[PUZZLE_SIZE])
+static __attribute__((noinline, cold))
+void ReportProgress(const SearchContext *context, int currentLength)
 {
-  unsigned long long nodesTotal=0;
-  unsigned long long nodesAtLimit = 0;
-  int length = 0;
-  int idx1, idx2, inv1, inv2;
-  int limit = HeuristicLookupIndices(puzzle, &idx1, &idx2, &inv1, &inv2);
-
-  int blankIndex = GetBlankPosition(puzzle);
+  SearchProgress progress;
+  struct timespec now;
 
-  if (limit > 0)
-  {
-    while(0 == (length = ExamineNode(puzzle,
-                      blankIndex, -1 /* prevBlankIndex */, 
-                      idx1, idx2, inv1, inv2,
-                      0 /* Starting length */, limit, 
-                      &nodesAtLimit)))
-    {
-      printf("Limit: %d completed with %llu nodes\n", limit, nodesAtLimit);      
-      nodesTotal += nodesAtLimit;
-      length = 0;
-      nodesAtLimit = 0;
-      limit += 2;
-    }
-    printf("\n\nLimit: %d halted at %llu nodes\n", limit, nodesAtLimit);      
+  clock_gettime(CLOCK_MONOTONIC, &now);
 
-    nodesTotal += nodesAtLimit;
-  }
+  progress.limit = context->limitLength;
+  progress.nodesAtLimit = context->nodeCounter;
+  progress.nodesTotal = context->nodesTotal;
+  progress.fraction = EstimateIterationFraction(context, currentLength);
+  progress.predictedNodes = context->predictedNodes;
+  progress.seconds = (now.tv_sec - context->iterationStart.tv_sec) +
+                     (now.tv_nsec - context->iterationStart.tv_nsec) / 1e9;
 
-  printf("\n\nSolution of length %d found after searching %llu nodes\n", length, nodesTotal);
+  context->options->progress(&progress, context->options->progressData);
 }
 
 /////////////////////////////////////////////////////////////////////////////
 //
-//  Validation stage 1: Verify array has only integers 0 through 15, and only
-//    one of each.
+//  Default progress callback: the status line every billion nodes. With a
+//  prediction for the iteration, it also gives the time left at the rate
+//  so far.
 
-int TilesAreUnique(int* puzzle)
+void PrintProgress(const SearchProgress *progress, void *userData)
 {
-  int unique = 1;
-  int i;
-
-  int seenTile[PUZZLE_SIZE];
-
-  memset(seenTile, 0, sizeof(int)*PUZZLE_SIZE);
+  (void)userData;
+  printf("Limit: %d ongoing - with %llu nodes, about %.1f%% through",
+    progress->limit, progress->nodesAtLimit, progress->fraction * 100.0);
 
-  for(i = 0; i < PUZZLE_SIZE; i++)
+  if (progress->predictedNodes > 0 && progress->nodesAtLimit > 0)
   {
-    if(puzzle[i] < 0 || puzzle[i] > 15) 
-    {
-      printf("Out of range tile %d detected.\n\n", puzzle[i]);
-      unique = 0;
-    }
-    else if(seenTile[puzzle[i]] != 0)
+    double left = progress->predictedNodes - progress->nodesAtLimit;
+
+    printf(", %.3g predicted", progress->predictedNodes);
+    if (left > 0)
     {
-      printf("Duplicate tile %d detected.\n\n", puzzle[i]);
-      unique = 0;
+      printf(", about %.0f seconds to go", progress->seconds * left / progress->nodesAtLimit);
     }
     else
     {
-      seenTile[puzzle[i]] = 1;
+      printf(", past the prediction");
     }
   }
-
-  return unique;
+  printf("\n");
 }
 
 /////////////////////////////////////////////////////////////////////////////
 //
-//  Validation stage 2: Verify puzzle is solvable via inversion count rules.
+//  The search is split into sixteen kernels, one per blank position, all
+//  generated from ExamineBody below. Within a kernel the blank position is
+//  a constant, so the compiler drops the moves that would leave the board,
+//  turns the shifts into constants, and makes each move a direct call to
+//  the kernel for the child's blank position. What's left per node is the
+//  work that actually depends on the board.
+//
+//  There are two sets of kernels: the plain ones, and the ones for partial
+//  expansion (EPEIDA*), which work out each child's heuristic value before
+//  making the move and skip the child if it would only be cut off. The
+//  child's table indices are already worked out in the parent to be passed
+//  down, so the operator selection table is WDLNK itself, with WDTBL and
+//  IDTBL giving the new value. What a skipped child saves is the call, the
+//  two board updates and its node count.
+
+#define KERNEL_PARAMETERS u64 board, u64 transposed, int prevBlankIndex, \
+  int idx1o, int idx2o, int inv1o, int inv2o, int currentLength, SearchContext *context
+#define KERNEL_ARGUMENTS board, transposed, prevBlankIndex, \
+  idx1o, idx2o, inv1o, inv2o, currentLength, context
+
+typedef int (*SearchKernel)(KERNEL_PARAMETERS);
+
+#define DECLARE_KERNEL(position) static int ExamineAt##position(KERNEL_PARAMETERS); \
+  static int PartialAt##position(KERNEL_PARAMETERS);
+
+DECLARE_KERNEL(0)  DECLARE_KERNEL(1)  DECLARE_KERNEL(2)  DECLARE_KERNEL(3)
+DECLARE_KERNEL(4)  DECLARE_KERNEL(5)  DECLARE_KERNEL(6)  DECLARE_KERNEL(7)
+DECLARE_KERNEL(8)  DECLARE_KERNEL(9)  DECLARE_KERNEL(10) DECLARE_KERNEL(11)
+DECLARE_KERNEL(12) DECLARE_KERNEL(13) DECLARE_KERNEL(14) DECLARE_KERNEL(15)
+
+static SearchKernel const KERNELS[PUZZLE_SIZE] = {
+  ExamineAt0,  ExamineAt1,  ExamineAt2,  ExamineAt3,
+  ExamineAt4,  ExamineAt5,  ExamineAt6,  ExamineAt7,
+  ExamineAt8,  ExamineAt9,  ExamineAt10, ExamineAt11,
+  ExamineAt12, ExamineAt13, ExamineAt14, ExamineAt15
+};
 
-int PuzzleIsSolvable(int* puzzle)
+static SearchKernel const PARTIAL_KERNELS[PUZZLE_SIZE] = {
+  PartialAt0,  PartialAt1,  PartialAt2,  PartialAt3,
+  PartialAt4,  PartialAt5,  PartialAt6,  PartialAt7,
+  PartialAt8,  PartialAt9,  PartialAt10, PartialAt11,
+  PartialAt12, PartialAt13, PartialAt14, PartialAt15
+};
+
+// Kernel for a child blank position, from the same set as the parent. The
+// mask only keeps the index in range for moves that are compiled out anyway.
+#define CHILD_KERNEL(position) (partial ? PARTIAL_KERNELS : KERNELS)[(position) & (PUZZLE_SIZE-1)]
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Examine a node and recursively call self to search deeper in the tree.
+//  On the way back out of a solution, the blank's direction at each step is
+//  recorded in solutionMoves (MOVE_UP etc. from puzResult.h).
+//
+//  The board is passed as two packed copies instead of an array (see
+//  PackTransposed), so the whole node state fits in registers and each
+//  child is made with a few shifts. The inversion count changes come from
+//  INVDELTA, using the three tiles the moved tile jumps over, which sit in
+//  adjacent nibbles of one copy or the other.
+//
+//  With an endgame table, a node the heuristic puts within the table's depth
+//  is looked up in it. If found, its distance is exact: the search either
+//  ends there with the rest of the path taken from the table, or is cut off.
+//  If not found, the node is further away than the table's depth.
+//
+//  Always inlined into the kernels, with currentBlankIndex and partial
+//  constants.
+
+static inline __attribute__((always_inline))
+int ExamineBody(const int currentBlankIndex, const int partial, KERNEL_PARAMETERS)
 {
-  int inversionCountIsEven = ((InversionCount(puzzle,FALSE) % 2) == 0);
-  int solvable = 0;
+  const int row = currentBlankIndex / PUZZLE_COLUMN;
+  const int col = currentBlankIndex % PUZZLE_COLUMN;
+  const int currentConvIndex = col * PUZZLE_COLUMN + row;
+  int val = HeuristicValue(idx1o, idx2o, inv1o, inv2o);
+  int ret, tile;
+  int idx1, idx2, inv1, inv2;   // The child's, for the one table that changes.
+
+  if (currentLength <= CHECKPOINT_DEPTH && checkpointRequest != CHECKPOINT_NONE &&
+      TakeCheckpoint(context, currentLength))
+  {
+    return SEARCH_STOPPED;
+  }
 
-  if (PUZZLE_COLUMN % 2 == 0)
+  context->nodeCounter++;
+
+  if ((context->nodeCounter & PROGRESS_INTERVAL_MASK) == 0 && context->options->progress != NULL)
   {
-    int indexBlank = GetBlankPosition(puzzle);
-    int blankEvenRowFromDesired = (((PUZZLE_ROW - (indexBlank/PUZZLE_COLUMN)) % 2) == 1);
+    ReportProgress(context, currentLength);
+  }
 
-    if (blankEvenRowFromDesired)
+  if (context->endgame != NULL && val <= context->endgame->depth)
+  {
+    int distance = EndgameDistance(context->endgame, board);
+
+    if (distance < 0)
     {
-      solvable = inversionCountIsEven;
+      val = EndgameBound(context->endgame, currentBlankIndex);
+    }
+    else if (currentLength + distance <= context->limitLength)
+    {
+      // Problem solved, with the last moves from the endgame table.
+      char tiles[MAX_SOLUTION_LENGTH];
+
+      EndgamePath(context->endgame, board, &context->solutionMoves[currentLength], tiles);
+
+      if (!context->options->distanceOnly)
+      {
+        printf("\nTile movements to arrive in this state:\n");
+        for (int j = distance-1; j >= 0; j--)
+        {
+          printf(" %d", tiles[j]);
+        }
+      }
+      return currentLength + distance;
     }
     else
     {
-      solvable = !inversionCountIsEven;
+      val = distance;
     }
   }
-  else
+
+  if (val == 0)
   {
-    solvable = inversionCountIsEven;
+    // Problem solved!
+    if (!context->options->distanceOnly)
+    {
+      printf("\nTile movements to arrive in this state:\n");
+    }
+    return currentLength;
+  }
+  else if (currentLength + val > context->limitLength)
+  {
+    // Exceeded limit
+    return 0;
   }
 
-  if (!solvable)
+  // Not terminating, so let's dig deeper. Each move is only compiled in
+  // where the blank can make it, and skipped if it retracts the move our
+  // parent just did. With partial expansion, a child that the limit would
+  // cut off as soon as it was entered isn't entered at all.
+
+  if (row > 0 && currentBlankIndex - PUZZLE_COLUMN != prevBlankIndex)
   {
-    printf("Unsolvable puzzle configuration detected.\n\n");
+    // Move the blank up: the tile jumps down over the three tiles after it.
+    tile = PackedTile(board, currentBlankIndex - PUZZLE_COLUMN);
+    idx1 = WDLNK[idx1o][1][(tile-1)>>2];
+    inv1 = inv1o + INVDELTA[tile][(board >> ((currentBlankIndex - PUZZLE_COLUMN + 1) * 4)) & 0xFFF];
+
+    if (!partial || currentLength + 1 + HeuristicValue(idx1, idx2o, inv1, inv2o) <= context->limitLength)
+    {
+      context->path[currentLength] = MOVE_UP;
+      ret = CHILD_KERNEL(currentBlankIndex - PUZZLE_COLUMN)(
+        PackedMove(board, currentBlankIndex - PUZZLE_COLUMN, currentBlankIndex),
+        PackedMove(transposed, currentConvIndex - 1, currentConvIndex),
+        currentBlankIndex,
+        idx1, idx2o, inv1, inv2o,
+        currentLength+1, context);
+
+      if (ret > 0)
+      {
+        if (!context->options->distanceOnly)
+        {
+          printf(" %d", tile);
+        }
+        context->solutionMoves[currentLength] = MOVE_UP;
+        return ret;
+      }
+      else if (ret < 0)
+      {
+        return ret;
+      }
+    }
   }
 
-  return solvable;
+  if (row < PUZZLE_ROW-1 && currentBlankIndex + PUZZLE_COLUMN != prevBlankIndex)
+  {
+    // Move the blank down: the tile jumps up over the three tiles before it.
+    tile = PackedTile(board, currentBlankIndex + PUZZLE_COLUMN);
+    idx1 = WDLNK[idx1o][0][(tile-1)>>2];
+    inv1 = inv1o - INVDELTA[tile][(board >> ((currentBlankIndex + 1) * 4)) & 0xFFF];
+
+    if (!partial || currentLength + 1 + HeuristicValue(idx1, idx2o, inv1, inv2o) <= context->limitLength)
+    {
+      context->path[currentLength] = MOVE_DOWN;
+      ret = CHILD_KERNEL(currentBlankIndex + PUZZLE_COLUMN)(
+        PackedMove(board, currentBlankIndex + PUZZLE_COLUMN, currentBlankIndex),
+        PackedMove(transposed, currentConvIndex + 1, currentConvIndex),
+        currentBlankIndex,
+        idx1, idx2o, inv1, inv2o,
+        currentLength+1, context);
+
+      if (ret > 0)
+      {
+        if (!context->options->distanceOnly)
+        {
+          printf(" %d", tile);
+        }
+        context->solutionMoves[currentLength] = MOVE_DOWN;
+        return ret;
+      }
+      else if (ret < 0)
+      {
+        return ret;
+      }
+    }
+  }
+
+  if (col > 0 && currentBlankIndex - 1 != prevBlankIndex)
+  {
+    // Move the blank left: same as up, in the transposed board.
+    tile = PackedTile(transposed, currentConvIndex - PUZZLE_COLUMN);
+    idx2 = WDLNK[idx2o][1][(tile-1)>>2];
+    inv2 = inv2o + INVDELTA[tile][(transposed >> ((currentConvIndex - PUZZLE_COLUMN + 1) * 4)) & 0xFFF];
+
+    if (!partial || currentLength + 1 + HeuristicValue(idx1o, idx2, inv1o, inv2) <= context->limitLength)
+    {
+      context->path[currentLength] = MOVE_LEFT;
+      ret = CHILD_KERNEL(currentBlankIndex - 1)(
+        PackedMove(board, currentBlankIndex - 1, currentBlankIndex),
+        PackedMove(transposed, currentConvIndex - PUZZLE_COLUMN, currentConvIndex),
+        currentBlankIndex,
+        idx1o, idx2, inv1o, inv2,
+        currentLength+1, context);
+
+      if (ret > 0)
+      {
+        if (!context->options->distanceOnly)
+        {
+          printf(" %d", PackedTile(board, currentBlankIndex - 1));
+        }
+        context->solutionMoves[currentLength] = MOVE_LEFT;
+        return ret;
+      }
+      else if (ret < 0)
+      {
+        return ret;
+      }
+    }
+  }
+
+  if (col < PUZZLE_COLUMN-1 && currentBlankIndex + 1 != prevBlankIndex)
+  {
+    // Move the blank right: same as down, in the transposed board.
+    tile = PackedTile(transposed, currentConvIndex + PUZZLE_COLUMN);
+    idx2 = WDLNK[idx2o][0][(tile-1)>>2];
+    inv2 = inv2o - INVDELTA[tile][(transposed >> ((currentConvIndex + 1) * 4)) & 0xFFF];
+
+    if (!partial || currentLength + 1 + HeuristicValue(idx1o, idx2, inv1o, inv2) <= context->limitLength)
+    {
+      context->path[currentLength] = MOVE_RIGHT;
+      ret = CHILD_KERNEL(currentBlankIndex + 1)(
+        PackedMove(board, currentBlankIndex + 1, currentBlankIndex),
+        PackedMove(transposed, currentConvIndex + PUZZLE_COLUMN, currentConvIndex),
+        currentBlankIndex,
+        idx1o, idx2, inv1o, inv2,
+        currentLength+1, context);
+
+      if (ret > 0)
+      {
+        if (!context->options->distanceOnly)
+        {
+          printf(" %d", PackedTile(board, currentBlankIndex + 1));
+        }
+        context->solutionMoves[currentLength] = MOVE_RIGHT;
+        return ret;
+      }
+      else if (ret < 0)
+      {
+        return ret;
+      }
+    }
+  }
+
+  // None of the directions proved fruitful
+  return 0;
 }
 
+#define DEFINE_KERNEL(position) \
+  static int ExamineAt##position(KERNEL_PARAMETERS) \
+  { \
+    return ExamineBody(position, FALSE, KERNEL_ARGUMENTS); \
+  } \
+  static int PartialAt##position(KERNEL_PARAMETERS) \
+  { \
+    return ExamineBody(position, TRUE, KERNEL_ARGUMENTS); \
+  }
+
+DEFINE_KERNEL(0)  DEFINE_KERNEL(1)  DEFINE_KERNEL(2)  DEFINE_KERNEL(3)
+DEFINE_KERNEL(4)  DEFINE_KERNEL(5)  DEFINE_KERNEL(6)  DEFINE_KERNEL(7)
+DEFINE_KERNEL(8)  DEFINE_KERNEL(9)  DEFINE_KERNEL(10) DEFINE_KERNEL(11)
+DEFINE_KERNEL(12) DEFINE_KERNEL(13) DEFINE_KERNEL(14) DEFINE_KERNEL(15)
+
 /////////////////////////////////////////////////////////////////////////////
 //
-//  Calls all the puzzle state validations in turn
-//
+//  Search from the given node: hand it to the kernel for its blank position,
+//  from the set the options call for.
 
-int Valid(int* puzzle)
+int ExamineNode(u64 board, u64 transposed,
+  int currentBlankIndex, int prevBlankIndex,
+  int idx1, int idx2, int inv1, int inv2,
+  int currentLength, SearchContext *context)
 {
-  return TilesAreUnique(puzzle) &&
-         PuzzleIsSolvable(puzzle);
+  SearchKernel const *kernels = context->options->partialExpansion ? PARTIAL_KERNELS : KERNELS;
+
+  return kernels[currentBlankIndex](board, transposed, prevBlankIndex,
+    idx1, idx2, inv1, inv2, currentLength, context);
 }
 
 /////////////////////////////////////////////////////////////////////////////
 //
-//  Read in puzzle state from user input
-//
-
-void ReadPuzzleFromInput(int* puzzle)
+//  Finish an iteration from a checkpoint. Everything to the left of the
+//  checkpoint's path was searched before it was taken, and the nodes on the
+//  path were counted, so: search the node at the end of the path, then
+//  climb back up it, searching the moves to the right of the path from each
+//  node on the way. Each of those nodes is set up from scratch, which costs
+//  nothing next to the subtrees below them. Returns what ExamineNode would
+//  have for the whole iteration.
+
+int ResumeIteration(int puzzle[PUZZLE_SIZE], const Checkpoint *checkpoint, SearchContext *context)
 {
-  int i, j;
+  static const int offset[4] = { -PUZZLE_COLUMN, PUZZLE_COLUMN, -1, 1 };
+  int boards[CHECKPOINT_DEPTH+1][PUZZLE_SIZE];
+  int blanks[CHECKPOINT_DEPTH+1];
+  int child[PUZZLE_SIZE];
+  int length = checkpoint->pathLength;
+  int idx1, idx2, inv1, inv2;
+  int depth, direction, childBlankIndex, prevBlankIndex;
+  int ret = 0;
+
+  memcpy(boards[0], puzzle, sizeof(boards[0]));
+  blanks[0] = context->rootBlankIndex;
+  memcpy(context->path, checkpoint->path, length);
+
+  for (depth = 0; depth < length; depth++)
+  {
+    blanks[depth+1] = blanks[depth] + offset[(int)checkpoint->path[depth]];
+    memcpy(boards[depth+1], boards[depth], sizeof(boards[0]));
+    boards[depth+1][blanks[depth]] = boards[depth][blanks[depth+1]];
+    boards[depth+1][blanks[depth+1]] = 0;
+  }
+
+  HeuristicLookupIndices(boards[length], &idx1, &idx2, &inv1, &inv2);
+  ret = ExamineNode(PackBoard(boards[length]), PackTransposed(boards[length]),
+          blanks[length], length > 0 ? blanks[length-1] : -1,
+          idx1, idx2, inv1, inv2, length, context);
+
+  for (depth = length-1; depth >= 0 && ret == 0; depth--)
+  {
+    prevBlankIndex = depth > 0 ? blanks[depth-1] : -1;
+
+    for (direction = checkpoint->path[depth] + 1; direction <= MOVE_RIGHT && ret == 0; direction++)
+    {
+      childBlankIndex = blanks[depth] + offset[direction];
+
+      if (childBlankIndex < 0 || childBlankIndex >= PUZZLE_SIZE || childBlankIndex == prevBlankIndex ||
+          (direction >= MOVE_LEFT && childBlankIndex / PUZZLE_COLUMN != blanks[depth] / PUZZLE_COLUMN))
+      {
+        continue;
+      }
+
+      memcpy(child, boards[depth], sizeof(child));
+      child[blanks[depth]] = child[childBlankIndex];
+      child[childBlankIndex] = 0;
+
+      context->path[depth] = (char)direction;
+      if (HeuristicLookupIndices(child, &idx1, &idx2, &inv1, &inv2) + depth + 1 > context->limitLength &&
+          context->options->partialExpansion)
+      {
+        continue;
+      }
+      ret = ExamineNode(PackBoard(child), PackTransposed(child),
+              childBlankIndex, blanks[depth],
+              idx1, idx2, inv1, inv2, depth+1, context);
+
+      if (ret > 0)
+      {
+        if (!context->options->distanceOnly)
+        {
+          printf(" %d", boards[depth][childBlankIndex]);
+        }
+        context->solutionMoves[depth] = (char)direction;
+      }
+    }
+  }
 
-  // printf("15-Puzzle solver\n\n");
-  // printf("Here are the tile position indices:\n\n");
-  // printf("  0  1  2  3\n");
-  // printf("  4  5  6  7\n");
-  // printf("  8  9 10 11\n");
-  // printf(" 12 13 14 15\n\n");
-  // printf("The solution state, with the blank in the lower-right (position index 15), is represented by the sequence\n\n");
-  // printf("1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 0\n\n");
+  // A solution found below the path still needs the path's own moves.
+  for (; depth >= 0 && ret > 0; depth--)
+  {
+    if (!context->options->distanceOnly)
+    {
+      printf(" %d", boards[depth][blanks[depth+1]]);
+    }
+    context->solutionMoves[depth] = checkpoint->path[depth];
+  }
 
-  memset(puzzle, 0, sizeof(int)*PUZZLE_SIZE);
+  return ret;
+}
 
-  do
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Execute the IDA* algorithm on the given puzzle state with given lookup table
+//  for calculating heuristic. Returns the solution length, with the moves in
+//  solutionMoves and the total node count in nodesSearched.
+//
+//  With a checkpoint file, a checkpoint for this board picks the search up
+//  where it stopped. Returns SEARCH_STOPPED if the search is stopped by a
+//  signal; checkpointHeld says whether there is a checkpoint to resume
+//  from. The checkpoint is removed once the puzzle is solved, if it is
+//  this board's.
+//
+//  With options->distanceOnly nothing is printed, so searches can run side
+//  by side on several threads. The moves are still filled in, since they
+//  cost nothing but a store per move on the way out.
+//
+int IDAStar(int puzzle[PUZZLE_SIZE], char solutionMoves[MAX_SOLUTION_LENGTH],
+  unsigned long long *nodesSearched, const SearchOptions *options)
+{
+  SearchContext context;
+  Checkpoint checkpoint;
+  int resume = FALSE;
+  int length = 0;
+  int idx1, idx2, inv1, inv2;
+  int limit = HeuristicLookupIndices(puzzle, &idx1, &idx2, &inv1, &inv2);
+  int predicting = options->predictor != NULL && !options->distanceOnly;
+  double predicted = 0.0;
+  double scale = 1.0;             // Actual nodes over predicted, last iteration.
+  double rate = 0.0;              // Nodes per second, last iteration.
+  struct timespec end;
+  uint64_t traceBegin;
+  PerfSample searchStart, iterationStart, sample;
+
+  memset(&context, 0, sizeof(context));
+  context.solutionMoves = solutionMoves;
+  context.endgame = options->endgame;
+  context.options = options;
+  context.boardIndex = BoardIndexOf(puzzle, PUZZLE_COLUMN, PUZZLE_ROW, NULL);
+  context.rootBlankIndex = GetBlankPosition(puzzle);
+
+  checkpointHeld = FALSE;
+  if (options->checkpointPath != NULL &&
+      LoadCheckpoint(options->checkpointPath, &checkpoint) &&
+      checkpoint.boardIndex == context.boardIndex)
   {
-    printf("Enter the starting configuration for the puzzle:\n");
+    resume = TRUE;
+    checkpointHeld = TRUE;
+    limit = checkpoint.limit;
+    context.nodesTotal = checkpoint.nodesTotal;
+    context.nodeCounter = checkpoint.nodesAtLimit;
+    if (!options->distanceOnly)
+    {
+      printf("Resuming limit %d from checkpoint at %llu nodes, %d moves deep\n",
+        limit, context.nodeCounter, checkpoint.pathLength);
+    }
+  }
 
-    for(i = 0; i < PUZZLE_SIZE; i++)
+  PerfRead(options->counters, &searchStart);
+
+  if (limit > 0)
+  {
+    for (;;)
     {
-      j = scanf("%d", &puzzle[i]);
-      if(j==EOF)
+      context.limitLength = limit;
+      if (predicting)
+      {
+        predicted = PredictIteration(options->predictor, puzzle, limit);
+        if (predicted < 0)
+        {
+          printf("Limit: %d can't be predicted (out of memory)\n", limit);
+          predicting = FALSE;
+          predicted = 0.0;
+          context.predictedNodes = 0.0;
+        }
+      }
+      if (predicting)
+      {
+        context.predictedNodes = predicted * scale;
+        printf("Limit: %d predicted %.3g nodes", limit, context.predictedNodes);
+        if (rate > 0)
+        {
+          printf(", about %.1f seconds", context.predictedNodes / rate);
+        }
+        printf("\n");
+      }
+      clock_gettime(CLOCK_MONOTONIC, &context.iterationStart);
+      traceBegin = TraceBegin();
+      PerfRead(options->counters, &iterationStart);
+
+      if (resume)
+      {
+        length = ResumeIteration(puzzle, &checkpoint, &context);
+        resume = FALSE;
+      }
+      else
+      {
+        length = ExamineNode(PackBoard(puzzle), PackTransposed(puzzle),
+                   context.rootBlankIndex, -1 /* prevBlankIndex */,
+                   idx1, idx2, inv1, inv2,
+                   0 /* Starting length */, &context);
+      }
+      TraceEnd(traceBegin, "search", "iteration", "limit", limit);
+      if (length != 0)
       {
         break;
       }
-      else if (j != 1)
+
+      if (!options->distanceOnly)
+      {
+        printf("Limit: %d completed with %llu nodes\n", limit, context.nodeCounter);
+        PerfRead(options->counters, &sample);
+        PerfPrint(options->counters, "  per node", &iterationStart, &sample, context.nodeCounter);
+      }
+
+      // Later predictions are scaled by how far off this one was.
+      if (predicting && predicted > 0)
+      {
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        scale = context.nodeCounter / predicted;
+        rate = context.nodeCounter / ((end.tv_sec - context.iterationStart.tv_sec) +
+                                      (end.tv_nsec - context.iterationStart.tv_nsec) / 1e9);
+      }
+      context.nodesTotal += context.nodeCounter;
+      context.nodeCounter = 0;
+      limit += 2;
+    }
+
+    if (length == SEARCH_STOPPED)
+    {
+      if (!options->distanceOnly)
       {
-        printf("ERROR: Expected 1 input, got %d\n", j);
+        printf("\nLimit: %d stopped at %llu nodes\n", limit, context.nodeCounter);
       }
+      *nodesSearched = context.nodesTotal + context.nodeCounter;
+      return SEARCH_STOPPED;
+    }
+
+    if (!options->distanceOnly)
+    {
+      printf("\n\nLimit: %d halted at %llu nodes\n", limit, context.nodeCounter);
+      PerfRead(options->counters, &sample);
+      PerfPrint(options->counters, "  per node", &iterationStart, &sample, context.nodeCounter);
     }
 
-    printf("\nThe input received were as follows:\n\n");
+    context.nodesTotal += context.nodeCounter;
+  }
 
-    PrintPuzzle(puzzle);
+  if (options->checkpointPath != NULL && checkpointHeld)
+  {
+    remove(options->checkpointPath);
+    checkpointHeld = FALSE;
   }
-  while(!Valid(puzzle));
+
+  if (!options->distanceOnly)
+  {
+    printf("\n\nSolution of length %d found after searching %llu nodes\n", length, context.nodesTotal);
+    PerfRead(options->counters, &sample);
+    PerfPrint(options->counters, options->partialExpansion ? "EPEIDA* per node" : "IDA* per node",
+      &searchStart, &sample, context.nodesTotal);
+  }
+
+  *nodesSearched = context.nodesTotal;
+
+  return length;
 }
 
 /////////////////////////////////////////////////////////////////////////////
 //
-//  Main
-//
+//  Make the child of an A* node reached by moving the blank in the given
+//  direction, with the same incremental updates the kernels use. Returns
+//  FALSE if the blank can't move that way, or the move undoes the parent's.
 
-int main()
+int MakeAStarChild(const AStarNode *node, int parentBlank, int direction, AStarNode *child)
 {
-  int puzzle[PUZZLE_SIZE];
+  int blank = node->blank;
+  int row = blank / PUZZLE_COLUMN;
+  int col = blank % PUZZLE_COLUMN;
+  int convIndex = col * PUZZLE_COLUMN + row;
+  int tile;
+
+  *child = *node;
+
+  switch (direction)
+  {
+    case MOVE_UP:
+      if (row == 0 || blank - PUZZLE_COLUMN == parentBlank)
+      {
+        return FALSE;
+      }
+      tile = PackedTile(node->board, blank - PUZZLE_COLUMN);
+      child->board = PackedMove(node->board, blank - PUZZLE_COLUMN, blank);
+      child->transposed = PackedMove(node->transposed, convIndex - 1, convIndex);
+      child->idx1 = WDLNK[node->idx1][1][(tile-1)>>2];
+      child->inv1 = node->inv1 + INVDELTA[tile][(node->board >> ((blank - PUZZLE_COLUMN + 1) * 4)) & 0xFFF];
+      child->blank = blank - PUZZLE_COLUMN;
+      break;
+
+    case MOVE_DOWN:
+      if (row == PUZZLE_ROW-1 || blank + PUZZLE_COLUMN == parentBlank)
+      {
+        return FALSE;
+      }
+      tile = PackedTile(node->board, blank + PUZZLE_COLUMN);
+      child->board = PackedMove(node->board, blank + PUZZLE_COLUMN, blank);
+      child->transposed = PackedMove(node->transposed, convIndex + 1, convIndex);
+      child->idx1 = WDLNK[node->idx1][0][(tile-1)>>2];
+      child->inv1 = node->inv1 - INVDELTA[tile][(node->board >> ((blank + 1) * 4)) & 0xFFF];
+      child->blank = blank + PUZZLE_COLUMN;
+      break;
+
+    case MOVE_LEFT:
+      if (col == 0 || blank - 1 == parentBlank)
+      {
+        return FALSE;
+      }
+      tile = PackedTile(node->transposed, convIndex - PUZZLE_COLUMN);
+      child->board = PackedMove(node->board, blank - 1, blank);
+      child->transposed = PackedMove(node->transposed, convIndex - PUZZLE_COLUMN, convIndex);
+      child->idx2 = WDLNK[node->idx2][1][(tile-1)>>2];
+      child->inv2 = node->inv2 + INVDELTA[tile][(node->transposed >> ((convIndex - PUZZLE_COLUMN + 1) * 4)) & 0xFFF];
+      child->blank = blank - 1;
+      break;
+
+    default:
+      if (col == PUZZLE_COLUMN-1 || blank + 1 == parentBlank)
+      {
+        return FALSE;
+      }
+      tile = PackedTile(node->transposed, convIndex + PUZZLE_COLUMN);
+      child->board = PackedMove(node->board, blank + 1, blank);
+      child->transposed = PackedMove(node->transposed, convIndex + PUZZLE_COLUMN, convIndex);
+      child->idx2 = WDLNK[node->idx2][0][(tile-1)>>2];
+      child->inv2 = node->inv2 - INVDELTA[tile][(node->transposed >> ((convIndex + 1) * 4)) & 0xFFF];
+      child->blank = blank + 1;
+      break;
+  }
+
+  child->g = node->g + 1;
+
+  return TRUE;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  A* with the same heuristic as IDAStar, in at most the memory the options
+//  allow (see astar.h). Walking Distance plus inversions never drops by
+//  more than one per move, so the first time a board comes off the open
+//  list its path is the shortest, and every board is expanded at most
+//  once. A board reached again by a shorter path gets a new node, and the
+//  old one is marked stale and skipped when it comes off the open list.
+//
+//  If the memory runs out first, by reaching the limit or by an allocation
+//  failing, it is all freed and the puzzle is handed to IDAStar. Carrying
+//  on without a child would lose its board, and the result could then be
+//  too long. Returns the solution length, with the moves in solutionMoves
+//  and the node count in nodesSearched. After a fallback the node count
+//  covers both searches.
+//
+int AStar(int puzzle[PUZZLE_SIZE], char solutionMoves[MAX_SOLUTION_LENGTH],
+  unsigned long long *nodesSearched, const SearchOptions *options)
+{
+  AStarMemory memory;
+  AStarNode *node;
+  AStarNode child;
+  uint32_t index, childIndex, previous;
+  unsigned long long expanded = 0;
   int idx1, idx2, inv1, inv2;
+  int f, h, parentBlank, length = -1;
+  int full = FALSE;
+  PerfSample start, end;
 
-  GenerateWalkingDistanceLookup();
+  if (InitAStarMemory(&memory, (size_t)options->astarMegabytes << 20) != 0)
+  {
+    printf("ERROR: Out of memory for A*\n");
+    return IDAStar(puzzle, solutionMoves, nodesSearched, options);
+  }
 
-  ReadPuzzleFromInput(puzzle);
+  PerfRead(options->counters, &start);
+  h = HeuristicLookupIndices(puzzle, &idx1, &idx2, &inv1, &inv2);
+  if ((index = AllocateNode(&memory)) == ASTAR_NONE)
+  {
+    printf("ERROR: Out of memory for A*\n");
+    FreeAStarMemory(&memory);
+    return IDAStar(puzzle, solutionMoves, nodesSearched, options);
+  }
+  node = NodeAt(&memory, index);
+  node->board = PackBoard(puzzle);
+  node->transposed = PackTransposed(puzzle);
+  node->parent = ASTAR_NONE;
+  node->idx1 = (int16_t)idx1;
+  node->idx2 = (int16_t)idx2;
+  node->inv1 = (uint8_t)inv1;
+  node->inv2 = (uint8_t)inv2;
+  node->g = 0;
+  node->blank = (uint8_t)GetBlankPosition(puzzle);
+  *ClosedSlot(&memory, node->board) = index + 1;
+  PushOpen(&memory, index, h);
+
+  while (!full && memory.nodeCount < memory.maxNodes &&
+         (index = PopOpen(&memory, &f)) != ASTAR_NONE)
+  {
+    node = NodeAt(&memory, index);
+
+    if (node->g == ASTAR_STALE)
+    {
+      // Reached again by a shorter path since this node was made.
+      continue;
+    }
+
+    if (f == node->g)
+    {
+      // Heuristic of zero: solved.
+      length = node->g;
+      break;
+    }
+
+    expanded++;
+    parentBlank = (node->parent == ASTAR_NONE) ? -1 : NodeAt(&memory, node->parent)->blank;
+
+    for (int direction = MOVE_UP; direction <= MOVE_RIGHT; direction++)
+    {
+      if (!MakeAStarChild(node, parentBlank, direction, &child))
+      {
+        continue;
+      }
+
+      // Nothing that far out is on an optimal path.
+      h = HeuristicValue(child.idx1, child.idx2, child.inv1, child.inv2);
+      if (child.g + h >= ASTAR_MAX_F)
+      {
+        continue;
+      }
+
+      // An index, not the slot itself, as allocating may grow the table.
+      previous = *ClosedSlot(&memory, child.board);
+      if (previous != 0 && NodeAt(&memory, previous - 1)->g <= child.g)
+      {
+        continue;
+      }
+
+      if ((childIndex = AllocateNode(&memory)) == ASTAR_NONE)
+      {
+        full = TRUE;
+        break;
+      }
+
+      if (previous != 0)
+      {
+        NodeAt(&memory, previous - 1)->g = ASTAR_STALE;
+      }
 
-  printf("Initial heuristic value of %d\n\n", HeuristicLookupIndices(puzzle, &idx1, &idx2, &inv1, &inv2));
+      child.parent = index;
+      *NodeAt(&memory, childIndex) = child;
+      *ClosedSlot(&memory, child.board) = childIndex + 1;
+      PushOpen(&memory, childIndex, child.g + h);
+    }
+  }
 
-  IDAStar(puzzle);
- }
\ No newline at end of file
+  PerfRead(options->counters, &end);
+
+  if (length < 0)
+  {
+    if (!options->distanceOnly)
+    {
+      printf("A*: memory limit reached after %llu expansions, %u nodes stored, falling back to IDA*\n",
+        expanded, memory.nodeCount);
+      PerfPrint(options->counters, "A* per expansion", &start, &end, expanded);
+    }
+    FreeAStarMemory(&memory);
+
+    length = IDAStar(puzzle, solutionMoves, nodesSearched, options);
+    *nodesSearched += expanded;
+
+    return length;
+  }
+
+  // Walk the parent links back from the goal for the moves, last first.
+  if (!options->distanceOnly)
+  {
+    printf("\nTile movements to arrive in this state:\n");
+  }
+
+  for (uint32_t i = index; NodeAt(&memory, i)->parent != ASTAR_NONE; i = NodeAt(&memory, i)->parent)
+  {
+    AStarNode *step = NodeAt(&memory, i);
+    AStarNode *parent = NodeAt(&memory, step->parent);
+    int offset = step->blank - parent->blank;
+
+    solutionMoves[step->g - 1] = offset == -PUZZLE_COLUMN ? MOVE_UP :
+                                 offset == PUZZLE_COLUMN ? MOVE_DOWN :
+                                 offset == -1 ? MOVE_LEFT : MOVE_RIGHT;
+    if (!options->distanceOnly)
+    {
+      printf(" %d", PackedTile(parent->board, step->blank));
+    }
+  }
+
+  if (!options->distanceOnly)
+  {
+    printf("\n\nSolution of length %d found by A* after expanding %llu nodes, %u stored\n",
+      length, expanded, memory.nodeCount);
+    PerfPrint(options->counters, "A* per expansion", &start, &end, expanded);
+  }
+
+  FreeAStarMemory(&memory);
+
+  *nodesSearched = expanded;
+
+  return length;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Solve with A* if the options ask for it, otherwise IDA*.
+
+int SolvePuzzle(int puzzle[PUZZLE_SIZE], char solutionMoves[MAX_SOLUTION_LENGTH],
+  unsigned long long *nodesSearched, const SearchOptions *options)
+{
+  if (options->astarMegabytes > 0)
+  {
+    return AStar(puzzle, solutionMoves, nodesSearched, options);
+  }
+
+  return IDAStar(puzzle, solutionMoves, nodesSearched, options);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Self check of the incremental heuristic updates, for make check. Random
+//  walks out from the solved state make every move with MakeAStarChild,
+//  which updates the packed boards, WDLNK indices and inversion counts the
+//  way the search kernels do. After each move, those are compared with
+//  PackBoard, PackTransposed and HeuristicLookupIndices on the board
+//  unpacked from scratch. Returns the number of moves that disagree.
+
+#define SELF_CHECK_MOVES 200
+
+int CheckIncrementalUpdates(int walks)
+{
+  uint64_t random = 0x9E3779B97F4A7C15ULL;
+  AStarNode node, child;
+  int puzzle[PUZZLE_SIZE];
+  int idx1, idx2, inv1, inv2, value;
+  int parentBlank;
+  int errors = 0;
+
+  for (int walk = 0; walk < walks; walk++)
+  {
+    for (int i = 0; i < PUZZLE_SIZE; i++)
+    {
+      puzzle[i] = (i + 1) % PUZZLE_SIZE;
+    }
+    HeuristicLookupIndices(puzzle, &idx1, &idx2, &inv1, &inv2);
+
+    memset(&node, 0, sizeof(node));
+    node.board = PackBoard(puzzle);
+    node.transposed = PackTransposed(puzzle);
+    node.idx1 = (int16_t)idx1;
+    node.idx2 = (int16_t)idx2;
+    node.inv1 = (uint8_t)inv1;
+    node.inv2 = (uint8_t)inv2;
+    node.blank = PUZZLE_SIZE - 1;
+    parentBlank = -1;
+
+    for (int move = 0; move < SELF_CHECK_MOVES; move++)
+    {
+      while (!MakeAStarChild(&node, parentBlank, PredictRandom(&random) % 4, &child))
+      {
+      }
+
+      for (int i = 0; i < PUZZLE_SIZE; i++)
+      {
+        puzzle[i] = PackedTile(child.board, i);
+      }
+      value = HeuristicLookupIndices(puzzle, &idx1, &idx2, &inv1, &inv2);
+
+      if (child.transposed != PackTransposed(puzzle) || puzzle[child.blank] != 0 ||
+          child.idx1 != idx1 || child.idx2 != idx2 || child.inv1 != inv1 || child.inv2 != inv2 ||
+          HeuristicValue(child.idx1, child.idx2, child.inv1, child.inv2) != value)
+      {
+        if (errors++ < 10)
+        {
+          printf("ERROR: Walk %d move %d: incremental %d %d %d %d, recomputed %d %d %d %d\n",
+            walk, move + 1, child.idx1, child.idx2, child.inv1, child.inv2, idx1, idx2, inv1, inv2);
+        }
+      }
+
+      parentBlank = node.blank;
+      node = child;
+    }
+  }
+
+  printf("Incremental updates: %d walks of %d moves, %d mismatches\n", walks, SELF_CHECK_MOVES, errors);
+
+  return errors;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Validation stage 1: Verify array has only integers 0 through 15, and only
+//    one of each.
+
+int TilesAreUnique(int* puzzle)
+{
+  int unique = 1;
+  int i;
+
+  int seenTile[PUZZLE_SIZE];
+
+  memset(seenTile, 0, sizeof(int)*PUZZLE_SIZE);
+
+  for(i = 0; i < PUZZLE_SIZE; i++)
+  {
+    if(puzzle[i] < 0 || puzzle[i] > 15) 
+    {
+      printf("Out of range tile %d detected.\n\n", puzzle[i]);
+      unique = 0;
+    }
+    else if(seenTile[puzzle[i]] != 0)
+    {
+      printf("Duplicate tile %d detected.\n\n", puzzle[i]);
+      unique = 0;
+    }
+    else
+    {
+      seenTile[puzzle[i]] = 1;
+    }
+  }
+
+  return unique;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Validation stage 2: Verify puzzle is solvable via inversion count rules.
+
+int PuzzleIsSolvable(int* puzzle)
+{
+  int inversionCountIsEven = ((InversionCount(puzzle,FALSE) % 2) == 0);
+  int solvable = 0;
+
+  if (PUZZLE_COLUMN % 2 == 0)
+  {
+    int indexBlank = GetBlankPosition(puzzle);
+    int blankEvenRowFromDesired = (((PUZZLE_ROW - (indexBlank/PUZZLE_COLUMN)) % 2) == 1);
+
+    if (blankEvenRowFromDesired)
+    {
+      solvable = inversionCountIsEven;
+    }
+    else
+    {
+      solvable = !inversionCountIsEven;
+    }
+  }
+  else
+  {
+    solvable = inversionCountIsEven;
+  }
+
+  if (!solvable)
+  {
+    printf("Unsolvable puzzle configuration detected.\n\n");
+  }
+
+  return solvable;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Calls all the puzzle state validations in turn
+//
+
+int Valid(int* puzzle)
+{
+  return TilesAreUnique(puzzle) &&
+         PuzzleIsSolvable(puzzle);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Read in puzzle state from user input: the first puzzle on standard
+//  input, in any of the formats puzInput.h accepts, on one line or spread
+//  over several. Returns FALSE if there is no valid puzzle to solve,
+//  instead of asking again.
+//
+
+int ReadPuzzleFromInput(int* puzzle)
+{
+  PuzzleInput input;
+  ParseStatus status;
+
+  printf("Enter the starting configuration for the puzzle:\n");
+  fflush(stdout);
+
+  if (OpenPuzzleInput(&input, NULL) != 0)
+  {
+    printf("ERROR: %s\n", ParseStatusText(PARSE_READ_ERROR));
+    return FALSE;
+  }
+
+  status = NextPuzzleAcrossLines(&input, puzzle);
+  ClosePuzzleInput(&input);
+
+  if (status != PARSE_OK)
+  {
+    printf("ERROR: Line %d: %s\n", input.line, ParseStatusText(status));
+    return FALSE;
+  }
+
+  printf("\nThe input received were as follows:\n\n");
+
+  PrintPuzzle(puzzle);
+
+  return Valid(puzzle);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Open a binary result file and write its header. Returns NULL on failure.
+//
+
+FILE *OpenResultFile(const char *path)
+{
+  FILE *resultFile = fopen(path, "wb");
+  ResultFileHeader header;
+
+  if (resultFile == NULL)
+  {
+    perror(path);
+    return NULL;
+  }
+
+  InitializeResultHeader(&header);
+  if (fwrite(&header, sizeof(header), 1, resultFile) != 1)
+  {
+    perror(path);
+    fclose(resultFile);
+    return NULL;
+  }
+
+  return resultFile;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Print a solution the way ExamineNode does as the search unwinds: the
+//  tiles moved, last move first.
+//
+
+void PrintSolutionMoves(int puzzle[PUZZLE_SIZE], char solutionMoves[MAX_SOLUTION_LENGTH], int length)
+{
+  int tiles[MAX_SOLUTION_LENGTH];
+  int work[PUZZLE_SIZE];
+  int blankIndex = GetBlankPosition(puzzle);
+  int childBlankIndex;
+  int offset[4] = { -PUZZLE_COLUMN, PUZZLE_COLUMN, -1, 1 };
+
+  memcpy(work, puzzle, sizeof(work));
+
+  for (int i = 0; i < length; i++)
+  {
+    childBlankIndex = blankIndex + offset[(int)solutionMoves[i]];
+    tiles[i] = work[childBlankIndex];
+    work[blankIndex] = work[childBlankIndex];
+    work[childBlankIndex] = 0;
+    blankIndex = childBlankIndex;
+  }
+
+  printf("\nTile movements to arrive in this state:\n");
+  for (int i = length-1; i >= 0; i--)
+  {
+    printf(" %d", tiles[i]);
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Append a record of a result to resultFile, if there is one. Returns
+//  FALSE if it couldn't be written.
+//
+
+unsigned long long ElapsedMicroseconds(const struct timespec *start, const struct timespec *end)
+{
+  return (end->tv_sec - start->tv_sec) * 1000000ULL +
+         (end->tv_nsec - start->tv_nsec) / 1000;
+}
+
+int WriteResultRecord(FILE *resultFile, int puzzle[PUZZLE_SIZE], int id,
+  char solutionMoves[MAX_SOLUTION_LENGTH], int length,
+  unsigned long long nodes, unsigned long long microseconds)
+{
+  ResultRecord record;
+
+  if (resultFile == NULL)
+  {
+    return TRUE;
+  }
+
+  memset(&record, 0, sizeof(record));
+  record.boardIndex = BoardIndexOf(puzzle, PUZZLE_COLUMN, PUZZLE_ROW, NULL);
+  record.nodes = nodes;
+  record.microseconds = microseconds;
+  record.id = (uint32_t)id;
+  record.length = (uint16_t)length;
+  PackResultMoves(&record, solutionMoves, length);
+
+  return fwrite(&record, sizeof(record), 1, resultFile) == 1;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Solve the puzzle, from the cache if it has the board or its transpose,
+//  otherwise by IDA*. The search is timed, and a record of the result is
+//  appended to resultFile if there is one. Returns FALSE if the record
+//  couldn't be written, or SEARCH_STOPPED if the search was stopped for a
+//  checkpoint.
+//
+
+int SolveAndRecord(int puzzle[PUZZLE_SIZE], int id, FILE *resultFile, SolutionCache *cache,
+  const SearchOptions *options)
+{
+  char solutionMoves[MAX_SOLUTION_LENGTH];
+  unsigned long long nodes = 0;
+  struct timespec start, end;
+  int length = -1;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  if (cache != NULL && (length = LookupSolution(cache, puzzle, solutionMoves)) >= 0)
+  {
+    PrintSolutionMoves(puzzle, solutionMoves, length);
+    printf("\n\nSolution of length %d found in cache\n", length);
+  }
+  else
+  {
+    length = SolvePuzzle(puzzle, solutionMoves, &nodes, options);
+    if (length == SEARCH_STOPPED)
+    {
+      if (checkpointHeld)
+      {
+        printf("Search stopped, resume from checkpoint %s\n", options->checkpointPath);
+      }
+      else
+      {
+        printf("ERROR: Search stopped, no checkpoint could be saved to %s\n", options->checkpointPath);
+      }
+      return SEARCH_STOPPED;
+    }
+    if (cache != NULL)
+    {
+      StoreSolution(cache, puzzle, solutionMoves, length);
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  return WriteResultRecord(resultFile, puzzle, id, solutionMoves, length, nodes,
+           ElapsedMicroseconds(&start, &end));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Solve every puzzle in the given file, one per line. A line that isn't a
+//  valid puzzle is reported with its line number and skipped. A search
+//  stopped for a checkpoint ends the batch; run it again to resume. Returns
+//  TRUE if any line was rejected, a result couldn't be written, or the
+//  batch was stopped.
+//
+
+int SolveBatch(const char *path, FILE *resultFile, SolutionCache *cache,
+  const SearchOptions *options)
+{
+  PuzzleInput input;
+  ParseStatus status;
+  int puzzle[PUZZLE_SIZE];
+  int idx1, idx2, inv1, inv2;
+  int solved = 0;
+  int errors = 0;
+  int stoppedLine = 0;
+  int result;
+  uint64_t traceBegin;
+
+  if (OpenPuzzleInput(&input, path) != 0)
+  {
+    perror(path);
+    return 1;
+  }
+
+  while ((status = NextPuzzle(&input, puzzle)) != PARSE_END)
+  {
+    if (status != PARSE_OK)
+    {
+      printf("ERROR: Line %d: %s\n", input.line, ParseStatusText(status));
+      errors++;
+      continue;
+    }
+
+    printf("\nPuzzle on line %d:\n\n", input.line);
+    PrintPuzzle(puzzle);
+    printf("Initial heuristic value of %d\n\n", HeuristicLookupIndices(puzzle, &idx1, &idx2, &inv1, &inv2));
+
+    traceBegin = TraceBegin();
+    result = SolveAndRecord(puzzle, input.line, resultFile, cache, options);
+    TraceEnd(traceBegin, "search", "solve", "line", input.line);
+    if (result == SEARCH_STOPPED)
+    {
+      stoppedLine = input.line;
+      break;
+    }
+    else if (!result)
+    {
+      printf("ERROR: Unable to write result for line %d\n", input.line);
+      errors++;
+      break;
+    }
+    solved++;
+  }
+
+  ClosePuzzleInput(&input);
+
+  if (stoppedLine > 0)
+  {
+    printf("\nBatch stopped at line %d: %d puzzles solved, %d lines rejected\n", stoppedLine, solved, errors);
+  }
+  else
+  {
+    printf("\nBatch complete: %d puzzles solved, %d lines rejected\n", solved, errors);
+  }
+
+  return errors > 0 || stoppedLine > 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Distance oracle: the optimal solution length of every puzzle in the
+//  input, with none of the per-puzzle output. The puzzles are read up
+//  front, checked against the cache, and the rest handed out one at a time
+//  to a pool of threads. The lookup tables and endgame table are only read
+//  during a search, so all the threads share them, and each search has its
+//  own SearchContext. Results are printed, cached and recorded in input
+//  order once all the searches are done. If a search ever comes back
+//  stopped, no more are handed out, and the puzzles left unsolved are
+//  printed as such and never cached or recorded.
+//
+
+typedef struct
+{
+  int puzzle[PUZZLE_SIZE];
+  int line;
+  int length;                         // -1 until solved, or if stopped.
+  int cached;
+  unsigned long long nodes;
+  unsigned long long microseconds;
+  char moves[MAX_SOLUTION_LENGTH];
+} DistanceQuery;
+
+typedef struct
+{
+  DistanceQuery *queries;
+  int count;
+  atomic_int next;                    // Next query to hand out.
+  atomic_int stopped;                 // A search stopped; hand out no more.
+  atomic_int nextSlot;                // Next trace slot for a started thread.
+  const SearchOptions *options;
+  int laneCount;                      // Searches interleaved on each thread.
+} DistancePool;
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Interleaved search: with -interleave n, each thread runs n searches at
+//  once, taking turns a node at a time. A search (a lane) keeps its path as
+//  an explicit stack instead of recursing, so it can be left between any
+//  two nodes. On entering a node, the lane prefetches the WDLNK rows its
+//  children will be made from, then hands over to the next lane. By the
+//  time its turn comes round again the rows should be in cache, and the
+//  other lanes' cache misses overlap with its own meanwhile.
+//
+//  Children are made in the same order as ExamineBody makes them and
+//  counted the same way, so the lengths and node counts match the kernels'.
+//  A lane works out a child's value before entering it anyway, so partial
+//  expansion only means not counting the children it cuts off. There is no
+//  endgame table, A* or checkpointing in this mode.
+
+typedef struct
+{
+  u64 board;
+  u64 transposed;
+  int blank;
+  int prevBlank;
+  int idx1, idx2, inv1, inv2;
+  int direction;                      // Next direction to try.
+} LaneFrame;
+
+typedef struct
+{
+  DistanceQuery *query;               // NULL once there's nothing left to do.
+  int depth;                          // Of the top frame, -1 between iterations.
+  int limit;
+  struct timespec start;
+  LaneFrame stack[MAX_SOLUTION_LENGTH];
+} SearchLane;
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Enter the lane's root, as the first node of an iteration. Returns TRUE
+//  if the root is the goal.
+
+static int EnterLaneRoot(SearchLane *lane)
+{
+  LaneFrame *root = &lane->stack[0];
+
+  lane->query->nodes++;
+  lane->depth = 0;
+  root->direction = MOVE_UP;
+  return HeuristicValue(root->idx1, root->idx2, root->inv1, root->inv2) == 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Give the lane the next query that isn't already solved. Returns FALSE if
+//  there are none left.
+
+static int StartLane(SearchLane *lane, DistancePool *pool)
+{
+  LaneFrame *root = &lane->stack[0];
+  int i;
+
+  while ((i = atomic_fetch_add(&pool->next, 1)) < pool->count)
+  {
+    lane->query = &pool->queries[i];
+    if (lane->query->length >= 0)
+    {
+      continue;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &lane->start);
+    root->board = PackBoard(lane->query->puzzle);
+    root->transposed = PackTransposed(lane->query->puzzle);
+    root->blank = GetBlankPosition(lane->query->puzzle);
+    root->prevBlank = -1;
+    lane->limit = HeuristicLookupIndices(lane->query->puzzle,
+                    &root->idx1, &root->idx2, &root->inv1, &root->inv2);
+    if (lane->limit == 0)
+    {
+      lane->query->length = 0;
+      continue;
+    }
+    EnterLaneRoot(lane);
+    return TRUE;
+  }
+
+  lane->query = NULL;
+  return FALSE;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Take the lane one node further: enter the next child of the node on top
+//  of its stack, backing up past nodes with no children left. Returns TRUE
+//  once the query is solved, with its moves and length filled in.
+
+static int StepLane(SearchLane *lane, int partial)
+{
+  LaneFrame *frame, *child;
+  int row, col, conv, tile, val;
+  int blank, idx1, idx2, inv1, inv2;
+  u64 transposed;
+
+  for (;;)
+  {
+    if (lane->depth < 0)
+    {
+      lane->limit += 2;
+      if (EnterLaneRoot(lane))
+      {
+        lane->query->length = 0;
+        return TRUE;
+      }
+    }
+
+    frame = &lane->stack[lane->depth];
+    row = frame->blank / PUZZLE_COLUMN;
+    col = frame->blank % PUZZLE_COLUMN;
+    conv = col * PUZZLE_COLUMN + row;
+
+    while (frame->direction <= MOVE_RIGHT)
+    {
+      idx1 = frame->idx1;
+      idx2 = frame->idx2;
+      inv1 = frame->inv1;
+      inv2 = frame->inv2;
+
+      switch (frame->direction++)
+      {
+        case MOVE_UP:
+          blank = frame->blank - PUZZLE_COLUMN;
+          if (row == 0 || blank == frame->prevBlank)
+          {
+            continue;
+          }
+          tile = PackedTile(frame->board, blank);
+          idx1 = WDLNK[idx1][1][(tile-1)>>2];
+          inv1 += INVDELTA[tile][(frame->board >> ((blank + 1) * 4)) & 0xFFF];
+          transposed = PackedMove(frame->transposed, conv - 1, conv);
+          break;
+
+        case MOVE_DOWN:
+          blank = frame->blank + PUZZLE_COLUMN;
+          if (row == PUZZLE_ROW-1 || blank == frame->prevBlank)
+          {
+            continue;
+          }
+          tile = PackedTile(frame->board, blank);
+          idx1 = WDLNK[idx1][0][(tile-1)>>2];
+          inv1 -= INVDELTA[tile][(frame->board >> ((frame->blank + 1) * 4)) & 0xFFF];
+          transposed = PackedMove(frame->transposed, conv + 1, conv);
+          break;
+
+        case MOVE_LEFT:
+          blank = frame->blank - 1;
+          if (col == 0 || blank == frame->prevBlank)
+          {
+            continue;
+          }
+          tile = PackedTile(frame->transposed, conv - PUZZLE_COLUMN);
+          idx2 = WDLNK[idx2][1][(tile-1)>>2];
+          inv2 += INVDELTA[tile][(frame->transposed >> ((conv - PUZZLE_COLUMN + 1) * 4)) & 0xFFF];
+          transposed = PackedMove(frame->transposed, conv - PUZZLE_COLUMN, conv);
+          break;
+
+        default:
+          blank = frame->blank + 1;
+          if (col == PUZZLE_COLUMN-1 || blank == frame->prevBlank)
+          {
+            continue;
+          }
+          tile = PackedTile(frame->transposed, conv + PUZZLE_COLUMN);
+          idx2 = WDLNK[idx2][0][(tile-1)>>2];
+          inv2 -= INVDELTA[tile][(frame->transposed >> ((conv + 1) * 4)) & 0xFFF];
+          transposed = PackedMove(frame->transposed, conv + PUZZLE_COLUMN, conv);
+          break;
+      }
+
+      val = HeuristicValue(idx1, idx2, inv1, inv2);
+      if (partial && lane->depth + 1 + val > lane->limit)
+      {
+        continue;
+      }
+
+      lane->query->nodes++;
+
+      if (val == 0)
+      {
+        // Solved: the moves are the directions taken from each frame.
+        for (int i = 0; i <= lane->depth; i++)
+        {
+          lane->query->moves[i] = (char)(lane->stack[i].direction - 1);
+        }
+        lane->query->length = lane->depth + 1;
+        return TRUE;
+      }
+
+      if (lane->depth + 1 + val <= lane->limit)
+      {
+        child = frame + 1;
+        child->board = PackedMove(frame->board, blank, frame->blank);
+        child->transposed = transposed;
+        child->blank = blank;
+        child->prevBlank = frame->blank;
+        child->idx1 = idx1;
+        child->idx2 = idx2;
+        child->inv1 = inv1;
+        child->inv2 = inv2;
+        child->direction = MOVE_UP;
+        lane->depth++;
+        __builtin_prefetch(WDLNK[idx1]);
+        __builtin_prefetch(WDLNK[idx2]);
+      }
+      return FALSE;
+    }
+
+    lane->depth--;
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Run the pool's queries in lanes, round robin, until there are none left.
+
+void InterleaveLanes(DistancePool *pool)
+{
+  SearchLane *lanes = malloc(sizeof(SearchLane) * pool->laneCount);
+  struct timespec end;
+  uint64_t traceBegin = TraceBegin();
+  int active = 0;
+
+  if (lanes == NULL)
+  {
+    printf("ERROR: Out of memory for search lanes\n");
+    return;
+  }
+
+  for (int i = 0; i < pool->laneCount; i++)
+  {
+    active += StartLane(&lanes[i], pool);
+  }
+
+  while (active > 0)
+  {
+    for (int i = 0; i < pool->laneCount; i++)
+    {
+      if (lanes[i].query != NULL && StepLane(&lanes[i], pool->options->partialExpansion))
+      {
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        lanes[i].query->microseconds = ElapsedMicroseconds(&lanes[i].start, &end);
+        active -= !StartLane(&lanes[i], pool);
+      }
+    }
+  }
+
+  free(lanes);
+  TraceEnd(traceBegin, "search", "interleaved", "lanes", pool->laneCount);
+}
+
+void *DistanceWorker(void *argument)
+{
+  DistancePool *pool = argument;
+  DistanceQuery *query;
+  struct timespec start, end;
+  uint64_t traceBegin;
+  int i;
+
+  if (pool->laneCount > 1)
+  {
+    InterleaveLanes(pool);
+    return NULL;
+  }
+
+  while ((i = atomic_fetch_add(&pool->next, 1)) < pool->count)
+  {
+    query = &pool->queries[i];
+    if (query->length >= 0)
+    {
+      continue;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    traceBegin = TraceBegin();
+    query->length = SolvePuzzle(query->puzzle, query->moves, &query->nodes, pool->options);
+    TraceEnd(traceBegin, "search", "solve", "line", query->line);
+    if (query->length < 0)
+    {
+      query->length = -1;
+      atomic_store(&pool->stopped, TRUE);
+      atomic_store(&pool->next, pool->count);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    query->microseconds = ElapsedMicroseconds(&start, &end);
+  }
+
+  return NULL;
+}
+
+// The main thread keeps trace slot 0, and the threads it starts take the
+// slots after it.
+void *DistanceThread(void *argument)
+{
+  DistancePool *pool = argument;
+
+  TraceBindThread(atomic_fetch_add(&pool->nextSlot, 1), "distance");
+
+  return DistanceWorker(pool);
+}
+
+int SolveDistances(const char *path, int threadCount, int laneCount, FILE *resultFile,
+  SolutionCache *cache, const SearchOptions *options)
+{
+  PuzzleInput input;
+  ParseStatus status;
+  DistancePool pool;
+  DistanceQuery *queries = NULL;
+  pthread_t threadIds[MAX_THREADS];
+  struct timespec start, end;
+  int capacity = 0, count = 0;
+  int errors = 0;
+  int started = 0;
+  uint64_t traceBegin = TraceBegin();
+
+  if (OpenPuzzleInput(&input, path) != 0)
+  {
+    perror(path);
+    return 1;
+  }
+
+  for (;;)
+  {
+    if (count == capacity)
+    {
+      DistanceQuery *grown;
+
+      capacity = capacity ? capacity * 2 : 1024;
+      grown = realloc(queries, sizeof(DistanceQuery) * capacity);
+      if (grown == NULL)
+      {
+        printf("ERROR: Out of memory for queries\n");
+        free(queries);
+        ClosePuzzleInput(&input);
+        return 1;
+      }
+      queries = grown;
+    }
+
+    if ((status = NextPuzzle(&input, queries[count].puzzle)) == PARSE_END)
+    {
+      break;
+    }
+    else if (status != PARSE_OK)
+    {
+      printf("ERROR: Line %d: %s\n", input.line, ParseStatusText(status));
+      errors++;
+      continue;
+    }
+
+    queries[count].line = input.line;
+    queries[count].nodes = 0;
+    queries[count].microseconds = 0;
+    queries[count].cached = (cache != NULL &&
+      (queries[count].length = LookupSolution(cache, queries[count].puzzle, queries[count].moves)) >= 0);
+    if (!queries[count].cached)
+    {
+      queries[count].length = -1;
+    }
+    count++;
+  }
+
+  ClosePuzzleInput(&input);
+  TraceEnd(traceBegin, "io", "read input", "puzzles", count);
+
+  pool.queries = queries;
+  pool.count = count;
+  pool.options = options;
+  pool.laneCount = laneCount;
+  atomic_init(&pool.next, 0);
+  atomic_init(&pool.stopped, FALSE);
+  atomic_init(&pool.nextSlot, 1);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (started = 0; started < threadCount - 1; started++)
+  {
+    if (pthread_create(&threadIds[started], NULL, DistanceThread, &pool) != 0)
+    {
+      break;
+    }
+  }
+  DistanceWorker(&pool);
+  for (int i = 0; i < started; i++)
+  {
+    pthread_join(threadIds[i], NULL);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  traceBegin = TraceBegin();
+  for (int i = 0; i < count; i++)
+  {
+    DistanceQuery *query = &queries[i];
+
+    if (query->length < 0)
+    {
+      printf("line %d not solved\n", query->line);
+      continue;
+    }
+
+    printf("line %d distance %d nodes %llu%s\n", query->line, query->length,
+      query->nodes, query->cached ? " cached" : "");
+
+    if (cache != NULL && !query->cached)
+    {
+      StoreSolution(cache, query->puzzle, query->moves, query->length);
+    }
+
+    if (!WriteResultRecord(resultFile, query->puzzle, query->line, query->moves,
+           query->length, query->nodes, query->microseconds))
+    {
+      printf("ERROR: Unable to write result for line %d\n", query->line);
+      errors++;
+      break;
+    }
+  }
+  TraceEnd(traceBegin, "io", "write results", "puzzles", count);
+
+  printf("\nDistances %s: %d puzzles in %.3f seconds with %d threads",
+    atomic_load(&pool.stopped) ? "stopped" : "complete",
+    count, ElapsedMicroseconds(&start, &end) * 1e-6, started + 1);
+  if (laneCount > 1)
+  {
+    printf(" of %d searches each", laneCount);
+  }
+  printf(", %d lines rejected\n", errors);
+
+  free(queries);
+
+  return errors > 0 || atomic_load(&pool.stopped);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Heuristic triage: the starting lower bound of every puzzle in the input,
+//  with no search. This is what HeuristicLookupIndices gives the first IDA*
+//  iteration, so it is never more than the true distance.
+//
+
+int PrintBounds(const char *path)
+{
+  PuzzleInput input;
+  ParseStatus status;
+  struct timespec start, end;
+  int puzzle[PUZZLE_SIZE];
+  int idx1, idx2, inv1, inv2;
+  int count = 0;
+  int errors = 0;
+  double seconds;
+
+  if (OpenPuzzleInput(&input, path) != 0)
+  {
+    perror(path);
+    return 1;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  while ((status = NextPuzzle(&input, puzzle)) != PARSE_END)
+  {
+    if (status != PARSE_OK)
+    {
+      printf("ERROR: Line %d: %s\n", input.line, ParseStatusText(status));
+      errors++;
+      continue;
+    }
+
+    printf("line %d bound %d\n", input.line, HeuristicLookupIndices(puzzle, &idx1, &idx2, &inv1, &inv2));
+    count++;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  ClosePuzzleInput(&input);
+
+  seconds = ElapsedMicroseconds(&start, &end) * 1e-6;
+  printf("\nBounds complete: %d puzzles in %.3f seconds (%.0f per second), %d lines rejected\n",
+    count, seconds, seconds > 0 ? count / seconds : 0.0, errors);
+
+  return errors;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Main
+//
+
+int main(int argc, char *argv[])
+{
+  int puzzle[PUZZLE_SIZE];
+  int idx1, idx2, inv1, inv2;
+  const char *batchPath = NULL;
+  const char *resultPath = NULL;
+  const char *cachePath = NULL;
+  int cacheEntries = DEFAULT_CACHE_ENTRIES;
+  FILE *resultFile = NULL;
+  SolutionCache cacheStore;
+  SolutionCache *cache = NULL;
+  int endgameDepth = 0;
+  int endgameMegabytes = DEFAULT_ENDGAME_MEGABYTES;
+  EndgameTable endgameStore;
+  SearchOptions options = { NULL, NULL, PrintProgress, NULL, FALSE, 0, NULL, FALSE, NULL };
+  int checkpointSeconds = DEFAULT_CHECKPOINT_SECONDS;
+  int boundOnly = FALSE;
+  int predict = FALSE;
+  Predictor *predictor = NULL;
+  int threadCount = 1;
+  int laneCount = 1;
+  const char *tracePath = NULL;
+  uint64_t traceBegin;
+  int useCounters = FALSE;
+  PerfCounters counters;
+  int selfCheckWalks = 0;
+  int failed;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-batch") == 0 && i+1 < argc)
+    {
+      batchPath = argv[++i];
+    }
+    else if (strcmp(argv[i], "-binary") == 0 && i+1 < argc)
+    {
+      resultPath = argv[++i];
+    }
+    else if (strcmp(argv[i], "-cache") == 0 && i+1 < argc)
+    {
+      cachePath = argv[++i];
+    }
+    else if (strcmp(argv[i], "-cachesize") == 0 && i+1 < argc)
+    {
+      cacheEntries = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-endgame") == 0 && i+1 < argc)
+    {
+      endgameDepth = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-endmem") == 0 && i+1 < argc)
+    {
+      endgameMegabytes = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-checkpoint") == 0 && i+1 < argc)
+    {
+      options.checkpointPath = argv[++i];
+    }
+    else if (strcmp(argv[i], "-checkpointsecs") == 0 && i+1 < argc)
+    {
+      checkpointSeconds = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-distance") == 0)
+    {
+      options.distanceOnly = TRUE;
+      options.progress = NULL;
+    }
+    else if (strcmp(argv[i], "-threads") == 0 && i+1 < argc)
+    {
+      threadCount = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-interleave") == 0 && i+1 < argc)
+    {
+      laneCount = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-bound") == 0)
+    {
+      boundOnly = TRUE;
+    }
+    else if (strcmp(argv[i], "-astar") == 0 && i+1 < argc)
+    {
+      options.astarMegabytes = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-predict") == 0)
+    {
+      predict = TRUE;
+    }
+    else if (strcmp(argv[i], "-epe") == 0)
+    {
+      options.partialExpansion = TRUE;
+    }
+    else if (strcmp(argv[i], "-trace") == 0 && i+1 < argc)
+    {
+      tracePath = argv[++i];
+    }
+    else if (strcmp(argv[i], "-counters") == 0)
+    {
+      useCounters = TRUE;
+    }
+    else if (strcmp(argv[i], "-selfcheck") == 0 && i+1 < argc)
+    {
+      selfCheckWalks = atoi(argv[++i]);
+    }
+    else
+    {
+      printf("Usage: %s [-batch file] [-binary resultFile] [-cache file [-cachesize entries]]\n", argv[0]);
+      printf("       [-endgame depth [-endmem megabytes]]\n");
+      printf("       [-checkpoint file [-checkpointsecs seconds]]\n");
+      printf("       [-distance [-threads n] [-interleave n]] [-bound] [-astar megabytes] [-predict] [-epe]\n");
+      printf("       [-trace file] [-counters] [-selfcheck walks]\n");
+      return 1;
+    }
+  }
+
+  if (threadCount < 1 || threadCount > MAX_THREADS)
+  {
+    printf("ERROR: Thread count must be 1 to %d\n", MAX_THREADS);
+    return 1;
+  }
+
+  if (options.checkpointPath != NULL && options.distanceOnly)
+  {
+    printf("ERROR: -checkpoint resumes one search, so it doesn't work with -distance\n");
+    return 1;
+  }
+
+  if (laneCount < 1 || laneCount > MAX_LANES)
+  {
+    printf("ERROR: Interleaved search count must be 1 to %d\n", MAX_LANES);
+    return 1;
+  }
+
+  if (threadCount > 1 && !options.distanceOnly)
+  {
+    printf("ERROR: -threads works with -distance only\n");
+    return 1;
+  }
+
+  if (laneCount > 1 && (!options.distanceOnly || endgameDepth > 0 || options.astarMegabytes > 0))
+  {
+    printf("ERROR: -interleave works with -distance only, without -endgame or -astar\n");
+    return 1;
+  }
+
+  if (useCounters && options.distanceOnly)
+  {
+    printf("ERROR: -counters prints per iteration, which -distance doesn't\n");
+    return 1;
+  }
+
+  if (tracePath != NULL && !TraceStart(threadCount))
+  {
+    printf("ERROR: Out of memory for trace\n");
+    return 1;
+  }
+
+  traceBegin = TraceBegin();
+  GenerateWalkingDistanceLookup();
+  TraceEnd(traceBegin, "tables", "walking distance", NULL, 0);
+
+  if (boundOnly)
+  {
+    return PrintBounds(batchPath) ? 1 : 0;
+  }
+
+  if (selfCheckWalks > 0)
+  {
+    return CheckIncrementalUpdates(selfCheckWalks) ? 1 : 0;
+  }
+
+  if (endgameDepth > 0)
+  {
+    traceBegin = TraceBegin();
+    if (BuildEndgameTable(&endgameStore, endgameDepth, (size_t)endgameMegabytes << 20) != 0)
+    {
+      printf("ERROR: Out of memory for endgame table\n");
+      return 1;
+    }
+    options.endgame = &endgameStore;
+    TraceEnd(traceBegin, "tables", "endgame", "depth", endgameStore.depth);
+    printf("Endgame table complete to depth %d with %llu states\n\n",
+      endgameStore.depth, (unsigned long long)endgameStore.count);
+  }
+
+  if (predict)
+  {
+    traceBegin = TraceBegin();
+    predictor = CreatePredictor(PredictedWalkingDistance, NULL, PREDICT_DEFAULT_SAMPLES);
+    TraceEnd(traceBegin, "tables", "prediction samples", NULL, 0);
+    if (predictor == NULL)
+    {
+      printf("ERROR: Out of memory for predictor\n");
+      return 1;
+    }
+    options.predictor = predictor;
+  }
+
+  if (useCounters && PerfOpen(&counters, FALSE))
+  {
+    options.counters = &counters;
+  }
+
+  if (options.checkpointPath != NULL)
+  {
+    InstallCheckpointSignals(checkpointSeconds > 0 ? checkpointSeconds : DEFAULT_CHECKPOINT_SECONDS);
+  }
+
+  if (resultPath != NULL && (resultFile = OpenResultFile(resultPath)) == NULL)
+  {
+    return 1;
+  }
+
+  if (cachePath != NULL)
+  {
+    traceBegin = TraceBegin();
+    if (OpenSolutionCache(&cacheStore, cachePath, cacheEntries) != 0)
+    {
+      printf("ERROR: Unable to open solution cache %s\n", cachePath);
+      return 1;
+    }
+    cache = &cacheStore;
+    TraceEnd(traceBegin, "io", "load cache", "entries", cache->count);
+  }
+
+  if (options.distanceOnly)
+  {
+    failed = SolveDistances(batchPath, threadCount, laneCount, resultFile, cache, &options);
+  }
+  else if (batchPath != NULL)
+  {
+    failed = SolveBatch(batchPath, resultFile, cache, &options);
+  }
+  else if (!ReadPuzzleFromInput(puzzle))
+  {
+    failed = TRUE;
+  }
+  else
+  {
+    printf("Initial heuristic value of %d\n\n", HeuristicLookupIndices(puzzle, &idx1, &idx2, &inv1, &inv2));
+
+    failed = (SolveAndRecord(puzzle, 1, resultFile, cache, &options) != TRUE);
+  }
+
+  if (cache != NULL)
+  {
+    printf("\nSolution cache: %llu hits, %llu misses, %llu evictions, %d entries\n",
+      cache->hits, cache->misses, cache->evictions, cache->count);
+
+    traceBegin = TraceBegin();
+    if (CloseSolutionCache(cache) != 0)
+    {
+      perror(cachePath);
+      failed = TRUE;
+    }
+    TraceEnd(traceBegin, "io", "save cache", NULL, 0);
+  }
+
+  if (resultFile != NULL && fclose(resultFile) != 0)
+  {
+    perror(resultPath);
+    failed = TRUE;
+  }
+
+  if (options.endgame != NULL)
+  {
+    FreeEndgameTable(&endgameStore);
+  }
+
+  if (predictor != NULL)
+  {
+    FreePredictor(predictor);
+  }
+
+  if (options.counters != NULL)
+  {
+    PerfClose(&counters);
+  }
+
+  if (tracePath != NULL && !TraceWrite(tracePath))
+  {
+    perror(tracePath);
+    failed = TRUE;
+  }
+
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,449 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Persistent cache of solved puzzles, shared by a board and its mirror.
+//
+//  The goal state is symmetric about the main diagonal: transpose the board
+//  and renumber the tiles the same way (the CONV table in puzWD.c) and the
+//  solved state maps to itself. So a board and its transpose have the same
+//  optimal solution length, and a solution of one is a solution of the other
+//  with up/left and down/right swapped. Entries are keyed by the smaller of
+//  the two board indices, so either orientation finds the same entry, and
+//  the moves are stored as they apply to that smaller one.
+//
+//  The cache holds a fixed number of entries in memory, in a hash table with
+//  a least recently used list through it. When it is full, storing a new
+//  solution evicts the entry that was used longest ago. The entries are read
+//  from a file when the cache is opened and written back when it is closed,
+//  least recently used first, so a reload keeps the same order.
+//
+//  Moves are blank directions as in puzResult.h.
+//
+#ifndef SOL_CACHE_H
+#define SOL_CACHE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "permRank.h"
+#include "puzResult.h"
+
+#define CACHE_WIDTH 4
+#define CACHE_SIZE (CACHE_WIDTH * CACHE_WIDTH)
+
+#define CACHE_MAGIC "PUZCACH"
+#define CACHE_VERSION 1
+
+#define CACHE_NONE (-1)
+
+typedef struct
+{
+  char magic[8];              // CACHE_MAGIC, NUL terminated.
+  uint32_t version;           // CACHE_VERSION
+  uint32_t entrySize;         // sizeof(CacheEntry), as a layout check.
+} CacheFileHeader;
+
+typedef struct
+{
+  uint64_t key;               // BoardIndexOf the canonical board.
+  uint16_t length;
+  uint16_t reserved[3];
+  uint8_t moves[RESULT_MOVE_BYTES];
+} CacheEntry;
+
+typedef struct
+{
+  CacheEntry entry;
+  int newer, older;           // LRU list, or the free list through older.
+  int chain;                  // Next slot in the same hash bucket.
+} CacheSlot;
+
+typedef struct
+{
+  CacheSlot *slots;
+  int *buckets;
+  unsigned int bucketMask;
+  int capacity;
+  int count;
+  int newest, oldest;
+  int freeSlot;
+  int changed;                // Something to write back on close.
+  const char *path;
+  unsigned long long hits, misses, evictions;
+} SolutionCache;
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  The board mirrored about the main diagonal, with tiles renumbered so the
+//  solved state stays solved.
+
+static inline int TransposeTile(int tile)
+{
+  int goal = tile - 1;
+
+  return tile ? (goal % CACHE_WIDTH) * CACHE_WIDTH + goal / CACHE_WIDTH + 1 : 0;
+}
+
+static inline void TransposeBoard(const int *puzzle, int *transposed)
+{
+  for (int i = 0; i < CACHE_SIZE; i++)
+  {
+    transposed[(i % CACHE_WIDTH) * CACHE_WIDTH + i / CACHE_WIDTH] = TransposeTile(puzzle[i]);
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Cache key for a board. *transposed is set TRUE if the key belongs to the
+//  transposed board, meaning moves need mapping on the way in and out.
+
+static inline u64rank CanonicalKey(const int *puzzle, int *transposed)
+{
+  int mirror[CACHE_SIZE];
+  u64rank index = BoardIndexOf(puzzle, CACHE_WIDTH, CACHE_WIDTH, NULL);
+  u64rank mirrorIndex;
+
+  TransposeBoard(puzzle, mirror);
+  mirrorIndex = BoardIndexOf(mirror, CACHE_WIDTH, CACHE_WIDTH, NULL);
+
+  *transposed = mirrorIndex < index;
+
+  return *transposed ? mirrorIndex : index;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Up and left trade places under the transpose, as do down and right.
+
+static inline int TransposeMove(int direction)
+{
+  return direction ^ 2;
+}
+
+static inline unsigned int CacheBucket(const SolutionCache *cache, u64rank key)
+{
+  return (unsigned int)((key * 0x9E3779B97F4A7C15ULL) >> 32) & cache->bucketMask;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  LRU list maintenance.
+
+static void UnlinkCacheSlot(SolutionCache *cache, int slot)
+{
+  CacheSlot *s = &cache->slots[slot];
+
+  if (s->newer != CACHE_NONE)
+  {
+    cache->slots[s->newer].older = s->older;
+  }
+  else
+  {
+    cache->newest = s->older;
+  }
+
+  if (s->older != CACHE_NONE)
+  {
+    cache->slots[s->older].newer = s->newer;
+  }
+  else
+  {
+    cache->oldest = s->newer;
+  }
+}
+
+static void LinkCacheSlotNewest(SolutionCache *cache, int slot)
+{
+  CacheSlot *s = &cache->slots[slot];
+
+  s->newer = CACHE_NONE;
+  s->older = cache->newest;
+
+  if (cache->newest != CACHE_NONE)
+  {
+    cache->slots[cache->newest].newer = slot;
+  }
+  else
+  {
+    cache->oldest = slot;
+  }
+
+  cache->newest = slot;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Slot holding the given key, or CACHE_NONE.
+
+static int FindCacheSlot(const SolutionCache *cache, u64rank key)
+{
+  int slot = cache->buckets[CacheBucket(cache, key)];
+
+  while (slot != CACHE_NONE && cache->slots[slot].entry.key != key)
+  {
+    slot = cache->slots[slot].chain;
+  }
+
+  return slot;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Drop the least recently used entry to make room.
+
+static void EvictOldest(SolutionCache *cache)
+{
+  int slot = cache->oldest;
+  int *link = &cache->buckets[CacheBucket(cache, cache->slots[slot].entry.key)];
+
+  while (*link != slot)
+  {
+    link = &cache->slots[*link].chain;
+  }
+  *link = cache->slots[slot].chain;
+
+  UnlinkCacheSlot(cache, slot);
+
+  cache->slots[slot].older = cache->freeSlot;
+  cache->freeSlot = slot;
+  cache->count--;
+  cache->evictions++;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Add or refresh an entry, already in canonical form.
+
+static void InsertCacheEntry(SolutionCache *cache, const CacheEntry *entry)
+{
+  int slot = FindCacheSlot(cache, entry->key);
+  unsigned int bucket;
+
+  if (slot != CACHE_NONE)
+  {
+    UnlinkCacheSlot(cache, slot);
+  }
+  else
+  {
+    if (cache->count == cache->capacity)
+    {
+      EvictOldest(cache);
+    }
+
+    slot = cache->freeSlot;
+    cache->freeSlot = cache->slots[slot].older;
+    cache->count++;
+
+    bucket = CacheBucket(cache, entry->key);
+    cache->slots[slot].chain = cache->buckets[bucket];
+    cache->buckets[bucket] = slot;
+  }
+
+  cache->slots[slot].entry = *entry;
+  LinkCacheSlotNewest(cache, slot);
+  cache->changed = 1;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Create a cache of the given number of entries, loading whatever the file
+//  at path holds. A missing file is an empty cache. Entries too long to be
+//  a solution, from a damaged file, are dropped. Returns 0 on success, -1
+//  if memory runs out or the file isn't a cache file.
+
+static int OpenSolutionCache(SolutionCache *cache, const char *path, int capacity)
+{
+  CacheFileHeader header;
+  CacheEntry entry;
+  unsigned int buckets = 1;
+  FILE *file;
+
+  memset(cache, 0, sizeof(SolutionCache));
+
+  while (buckets < (unsigned int)capacity * 2)
+  {
+    buckets <<= 1;
+  }
+
+  cache->slots = malloc(sizeof(CacheSlot) * capacity);
+  cache->buckets = malloc(sizeof(int) * buckets);
+  if (capacity <= 0 || cache->slots == NULL || cache->buckets == NULL)
+  {
+    free(cache->slots);
+    free(cache->buckets);
+    return -1;
+  }
+
+  cache->bucketMask = buckets - 1;
+  cache->capacity = capacity;
+  cache->newest = cache->oldest = CACHE_NONE;
+  cache->path = path;
+
+  for (unsigned int i = 0; i < buckets; i++)
+  {
+    cache->buckets[i] = CACHE_NONE;
+  }
+  for (int i = 0; i < capacity; i++)
+  {
+    cache->slots[i].older = (i+1 < capacity) ? i+1 : CACHE_NONE;
+  }
+
+  file = fopen(path, "rb");
+  if (file == NULL)
+  {
+    return 0;
+  }
+
+  if (fread(&header, sizeof(header), 1, file) != 1 ||
+      memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+      header.version != CACHE_VERSION ||
+      header.entrySize != sizeof(CacheEntry))
+  {
+    fclose(file);
+    free(cache->slots);
+    free(cache->buckets);
+    return -1;
+  }
+
+  while (fread(&entry, sizeof(entry), 1, file) == 1)
+  {
+    if (entry.length <= RESULT_MAX_MOVES)
+    {
+      InsertCacheEntry(cache, &entry);
+    }
+  }
+
+  fclose(file);
+  cache->changed = 0;
+  cache->evictions = 0;
+
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Write the cache back, oldest first, if anything changed, then free it.
+//  The file is replaced by rename so an interrupted write leaves the old
+//  one intact. Returns 0 on success, -1 if the file couldn't be written.
+
+static int CloseSolutionCache(SolutionCache *cache)
+{
+  CacheFileHeader header;
+  char tempPath[4096];
+  FILE *file;
+  int result = 0;
+
+  if (cache->changed)
+  {
+    snprintf(tempPath, sizeof(tempPath), "%s.tmp", cache->path);
+
+    memset(&header, 0, sizeof(header));
+    strcpy(header.magic, CACHE_MAGIC);
+    header.version = CACHE_VERSION;
+    header.entrySize = sizeof(CacheEntry);
+
+    file = fopen(tempPath, "wb");
+    result = (file == NULL) ? -1 : 0;
+
+    if (file != NULL && fwrite(&header, sizeof(header), 1, file) != 1)
+    {
+      result = -1;
+    }
+
+    for (int slot = cache->oldest; result == 0 && slot != CACHE_NONE; slot = cache->slots[slot].newer)
+    {
+      if (fwrite(&cache->slots[slot].entry, sizeof(CacheEntry), 1, file) != 1)
+      {
+        result = -1;
+      }
+    }
+
+    if (file != NULL && fclose(file) != 0)
+    {
+      result = -1;
+    }
+
+    if (result == 0 && rename(tempPath, cache->path) != 0)
+    {
+      result = -1;
+    }
+  }
+
+  free(cache->slots);
+  free(cache->buckets);
+  cache->slots = NULL;
+  cache->buckets = NULL;
+
+  return result;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Look up a board. On a hit, fills in its solution moves (for this board,
+//  not the canonical one) and returns the length. moves must hold
+//  RESULT_MAX_MOVES. Returns -1 on a miss.
+
+static int LookupSolution(SolutionCache *cache, const int *puzzle, char *moves)
+{
+  int transposed;
+  u64rank key = CanonicalKey(puzzle, &transposed);
+  int slot = FindCacheSlot(cache, key);
+  const CacheEntry *entry;
+
+  if (slot == CACHE_NONE)
+  {
+    cache->misses++;
+    return -1;
+  }
+
+  cache->hits++;
+  UnlinkCacheSlot(cache, slot);
+  LinkCacheSlotNewest(cache, slot);
+  cache->changed = 1;
+
+  entry = &cache->slots[slot].entry;
+  if (entry->length > RESULT_MAX_MOVES)
+  {
+    return -1;
+  }
+
+  for (int i = 0; i < entry->length; i++)
+  {
+    int direction = (entry->moves[i >> 2] >> ((i & 3) * 2)) & 3;
+
+    moves[i] = (char)(transposed ? TransposeMove(direction) : direction);
+  }
+
+  return entry->length;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Remember the solution to a board. Solutions too long to pack, and
+//  negative lengths (no solution), are skipped.
+
+static void StoreSolution(SolutionCache *cache, const int *puzzle, const char *moves, int length)
+{
+  CacheEntry entry;
+  int transposed;
+
+  if (length < 0 || length > RESULT_MAX_MOVES)
+  {
+    return;
+  }
+
+  memset(&entry, 0, sizeof(entry));
+  entry.key = CanonicalKey(puzzle, &transposed);
+  entry.length = (uint16_t)length;
+
+  for (int i = 0; i < length; i++)
+  {
+    int direction = transposed ? TransposeMove(moves[i]) : moves[i];
+
+    entry.moves[i >> 2] |= (uint8_t)(direction << ((i & 3) * 2));
+  }
+
+  InsertCacheEntry(cache, &entry);
+}
+
+#endif // SOL_CACHE_H
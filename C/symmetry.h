@@ -0,0 +1,118 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Symmetric heuristic lookups: the same heuristic, and the same tables,
+//  applied to boards that are provably as far from the goal as the board
+//  being searched (or nearly so), for a larger lower bound at no cost in
+//  memory.
+//
+//  * The reflection across the main diagonal. The goal has the blank in
+//    the bottom right corner, on the diagonal, so reflecting a board and
+//    renumbering each tile to the one whose home is the reflection of its
+//    home gives a board exactly as far from the goal. This is the axis flip
+//    puzWD makes with CONV and CONVP, as a whole board.
+//  * The dual (Zahavi, Felner, Holte and Schaeffer), which swaps the roles
+//    of tiles and places: where the board has tile t in cell c, the dual
+//    has the tile whose home is c in the home cell of t. When the blank is
+//    home, the moves that solve a board, run backwards, solve its dual, so
+//    the two are the same distance from the goal. Otherwise the dual isn't
+//    even a board that the same moves apply to, and looking it up as it is
+//    can overestimate. So the blank is first walked home, down then right,
+//    and the moves that takes are taken off the dual's value.
+//
+//  A bound can always be raised to the parity of the true distance, which
+//  for this puzzle is the parity of the blank's distance from home. A board
+//  with the blank home is an even distance from the goal, so the dual's
+//  value is rounded up to even before the walk is taken off.
+//
+//  Everything here is static, on boards as int arrays with 0 for the blank.
+//
+#ifndef SYMMETRY_H
+#define SYMMETRY_H
+
+#define SYMMETRY_COLUMN 4
+#define SYMMETRY_SIZE (SYMMETRY_COLUMN * SYMMETRY_COLUMN)
+
+// The blank's home cell, on the diagonal.
+#define SYMMETRY_HOME (SYMMETRY_SIZE - 1)
+
+// Home cell of a tile, and the tile whose home is a cell.
+static inline int SymmetryHome(int tile)
+{
+  return tile ? tile - 1 : SYMMETRY_HOME;
+}
+
+static inline int SymmetryTileOf(int cell)
+{
+  return cell == SYMMETRY_HOME ? 0 : cell + 1;
+}
+
+// A cell's reflection across the main diagonal.
+static inline int SymmetryTranspose(int cell)
+{
+  return (cell % SYMMETRY_COLUMN) * SYMMETRY_COLUMN + cell / SYMMETRY_COLUMN;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  The board reflected across the main diagonal, with the tiles renumbered.
+
+static inline void ReflectBoard(const int puzzle[SYMMETRY_SIZE], int reflected[SYMMETRY_SIZE])
+{
+  for (int cell = 0; cell < SYMMETRY_SIZE; cell++)
+  {
+    reflected[SymmetryTranspose(cell)] = SymmetryTileOf(SymmetryTranspose(SymmetryHome(puzzle[cell])));
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  The dual of the board once the blank is walked home, down then right.
+//  Returns the number of moves in the walk.
+
+static inline int DualBoard(const int puzzle[SYMMETRY_SIZE], int dual[SYMMETRY_SIZE])
+{
+  int board[SYMMETRY_SIZE];
+  int blank = 0, moves = 0;
+
+  for (int cell = 0; cell < SYMMETRY_SIZE; cell++)
+  {
+    board[cell] = puzzle[cell];
+    if (puzzle[cell] == 0)
+    {
+      blank = cell;
+    }
+  }
+
+  for (; blank + SYMMETRY_COLUMN < SYMMETRY_SIZE; blank += SYMMETRY_COLUMN, moves++)
+  {
+    board[blank] = board[blank + SYMMETRY_COLUMN];
+    board[blank + SYMMETRY_COLUMN] = 0;
+  }
+
+  for (; blank < SYMMETRY_HOME; blank++, moves++)
+  {
+    board[blank] = board[blank + 1];
+    board[blank + 1] = 0;
+  }
+
+  for (int cell = 0; cell < SYMMETRY_SIZE; cell++)
+  {
+    dual[SymmetryHome(board[cell])] = SymmetryTileOf(cell);
+  }
+
+  return moves;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  The bound the board gets from its dual's value, given the moves
+//  DualBoard walked the blank.
+
+static inline int DualBound(int dualValue, int moves)
+{
+  int bound = dualValue + (dualValue & 1) - moves;
+
+  return bound > 0 ? bound : 0;
+}
+
+#endif // SYMMETRY_H
@@ -0,0 +1,226 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Timeline tracing, written out in the Chrome trace format (Trace Event
+//  Format JSON), which ui.perfetto.dev and chrome://tracing open directly.
+//
+//  Each span is a name, a category, one named integer argument, and its
+//  start and duration. Spans go into a ring buffer per thread slot. The
+//  programs number their threads themselves (the main thread is slot 0),
+//  and a slot is only ever written by one thread at a time, so no locks or
+//  atomics are needed: a new thread for the same slot only starts after the
+//  old one is joined. When a slot's ring fills, its oldest spans are
+//  overwritten. Everything is written out by TraceWrite, once the threads
+//  are done.
+//
+//  Tracing is off until TraceStart. Until then TraceBegin returns at once,
+//  so the calls can stay in the code. The names, categories and argument
+//  names must be string constants, since only the pointers are kept.
+//
+//  Usage:
+//    uint64_t begin = TraceBegin();
+//    ...
+//    TraceEnd(begin, "search", "iteration", "limit", limit);
+//
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Spans kept per thread slot, a power of two. 40 bytes each.
+#define TRACE_RING_EVENTS (1 << 16)
+
+typedef struct
+{
+  uint64_t start;               // Nanoseconds since TraceStart.
+  uint64_t duration;
+  const char *category;
+  const char *name;
+  const char *argument;         // NULL for none.
+  long long value;
+} TraceEvent;
+
+typedef struct
+{
+  TraceEvent *events;
+  uint64_t written;             // Spans ever written; the ring keeps the last.
+  const char *name;             // Shown with the slot number, NULL if unused.
+} TraceSlot;
+
+typedef struct
+{
+  int enabled;
+  struct timespec origin;
+  TraceSlot *slots;
+  int slotCount;
+} TraceLog;
+
+static TraceLog traceLog;
+static __thread TraceSlot *traceSlot;
+
+static inline uint64_t TraceClock(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t)(now.tv_sec - traceLog.origin.tv_sec) * 1000000000ULL +
+         (uint64_t)now.tv_nsec - (uint64_t)traceLog.origin.tv_nsec;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  The calling thread writes to the given slot from now on. Does nothing
+//  if tracing is off or the slot is out of range.
+
+static inline void TraceBindThread(int slot, const char *name)
+{
+  if (traceLog.enabled && slot >= 0 && slot < traceLog.slotCount)
+  {
+    traceSlot = &traceLog.slots[slot];
+    traceSlot->name = name;
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Start tracing with the given number of thread slots, each with its
+//  ring (2.5 MB), and bind the calling thread to slot 0. Returns FALSE if
+//  out of memory.
+
+static int TraceStart(int slotCount)
+{
+  traceLog.slots = calloc(slotCount, sizeof(TraceSlot));
+  if (traceLog.slots == NULL)
+  {
+    return 0;
+  }
+
+  for (int i = 0; i < slotCount; i++)
+  {
+    traceLog.slots[i].events = malloc(sizeof(TraceEvent) * TRACE_RING_EVENTS);
+    if (traceLog.slots[i].events == NULL)
+    {
+      for (int j = 0; j < i; j++)
+      {
+        free(traceLog.slots[j].events);
+      }
+      free(traceLog.slots);
+      return 0;
+    }
+  }
+
+  traceLog.slotCount = slotCount;
+  clock_gettime(CLOCK_MONOTONIC, &traceLog.origin);
+  traceLog.enabled = 1;
+  TraceBindThread(0, "main");
+
+  return 1;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Start and end of a span. TraceBegin returns 0 when tracing is off, and
+//  TraceEnd then records nothing.
+
+static inline uint64_t TraceBegin(void)
+{
+  return traceLog.enabled ? TraceClock() : 0;
+}
+
+static inline void TraceEnd(uint64_t begin, const char *category, const char *name,
+  const char *argument, long long value)
+{
+  TraceSlot *slot = traceSlot;
+  TraceEvent *event;
+
+  if (!traceLog.enabled || slot == NULL)
+  {
+    return;
+  }
+
+  event = &slot->events[slot->written & (TRACE_RING_EVENTS - 1)];
+  event->start = begin;
+  event->duration = TraceClock() - begin;
+  event->category = category;
+  event->name = name;
+  event->argument = argument;
+  event->value = value;
+  slot->written++;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Write everything out as JSON and stop tracing. Prints a line saying how
+//  many spans went to the file and how many were overwritten. Returns FALSE
+//  if the file can't be written.
+
+static int TraceWrite(const char *path)
+{
+  FILE *file = fopen(path, "w");
+  unsigned long long kept = 0, dropped = 0;
+  const char *separator = "";
+  int ok;
+
+  traceLog.enabled = 0;
+
+  if (file != NULL)
+  {
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    for (int i = 0; i < traceLog.slotCount; i++)
+    {
+      TraceSlot *slot = &traceLog.slots[i];
+      uint64_t first = slot->written > TRACE_RING_EVENTS ? slot->written - TRACE_RING_EVENTS : 0;
+
+      if (slot->name == NULL)
+      {
+        continue;
+      }
+
+      fprintf(file, "%s{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":\"thread_name\","
+        "\"args\":{\"name\":\"%s %d\"}}", separator, i, slot->name, i);
+      separator = ",\n";
+
+      for (uint64_t n = first; n < slot->written; n++)
+      {
+        const TraceEvent *event = &slot->events[n & (TRACE_RING_EVENTS - 1)];
+
+        fprintf(file, ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"cat\":\"%s\",\"name\":\"%s\","
+          "\"ts\":%.3f,\"dur\":%.3f", i, event->category, event->name,
+          event->start / 1000.0, event->duration / 1000.0);
+        if (event->argument != NULL)
+        {
+          fprintf(file, ",\"args\":{\"%s\":%lld}", event->argument, event->value);
+        }
+        fprintf(file, "}");
+      }
+
+      kept += slot->written - first;
+      dropped += first;
+    }
+
+    fprintf(file, "\n]}\n");
+  }
+
+  ok = file != NULL && fclose(file) == 0;
+
+  if (ok)
+  {
+    printf("Trace: %llu spans written to %s, %llu overwritten\n", kept, path, dropped);
+  }
+
+  for (int i = 0; i < traceLog.slotCount; i++)
+  {
+    free(traceLog.slots[i].events);
+  }
+  free(traceLog.slots);
+  traceLog.slots = NULL;
+  traceLog.slotCount = 0;
+
+  return ok;
+}
+
+#endif // TRACE_H
@@ -0,0 +1,569 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Adaptation of the Walking Distance algorithm by takaken (puz15wd.c)
+//  
+//  Goals of adaptation in priority order:
+//  * Bring up to current C standard.
+//  * More comments, and in English.
+//  
+//  Originally I had the ambition to add flexibility for configuration other 
+//  than 4x4 15-puzzle but that's going to be difficult. Problems are:
+//  1. Current implementation depends on the puzzle being a square (with same
+//     dimension on both sides) because it reuses the same lookup table for
+//     both horizontal and vertical axis. The only way to do a non-square
+//     puzzle (like 4x5 19-puzzle) would require two separate tables.
+//  2. The lookup table size shoots up tremendously with size. When size is 4
+//     the table can still fit in L3 cache. Table of 5 is going to dump into
+//     main memory... would the memory latency kill us?
+//
+//  Shared by puzWD, puzMT, puzDist and puzRoute, so the tables, their
+//  lookups and the move step can't drift apart between them. Each program
+//  is a single translation unit, so everything here is static.
+//
+//  Usage:
+//    GenerateWalkingDistanceLookup();
+//    h = HeuristicLookupIndices(puzzle, &idx1, &idx2, &inv1, &inv2);
+//    child = WalkingDistanceMove(puzzle, blank, direction,
+//                                &idx1, &idx2, &inv1, &inv2);
+//
+#ifndef WALK_DIST_H
+#define WALK_DIST_H
+
+#include <string.h>
+
+#define BOARD_WIDTH 4
+
+#define WDTBL_SIZE 24964 // Don't understand where this value came from
+#define IDTBL_SIZE 106
+
+#define WD_SIZE (BOARD_WIDTH * BOARD_WIDTH)
+
+typedef unsigned long long u64; // MSVC 'unsigned __int64' now C99 'unsigned long long'
+
+// Each element in TABLE is a count of the number of tiles mapping their 
+// current row  against their desired row.
+//
+// Rephrase: TABLE[i][j] holds the count of tiles that are currently in row
+//  i and need to be in row j for the puzzle's solved state. When i equals
+//  j, that count is the number of tiles sitting in their correct final row.
+//
+// Example: TABLE representing the solved state, with all tiles in their
+//  correct position (and therefore correct row) would look like this:
+//             
+//      j=0  1  2  3
+//
+// i = 0  4  0  0  0
+// i = 1  0  4  0  0
+// i = 2  0  0  4  0
+// i = 3  0  0  0  3
+static int   TABLE[BOARD_WIDTH][BOARD_WIDTH];
+
+// WDTOP and WDEND are used while generating the lookup table via breadth
+// first search. WDTOP represents the end of the closed list, and WDEND 
+// represents the end of the open list. Everything in between are nodes still
+// still to be examined. Table generation ends when WDTOP catches up to WDEND
+// (The values of which, when things work correctly, would be WDTBL_SIZE.)
+static int   WDTOP, WDEND;
+
+// The value of a WDPTN element is a representation of a particular TABLE
+// configuration. So given a TABLE, we can pack it into a pattern and find
+// its place in WDPTN through WDHASH below. The index value is used to 
+// look at WDTBL to retrieve the Walking Distance corresponding to the TABLE.
+static u64   WDPTN[WDTBL_SIZE];
+static char  WDTBL[WDTBL_SIZE];
+
+// WDLNK table stores transitions from one TABLE pattern to another. This
+// allows the Walking Distance values to be updated without going through the
+// steps of packing the TABLE and searching in WDPTN.
+static short WDLNK[WDTBL_SIZE][2][BOARD_WIDTH];
+
+// Inversion Distance is another heuristic employed here. It tracks the number
+// of tiles that are out-of-place relative to tiles with a lower number.
+// In the solved state, all tile numbers are increasing and the inversion
+// distance is zero. IDTBL maps an inversion count to the minimum number of 
+// moves required to put tiles back in order.
+static char  IDTBL[IDTBL_SIZE];
+
+// Walking Distance performs its calculations along one axis, then repeats
+// the calculation along the other axis. The CONVersion table here is used
+// to map tile positions across this axis flip, so that the same lookup
+// tables can be used for both horizontal and vertical calculation.
+static int CONV[WD_SIZE] = {
+  0,
+  1, 5, 9,13,
+  2, 6,10,14,
+  3, 7,11,15,
+  4, 8,12
+};
+
+// And this maps a position to its place across the same axis flip.
+static int CONVP[WD_SIZE] = {
+  0, 4, 8,12,
+  1, 5, 9,13,
+  2, 6,10,14,
+  3, 7,11,15
+};
+
+// A vertical move slides a tile past the three tiles between its old and
+// new position in row-major order, changing the inversion count by one for
+// each of them. INVDELTA[tile][skipped] is the change when the tile moves
+// forward past them (the blank moving up): +1 for each skipped tile with a
+// higher number, -1 for each lower. The three skipped tiles are packed 4
+// bits each, as they sit in a packed board. Moving the other way is the
+// negative. Horizontal moves are the same thing in the transposed board.
+// Only puzWD keeps its boards packed, but the table is built with the rest.
+static signed char INVDELTA[WD_SIZE][1 << 12];
+
+// Hash index over WDPTN, so finding a pattern's index is a probe or two
+// instead of a linear search. Used while building the tables, for the
+// starting board of each search, and by puzWD's bound-only mode, which
+// does nothing else. Open addressing, with -1 for an empty slot.
+#define WDHASH_SIZE (1 << 16)
+static short WDHASH[WDHASH_SIZE];
+
+/////////////////////////////////////////////////////////////////////////////
+//
+// Pack the TABLE array (each element represented by 3 bits) into a 48-bit 
+// representation.
+
+static u64 PackTable()
+{
+  u64 packedValue = 0;
+
+  for (int i=0; i<BOARD_WIDTH; i++)
+  {
+    for (int j=0; j<BOARD_WIDTH; j++)
+    {
+      packedValue = (packedValue << 3) | TABLE[i][j];
+    }
+  }
+
+  return packedValue;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+// Pack the given puzzle array (each element is the tile number at that space)
+// into the 48-bit representation of their walking distance displacement.
+// Can calculate either vertical or horizontal depending on flipAxis parameter.
+
+static u64 PackPuzzle(int* puzzle, int flipAxis)
+{
+  int row, tileNum;
+
+  u64 packedPuzzle = 0;
+
+  for (int i=0; i<WD_SIZE; i++)
+  {
+    tileNum = flipAxis? CONV[puzzle[i]] : puzzle[i];
+
+    if (tileNum == 0)
+    {
+      // Skip blank tile
+      continue;
+    }
+
+    // The row this tile sits in, across the flip if there is one.
+    row = flipAxis? i % BOARD_WIDTH : i / BOARD_WIDTH;
+
+    // Take the tile number, subtract one, then drop the least significant
+    // 2 bits (a.k.a. divide by four) gives us the desired row number for
+    // that tile. Count it in that row's 3-bit field of the pattern, which
+    // runs from row 0, desired row 0 in the top bits to row 3, desired
+    // row 3 in the bottom ones. No count goes past 4, so adding in place
+    // never carries into the next field.
+    packedPuzzle += 1ULL << ((WD_SIZE-1 - (row*BOARD_WIDTH + ((tileNum-1)>>2))) * 3);
+  }
+
+  return packedPuzzle;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+// Initialize the link table entry at the given index to the starting value
+// of WDTBL_SIZE
+
+static void InitializeLink(int linkIndex)
+{
+  for (int j=0;j<2;j++)
+  {
+    for (int k=0;k<4;k++)
+    {
+      WDLNK[linkIndex][j][k] = WDTBL_SIZE;
+    }
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  WDHASH lookups. FindPattern returns the WDPTN index of a pattern, or -1
+//  if it isn't there. AddPattern indexes the pattern at the given WDPTN
+//  index.
+
+static inline int WDHashSlot(u64 pattern)
+{
+  return (int)((pattern * 0x9E3779B97F4A7C15ULL) >> 48);
+}
+
+static int FindPattern(u64 pattern)
+{
+  int slot = WDHashSlot(pattern);
+
+  while (WDHASH[slot] >= 0 && WDPTN[WDHASH[slot]] != pattern)
+  {
+    slot = (slot + 1) & (WDHASH_SIZE-1);
+  }
+
+  return WDHASH[slot];
+}
+
+static void AddPattern(int tableIndex)
+{
+  int slot = WDHashSlot(WDPTN[tableIndex]);
+
+  while (WDHASH[slot] >= 0)
+  {
+    slot = (slot + 1) & (WDHASH_SIZE-1);
+  }
+
+  WDHASH[slot] = (short)tableIndex;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// 
+//  Given a tile index and a space index, explore all the possible swaps
+//  between those and record valid states into the lookup tables.
+
+static void SwapAndWrite(int tileIndex, int spaceIndex, int walkingDistance, int direction)
+{
+  u64 packedTable;
+  int tableIndex;
+
+  for (int group=0; group<4; group++)
+  {
+    // Check if there's even a tile of the appropriate class to swap with
+    if (TABLE[tileIndex][group])
+    {
+      // Swap that tile with the space
+      TABLE[tileIndex][group]--;
+      TABLE[spaceIndex][group]++;
+
+      packedTable = PackTable();
+
+      // Examine the WDPTN table to see if this TABLE configuration is already
+      // represented.
+      tableIndex = FindPattern(packedTable);
+
+      // If it isn't, add it to the end of the table.
+      if (tableIndex < 0)
+      {
+        tableIndex = WDEND;
+        WDPTN[WDEND] = packedTable; // Representing a TABLE configuration.
+        WDTBL[WDEND] = walkingDistance; // The Walking Distance for this TABLE configuration.
+        AddPattern(WDEND);
+        WDEND++;
+
+        // When a new entry is added, we also initialize the corresponding
+        // transition lookup entry for this TABLE configuration.
+        InitializeLink(tableIndex);
+      }
+
+      // Fill in the transition lookup table entry for transition between the
+      // currently examined node (WDTOP-1) and this new node. First fill in 
+      // the given direction, then flip the direction with the ^ (XOR) operator
+      // and fill in the other way.
+      WDLNK[WDTOP - 1 ][direction  ][group] = (short)tableIndex;
+      WDLNK[tableIndex][direction^1][group] = (short)WDTOP-1; 
+
+      // Revert the swap so we can look at the next candidate.
+      TABLE[tileIndex][group]++;
+      TABLE[spaceIndex][group]--;
+    }
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+// Breadth-first walk through the Walking Distance space to generate all the
+// lookup data used in the heuristic search later on.
+
+static void GenerateWalkingDistanceLookup()
+{
+  int i,j,k,space=0,piece;
+  char walkingDistance;
+  u64 packedTable;
+
+  // The breadth-first search begins with the solved puzzle state and expands
+  // from there to the full Walking Distance table configurations.
+
+  // Create TABLE representing the solved state. 
+  // First initialize to zero.
+  for (i=0; i<4; i++)
+  {
+    for (j=0; j<4; j++)
+    {
+      TABLE[i][j] = 0;
+    }
+  }
+  // Then fill in the diagonals representing tiles in their proper places.
+  TABLE[0][0] = TABLE[1][1] = TABLE[2][2] = 4; // 4 tiles in correct row positions
+  TABLE[3][3] = 3; // 3 tiles in correct row position for final row.
+
+  // The solved state and its representation sits at the beginning of the
+  // Walking Distance lookup table.
+  WDPTN[0] = PackTable(); // Representing the solved TABLE configuration
+  WDTBL[0] = 0;           // Solved state has walking distance of zero.
+  memset(WDHASH, -1, sizeof(WDHASH));
+  AddPattern(0);
+
+  // Initialize the transition lookup entry for the solved state.
+  InitializeLink(0);
+
+  // With the start state initialized to the solved configuration, it is
+  // time to explore all the possible changes from that point.
+  WDTOP=0; // Index of the node currently being expanded (the solved state)
+  WDEND=1; // End of the open list where we append new nodes.
+  while (WDTOP < WDEND)
+  {
+    // Retrieve the TABLE representation pattern and the Walking Distance
+    // count for the node to be expanded.
+    packedTable = WDPTN[WDTOP];
+    walkingDistance = WDTBL[WDTOP] + 1;
+    WDTOP++;
+
+    // Unpack the representation back into the TABLE array so we can 
+    // use it to explore valid states.
+    for (i=3; i>=0; i--)
+    {
+      piece = 0; // This tracks the number of tile pieces on this row
+      for (j=3; j>=0; j--)
+      {
+        TABLE[i][j] = (int)(packedTable&7);
+        packedTable >>= 3;
+        piece += TABLE[i][j];
+      }
+      if (piece==3)
+      {
+        // Only three tiles live on this row - so the blank space is here.
+        space = i;
+      }
+    }
+
+    // If the space is not on the bottom-most row, explore the states that
+    // involve moving a tile up into the space.
+    if ((piece = space + 1) < 4)
+    {
+      SwapAndWrite(piece, space, walkingDistance, 0);
+    }
+
+    // If the space is not on the top-most row, explore the states that
+    // involve moving a tile down into the space.
+    if ((piece = space - 1) >= 0)
+    {
+      SwapAndWrite(piece, space, walkingDistance, 1);
+    }
+  }
+
+  ///////////////////////////////////////////////////////////////////////////
+
+  // The inversion count table maps the count of inversion along an axis (i)
+  // to the minimum number of moves that would be needed to fix the inversion
+  // so the tiles are in order.
+  for (i=0; i<IDTBL_SIZE; i++)
+  {
+    IDTBL[i] = (char)((i/3) + (i%3));
+  }
+
+  // Inversion count changes for each moved tile and the tiles it skips.
+  for (i=0; i<WD_SIZE; i++)
+  {
+    for (j=0; j<(1 << 12); j++)
+    {
+      int delta = 0;
+
+      for (k=0; k<3; k++)
+      {
+        delta += (((j >> (k*4)) & 0xF) > i) ? 1 : -1;
+      }
+      INVDELTA[i][j] = (signed char)delta;
+    }
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Calculates the inversion count used for lookup into the inversion distance
+//  heuristic. Can flip the axis of calculation via flipAxis parameter.
+
+static int InversionCount(int* puzzle, int flipAxis)
+{
+  int inversionCount = 0;
+  int currentTile;
+  unsigned int seen = 0;  // Tiles already passed, walking from the end.
+
+  // Each tile is inverted with the lower numbered tiles after it, which is
+  // a popcount of the tiles seen so far below it. The blank is never added
+  // to seen, so it is skipped on both counts.
+  for (int i = WD_SIZE-1; i >= 0; i--)
+  {
+    currentTile = flipAxis ? CONV[puzzle[CONVP[i]]] : puzzle[i];
+
+    if (currentTile) // Skip blank
+    {
+      inversionCount += __builtin_popcount(seen & ((1u << currentTile) - 1));
+      seen |= 1u << currentTile;
+    }
+  }
+
+  return inversionCount;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Given the full set of indices, calculate the lower bound value to use
+//  as heuristic for the IDA* search.
+
+static int HeuristicValue(int idxV, int idxH, int invV, int invH)
+{
+  int wdV = WDTBL[idxV]; // Walking Distance for vertical tile movements.
+  int wdH = WDTBL[idxH]; // Walking Distance for horizontal tile movements.
+  int idV = IDTBL[invV]; // Inversion Distance for vertical tile movements.
+  int idH = IDTBL[invH]; // Inversion Distance for horizontal tile movements.
+  int lowbV = (wdV>idV)? wdV:idV; // Maximum of WD or ID is the lower bound.
+  int lowbH = (wdH>idH)? wdH:idH; // Maximum of WD or ID is the lower bound.
+
+  return lowbV + lowbH;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  The full set of Walking Distance calculations. This is required for the
+//  initial state of the search. After startup, as we search the problem tree,
+//  the WDLNK array can take care of updating the walking distance from step
+//  to step with far less computation involved.
+//
+//  Debug note: If we suspect the WDLNK update mechanism is broken, we can 
+//  fall back to performing this full calculation. But it is not recommended,
+//  it is extremely computationally expensive to do this for each tree node.
+
+static int HeuristicLookupIndices(int* puzzle, int *pidx1, int *pidx2, int *pinv1, int *pinv2)
+{
+  int idx1, idx2, inv1, inv2;
+  u64 packedPuzzle;
+
+  // Calculate IDX1 - index into the Walking Distance table corresponding to
+  // the minimum number of tile movements across rows. (Vertical tile moves.)
+  packedPuzzle = PackPuzzle(puzzle, 0);
+
+  // Look for index of the WDPTN entry corresponding to this pattern.
+  idx1 = FindPattern(packedPuzzle);
+
+  // Calculate IDX2 - repeat the calculation made for IDX1, but this time
+  // for movement across columns. (Horizontal tile moves.) 
+  packedPuzzle = PackPuzzle(puzzle, 1);
+
+  // Look for index of the WDPTN entry corresponding to this pattern.
+  idx2 = FindPattern(packedPuzzle);
+
+  // Calculate inv1 - the number of tile inversions along the horizontal axis
+  inv1 = InversionCount(puzzle, 0);
+
+  // Calculate inv1 - the number of tile inversions along the vertical axis
+  inv2 = InversionCount(puzzle, 1);
+
+  // Copy values to outparams.
+  *pidx1 = idx1;
+  *pidx2 = idx2;
+  *pinv1 = inv1;
+  *pinv2 = inv2;
+
+  return HeuristicValue(idx1, idx2, inv1, inv2);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  One move of the blank on an array board, direction 0 to 3 for up, down,
+//  left and right. Updates the Walking Distance indices and inversion
+//  counts for the move through WDLNK, without repacking the board, and
+//  returns the blank's new position, or -1 if it would leave the board.
+//  The board itself is left for the caller to change.
+
+static inline int WalkingDistanceMove(const int puzzle[WD_SIZE], int blank, int direction,
+  int *idx1, int *idx2, int *inv1, int *inv2)
+{
+  int child, tile, j;
+
+  if (direction == 0)
+  {
+    // Blank up: the tile above slides down past the tiles between them.
+    if (blank < BOARD_WIDTH)
+    {
+      return -1;
+    }
+    child = blank - BOARD_WIDTH;
+    tile = puzzle[child];
+    for (j = child+1; j < blank; j++)
+    {
+      *inv1 += (puzzle[j] > tile) ? 1 : -1;
+    }
+    *idx1 = WDLNK[*idx1][1][(tile-1)>>2];
+  }
+  else if (direction == 1)
+  {
+    // Blank down: the tile below slides up past them.
+    if (blank >= WD_SIZE - BOARD_WIDTH)
+    {
+      return -1;
+    }
+    child = blank + BOARD_WIDTH;
+    tile = puzzle[child];
+    for (j = blank+1; j < child; j++)
+    {
+      *inv1 += (puzzle[j] > tile) ? -1 : 1;
+    }
+    *idx1 = WDLNK[*idx1][0][(tile-1)>>2];
+  }
+  else if (direction == 2)
+  {
+    // Blank left: the same thing across the axis flip, where the tiles
+    // skipped are the rest of the two columns.
+    if (blank % BOARD_WIDTH == 0)
+    {
+      return -1;
+    }
+    child = blank - 1;
+    tile = CONV[puzzle[child]];
+    for (j = child + BOARD_WIDTH; j < WD_SIZE; j += BOARD_WIDTH)
+    {
+      *inv2 += (CONV[puzzle[j]] > tile) ? 1 : -1;
+    }
+    for (j = blank - BOARD_WIDTH; j >= 0; j -= BOARD_WIDTH)
+    {
+      *inv2 += (CONV[puzzle[j]] > tile) ? 1 : -1;
+    }
+    *idx2 = WDLNK[*idx2][1][(tile-1)>>2];
+  }
+  else
+  {
+    // Blank right.
+    if (blank % BOARD_WIDTH == BOARD_WIDTH-1)
+    {
+      return -1;
+    }
+    child = blank + 1;
+    tile = CONV[puzzle[child]];
+    for (j = blank + BOARD_WIDTH; j < WD_SIZE; j += BOARD_WIDTH)
+    {
+      *inv2 += (CONV[puzzle[j]] > tile) ? -1 : 1;
+    }
+    for (j = child - BOARD_WIDTH; j >= 0; j -= BOARD_WIDTH)
+    {
+      *inv2 += (CONV[puzzle[j]] > tile) ? -1 : 1;
+    }
+    *idx2 = WDLNK[*idx2][0][(tile-1)>>2];
+  }
+
+  return child;
+}
+
+#endif // WALK_DIST_H